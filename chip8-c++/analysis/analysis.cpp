@@ -0,0 +1,288 @@
+// the analysis declarations implemented in this file.
+#include<analysis.hpp>
+
+// gives the std::sort and std::lower_bound functions.
+#include<algorithm>
+
+// gives the std::snprintf function used to format instructions.
+#include<cstdio>
+
+/// how control can leave an instruction.
+enum class Flow : uint8_t {
+    /// goes on to the next instruction.
+    Next,
+    /// 1NNN, goes to NNN.
+    Jump,
+    /// 2NNN, goes to NNN and comes back to the next instruction.
+    Call,
+    /// a conditional skip, goes to the next or the one after.
+    Skip,
+    /// 00EE, goes back to the caller.
+    Return,
+    /// BNNN, goes somewhere that depends on v0.
+    Computed,
+    /// doesn't exist, the core traps.
+    Invalid,
+};
+
+/// @brief works out how control leaves an instruction, following the decoding of `Core::run_for_instruction`.
+static Flow instruction_flow(uint16_t instruction) {
+    const uint8_t n = instruction & 0x000f;
+    const uint8_t nn = instruction & 0x00ff;
+    switch (instruction >> 12) {
+    case 0x0:
+        if (instruction == 0x00e0) return Flow::Next;
+        if (instruction == 0x00ee) return Flow::Return;
+        return Flow::Invalid;
+    case 0x1: return Flow::Jump;
+    case 0x2: return Flow::Call;
+    case 0x3: case 0x4: case 0x5: case 0x9: return Flow::Skip;
+    case 0x8: return n <= 0x7 || n == 0xe ? Flow::Next : Flow::Invalid;
+    case 0xb: return Flow::Computed;
+    case 0xe: return nn == 0x9e || nn == 0xa1 ? Flow::Skip : Flow::Invalid;
+    case 0xf:
+        switch (nn) {
+        case 0x07: case 0x0a: case 0x15: case 0x18: case 0x1e: case 0x29: case 0x33: case 0x55: case 0x65: return Flow::Next;
+        default: return Flow::Invalid;
+        }
+    default: return Flow::Next;
+    }
+}
+
+/// @brief whether the instruction ends a basic block.
+static bool ends_block(Flow flow) {
+    return flow != Flow::Next;
+}
+
+/// the memory of a core right after `Core::create`, the font at 0 and the ROM at 0x200.
+struct Image {
+    std::array<uint8_t, 0x1000> memory;
+
+    /// @brief reads the instruction word at `address`, wrapping like the core's pc.
+    uint16_t instruction(uint16_t address) const {
+        return (this->memory[address & 0x0fff] << 8) | this->memory[(address + 1) & 0x0fff];
+    }
+};
+
+RomAnalysis analyze_rom(const char rom[], size_t rom_length) {
+    RomAnalysis analysis;
+    analysis.rom_hash = fnv1a_hash(rom, rom_length);
+    const Core core = Core::create(rom, rom_length);
+    const Image image = { core.memory() };
+    auto& flags = analysis.flags;
+
+    // discovers the reachable instructions, following every edge from the entry point.
+    std::vector<uint16_t> worklist = { 0x200 };
+    flags[0x200] |= ADDRESS_FUNCTION;
+    while (!worklist.empty()) {
+        uint16_t address = worklist.back();
+        worklist.pop_back();
+        while (!(flags[address] & ADDRESS_INSTRUCTION)) {
+            const uint16_t instruction = image.instruction(address);
+            const Flow flow = instruction_flow(instruction);
+            const uint16_t next = (address + 2) & 0x0fff;
+            const uint16_t target = instruction & 0x0fff;
+            flags[address] |= ADDRESS_INSTRUCTION | ADDRESS_CODE;
+            flags[(address + 1) & 0x0fff] |= ADDRESS_CODE;
+            if (flow == Flow::Invalid) {
+                flags[address] |= ADDRESS_INVALID;
+                break;
+            }
+            if (flow == Flow::Jump || flow == Flow::Call) {
+                flags[target] |= flow == Flow::Jump ? ADDRESS_JUMP_TARGET : ADDRESS_FUNCTION;
+                worklist.push_back(target);
+            }
+            if (flow == Flow::Skip) {
+                const uint16_t skipped = (address + 4) & 0x0fff;
+                flags[next] |= ADDRESS_JUMP_TARGET;
+                flags[skipped] |= ADDRESS_JUMP_TARGET;
+                worklist.push_back(skipped);
+            }
+            if (flow == Flow::Computed) {
+                flags[address] |= ADDRESS_COMPUTED_JUMP;
+                analysis.computed_jumps.push_back(address);
+            }
+            if (flow == Flow::Jump || flow == Flow::Return || flow == Flow::Computed) {
+                break;
+            }
+            address = next;
+        }
+    }
+    std::sort(analysis.computed_jumps.begin(), analysis.computed_jumps.end());
+
+    // splits the instructions into blocks, a block starts at every target and after every block ending instruction.
+    std::vector<bool> leader(0x1000, false);
+    for (size_t address = 0; address < 0x1000; ++address) {
+        if (!(flags[address] & ADDRESS_INSTRUCTION)) continue;
+        if (flags[address] & (ADDRESS_JUMP_TARGET | ADDRESS_FUNCTION)) leader[address] = true;
+        if (ends_block(instruction_flow(image.instruction(address)))) leader[(address + 2) & 0x0fff] = true;
+    }
+    for (size_t start = 0; start < 0x1000; ++start) {
+        if (!leader[start] || !(flags[start] & ADDRESS_INSTRUCTION)) continue;
+        BasicBlock block = { uint16_t(start), uint16_t(start), {} };
+        uint16_t address = start;
+        // tracks the i register while it's known from an ANNN, to find writes into code.
+        int32_t known_i = -1;
+        while (true) {
+            const uint16_t instruction = image.instruction(address);
+            const Flow flow = instruction_flow(instruction);
+            const uint16_t next = (address + 2) & 0x0fff;
+            if ((instruction & 0xf000) == 0xa000) {
+                known_i = instruction & 0x0fff;
+            } else if ((instruction & 0xf0ff) == 0xf01e || (instruction & 0xf0ff) == 0xf029) {
+                known_i = -1;
+            } else if (known_i >= 0 && ((instruction & 0xf0ff) == 0xf033 || (instruction & 0xf0ff) == 0xf055)) {
+                const uint32_t length = (instruction & 0xf0ff) == 0xf033 ? 3 : ((instruction >> 8) & 0xf) + 1;
+                for (uint32_t offset = 0; offset < length && known_i + offset < 0x1000; ++offset) {
+                    if (flags[known_i + offset] & ADDRESS_CODE) {
+                        flags[address] |= ADDRESS_SELF_MODIFYING;
+                        analysis.self_modifying_writes.push_back(address);
+                        break;
+                    }
+                }
+            }
+            switch (flow) {
+            case Flow::Jump: block.successors.push_back(instruction & 0x0fff); break;
+            case Flow::Call: block.successors.push_back(next); break;
+            case Flow::Skip: block.successors.push_back(next); block.successors.push_back((address + 4) & 0x0fff); break;
+            case Flow::Next: if (leader[next]) block.successors.push_back(next); break;
+            default:;
+            }
+            address = next;
+            if (ends_block(flow) || leader[address] || !(flags[address] & ADDRESS_INSTRUCTION)) break;
+        }
+        block.end = address;
+        // a block running off into bytes that were never reached would be a bug in the discovery above.
+        block.successors.erase(std::remove_if(block.successors.begin(), block.successors.end(), [&](uint16_t successor) {
+            return !(flags[successor] & ADDRESS_INSTRUCTION);
+        }), block.successors.end());
+        analysis.blocks.push_back(block);
+    }
+
+    // gathers the blocks of every function and finds the loops with a depth first search, a successor that is
+    // still on the search stack is a jump back into a running loop.
+    for (size_t address = 0; address < 0x1000; ++address) {
+        if (!(flags[address] & ADDRESS_FUNCTION) || !(flags[address] & ADDRESS_INSTRUCTION)) continue;
+        Function function = { uint16_t(address), {}, {} };
+        std::vector<uint8_t> state(0x1000, 0); // 0 unvisited, 1 on the stack, 2 done.
+        std::vector<std::pair<uint16_t, size_t>> stack = { { uint16_t(address), 0 } };
+        state[address] = 1;
+        while (!stack.empty()) {
+            const BasicBlock* block = analysis.block_at(stack.back().first);
+            if (block == nullptr || stack.back().second >= block->successors.size()) {
+                if (block != nullptr) {
+                    function.blocks.push_back(block->start);
+                    const uint16_t last = (block->end - 2) & 0x0fff;
+                    const uint16_t instruction = image.instruction(last);
+                    if (instruction_flow(instruction) == Flow::Call) function.calls.push_back(instruction & 0x0fff);
+                }
+                state[stack.back().first] = 2;
+                stack.pop_back();
+                continue;
+            }
+            const uint16_t successor = block->successors[stack.back().second++];
+            if (state[successor] == 1) {
+                if (std::none_of(analysis.loops.begin(), analysis.loops.end(), [&](const Loop& loop) {
+                    return loop.header == successor && loop.latch == block->start;
+                })) {
+                    analysis.loops.push_back({ successor, block->start });
+                }
+                flags[successor] |= ADDRESS_LOOP_HEADER;
+            } else if (state[successor] == 0) {
+                state[successor] = 1;
+                stack.push_back({ successor, 0 });
+            }
+        }
+        std::sort(function.blocks.begin(), function.blocks.end());
+        std::sort(function.calls.begin(), function.calls.end());
+        function.calls.erase(std::unique(function.calls.begin(), function.calls.end()), function.calls.end());
+        analysis.functions.push_back(function);
+    }
+    std::sort(analysis.loops.begin(), analysis.loops.end(), [](const Loop& a, const Loop& b) {
+        return a.header != b.header ? a.header < b.header : a.latch < b.latch;
+    });
+    // the entry point goes first, the rest stay sorted by address.
+    std::stable_partition(analysis.functions.begin(), analysis.functions.end(), [](const Function& function) {
+        return function.entry == 0x200;
+    });
+    return analysis;
+}
+
+const BasicBlock* RomAnalysis::block_at(uint16_t address) const {
+    auto block = std::lower_bound(this->blocks.begin(), this->blocks.end(), address, [](const BasicBlock& block, uint16_t address) {
+        return block.start < address;
+    });
+    return block != this->blocks.end() && block->start == address ? &*block : nullptr;
+}
+
+std::string disassemble_instruction(uint16_t instruction) {
+    const unsigned nnn = instruction & 0x0fff, nn = instruction & 0x00ff, n = instruction & 0x000f;
+    const unsigned x = (instruction >> 8) & 0xf, y = (instruction >> 4) & 0xf;
+    char text[32];
+    switch (instruction >> 12) {
+    case 0x0:
+        if (instruction == 0x00e0) return "CLS";
+        if (instruction == 0x00ee) return "RET";
+        std::snprintf(text, sizeof(text), "SYS 0x%03x", nnn);
+        break;
+    case 0x1: std::snprintf(text, sizeof(text), "JP 0x%03x", nnn); break;
+    case 0x2: std::snprintf(text, sizeof(text), "CALL 0x%03x", nnn); break;
+    case 0x3: std::snprintf(text, sizeof(text), "SE V%X, 0x%02x", x, nn); break;
+    case 0x4: std::snprintf(text, sizeof(text), "SNE V%X, 0x%02x", x, nn); break;
+    case 0x5: std::snprintf(text, sizeof(text), "SE V%X, V%X", x, y); break;
+    case 0x6: std::snprintf(text, sizeof(text), "LD V%X, 0x%02x", x, nn); break;
+    case 0x7: std::snprintf(text, sizeof(text), "ADD V%X, 0x%02x", x, nn); break;
+    case 0x8: {
+        static const char* OPERATIONS[16] = { "LD", "OR", "AND", "XOR", "ADD", "SUB", "SHR", "SUBN", 0, 0, 0, 0, 0, 0, "SHL", 0 };
+        if (OPERATIONS[n] == nullptr) return "???";
+        std::snprintf(text, sizeof(text), "%s V%X, V%X", OPERATIONS[n], x, y);
+    } break;
+    case 0x9: std::snprintf(text, sizeof(text), "SNE V%X, V%X", x, y); break;
+    case 0xa: std::snprintf(text, sizeof(text), "LD I, 0x%03x", nnn); break;
+    case 0xb: std::snprintf(text, sizeof(text), "JP V0, 0x%03x", nnn); break;
+    case 0xc: std::snprintf(text, sizeof(text), "RND V%X, 0x%02x", x, nn); break;
+    case 0xd: std::snprintf(text, sizeof(text), "DRW V%X, V%X, %u", x, y, n); break;
+    case 0xe:
+        if (nn == 0x9e) std::snprintf(text, sizeof(text), "SKP V%X", x);
+        else if (nn == 0xa1) std::snprintf(text, sizeof(text), "SKNP V%X", x);
+        else return "???";
+        break;
+    default:
+        switch (nn) {
+        case 0x07: std::snprintf(text, sizeof(text), "LD V%X, DT", x); break;
+        case 0x0a: std::snprintf(text, sizeof(text), "LD V%X, K", x); break;
+        case 0x15: std::snprintf(text, sizeof(text), "LD DT, V%X", x); break;
+        case 0x18: std::snprintf(text, sizeof(text), "LD ST, V%X", x); break;
+        case 0x1e: std::snprintf(text, sizeof(text), "ADD I, V%X", x); break;
+        case 0x29: std::snprintf(text, sizeof(text), "LD F, V%X", x); break;
+        case 0x33: std::snprintf(text, sizeof(text), "LD B, V%X", x); break;
+        case 0x55: std::snprintf(text, sizeof(text), "LD [I], V%X", x); break;
+        case 0x65: std::snprintf(text, sizeof(text), "LD V%X, [I]", x); break;
+        default: return "???";
+        }
+    }
+    return text;
+}
+
+std::shared_ptr<const RomAnalysis> AnalysisCache::get(const char rom[], size_t rom_length) {
+    const uint64_t hash = fnv1a_hash(rom, rom_length);
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        auto found = this->analyses.find(hash);
+        if (found != this->analyses.end()) return found->second;
+    }
+    // analyzes outside of the lock, two threads analyzing the same ROM at once both get the same result.
+    auto analysis = std::make_shared<const RomAnalysis>(analyze_rom(rom, rom_length));
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->analyses.emplace(hash, analysis).first->second;
+}
+
+size_t AnalysisCache::size() const {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->analyses.size();
+}
+
+void AnalysisCache::clear() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->analyses.clear();
+}
@@ -0,0 +1,130 @@
+// no duplicate includes.
+#pragma once
+
+// the core, for the memory layout and the ROM hash.
+#include<core.hpp>
+
+// gives the std::vector type used for the blocks, functions and flagged addresses.
+#include<vector>
+
+// gives the std::string type for disassembled instructions.
+#include<string>
+
+// gives the std::shared_ptr type the cache hands out.
+#include<memory>
+
+// gives the std::mutex type guarding the cache.
+#include<mutex>
+
+// gives the std::unordered_map type the cache is stored in.
+#include<unordered_map>
+
+/// what the analysis found out about a byte of memory, a bitmask as a byte can be several of these at once.
+enum AddressFlags : uint8_t {
+    /// the byte is part of a reachable instruction, bytes without it are treated as data.
+    ADDRESS_CODE = 1 << 0,
+    /// a reachable instruction starts at the byte.
+    ADDRESS_INSTRUCTION = 1 << 1,
+    /// a 1NNN jump or a skip lands on the byte.
+    ADDRESS_JUMP_TARGET = 1 << 2,
+    /// a 2NNN call lands on the byte, or it's the entry point.
+    ADDRESS_FUNCTION = 1 << 3,
+    /// a loop starts at the byte, some jump goes back to it.
+    ADDRESS_LOOP_HEADER = 1 << 4,
+    /// the instruction at the byte is a BNNN jump, whose target isn't known before running.
+    ADDRESS_COMPUTED_JUMP = 1 << 5,
+    /// the instruction at the byte writes into code.
+    ADDRESS_SELF_MODIFYING = 1 << 6,
+    /// the instruction at the byte doesn't exist in the CHIP-8 spec, running it traps.
+    ADDRESS_INVALID = 1 << 7,
+};
+
+/// a run of instructions that is only ever entered at the start and left at the end.
+struct BasicBlock {
+    /// the address of the first instruction.
+    uint16_t start;
+    /// the address right after the last instruction.
+    uint16_t end;
+    /// the blocks control can go to next, by address. Calls aren't included, they return to the next block.
+    std::vector<uint16_t> successors;
+};
+
+/// a subroutine, everything reachable from a 2NNN target (or the entry point) without following calls.
+struct Function {
+    /// the address of the first instruction.
+    uint16_t entry;
+    /// the start addresses of the blocks in the function, sorted.
+    std::vector<uint16_t> blocks;
+    /// the functions it calls, by entry address.
+    std::vector<uint16_t> calls;
+};
+
+/// a loop, found from a jump going back to an instruction that is still being executed.
+struct Loop {
+    /// the first instruction of the loop, where the jump back lands.
+    uint16_t header;
+    /// the start of the block that jumps back.
+    uint16_t latch;
+};
+
+/// everything known about a ROM before running it.
+///
+/// The ROM is disassembled by following control flow from 0x200, instead of going through it linearly, which
+/// separates the code from the sprites and other data mixed into it. Jumps and calls are followed to their
+/// targets and skips to both of the following instructions. A BNNN jump depends on v0, so where it goes is
+/// unknown, and code only reachable through it is missed. Those jumps are flagged, as are writes whose
+/// address is known from an earlier ANNN in the same block and that land in code, which make the
+/// disassembly unreliable past them.
+struct RomAnalysis {
+    /// the `fnv1a_hash` of the ROM.
+    uint64_t rom_hash = 0;
+    /// the `AddressFlags` of every byte of memory.
+    std::array<uint8_t, 0x1000> flags = {};
+    /// the basic blocks, sorted by address.
+    std::vector<BasicBlock> blocks;
+    /// the functions, sorted by address, the first being the entry point.
+    std::vector<Function> functions;
+    /// the loops, sorted by header.
+    std::vector<Loop> loops;
+    /// the addresses of the BNNN jumps.
+    std::vector<uint16_t> computed_jumps;
+    /// the addresses of the instructions writing into code.
+    std::vector<uint16_t> self_modifying_writes;
+
+    /// whether `flags` has all of `mask` set at `address`.
+    bool has(uint16_t address, uint8_t mask) const {
+        return (this->flags[address & 0x0fff] & mask) == mask;
+    }
+
+    /// @brief finds the block starting at `address`.
+    /// @return the block, or `nullptr` if no block starts there
+    const BasicBlock* block_at(uint16_t address) const;
+};
+
+/// @brief analyzes a ROM, see `RomAnalysis`.
+/// @param rom the ROM bytes, loaded at address 512 (0x200)
+/// @param rom_length the length of `rom` in bytes
+RomAnalysis analyze_rom(const char rom[], size_t rom_length);
+
+/// @brief disassembles an instruction, like "LD V1, 0x2a".
+/// @param instruction the instruction word
+std::string disassemble_instruction(uint16_t instruction);
+
+/// analyses of every ROM seen so far, keyed by the ROM hash, so a ROM run many times (in a batch, or by
+/// several cores) is only analyzed once. Safe to use from several threads.
+struct AnalysisCache {
+    /// @brief gets the analysis of a ROM, analyzing it if it wasn't analyzed before.
+    /// @return the analysis, which stays valid for as long as it's held, even if the cache is cleared
+    std::shared_ptr<const RomAnalysis> get(const char rom[], size_t rom_length);
+
+    /// the amount of ROMs analyzed.
+    size_t size() const;
+
+    /// drops every analysis.
+    void clear();
+private:
+    /// guards `analyses`.
+    mutable std::mutex mutex;
+    /// the analyses, by ROM hash.
+    std::unordered_map<uint64_t, std::shared_ptr<const RomAnalysis>> analyses;
+};
@@ -0,0 +1,170 @@
+// the batch declarations implemented in this file.
+#include<batch.hpp>
+
+// gives the threads and atomics used to spread jobs over threads.
+#include<thread>
+#include<atomic>
+
+// gives the string streams used to parse scripts.
+#include<sstream>
+
+// gives the std::max function.
+#include<algorithm>
+
+// works out what a blocked core waits for.
+#include<scheduler.hpp>
+
+bool parse_input_script(const std::string& script, BatchJob& job) {
+    std::istringstream lines(script);
+    std::string line;
+    std::vector<InputEvent> inputs;
+    while (std::getline(lines, line)) {
+        std::istringstream words(line);
+        std::string first;
+        if (!(words >> first) || first[0] == '#') {
+            continue; // empty line or comment.
+        }
+        if (first == "frames") {
+            if (!(words >> job.frames)) return false;
+        } else if (first == "checkpoint") {
+            if (!(words >> job.checkpoint_interval) || job.checkpoint_interval == 0) return false;
+        } else if (first == "instructions") {
+            if (!(words >> job.instructions_per_frame)) return false;
+        } else if (first == "seed") {
+            if (!(words >> job.seed)) return false;
+        } else {
+            InputEvent event;
+            uint32_t bitmap;
+            try {
+                event.frame = std::stoul(first);
+            } catch (...) {
+                return false;
+            }
+            if (!(words >> std::hex >> bitmap) || bitmap > UINT16_MAX) return false;
+            if (!inputs.empty() && inputs.back().frame > event.frame) return false;
+            event.hexpad_bitmap = bitmap;
+            inputs.push_back(event);
+        }
+    }
+    job.inputs = std::move(inputs);
+    return true;
+}
+
+/// @brief checks whether a job can run at all.
+static std::string validate_job(const BatchJob& job) {
+    if (job.rom.size() > 4096 - 512) return "ROM is too large to be loaded";
+    if (job.checkpoint_interval == 0) return "checkpoint interval must be above zero";
+    return "";
+}
+
+/// @brief runs `job` on `core` from `from` frames to `to` frames, calling `on_frame` with the amount of frames run after each. Stops early if it returns `false`.
+/// @brief a core that can't run is skipped ahead to the frame it can run again in (the next input for a core waiting for
+/// @brief a keypress, the end of its sleep for a sleeping one), the same as `CoreScheduler` does for many cores at once.
+/// @brief the frames in between still get `on_frame`, the framebuffer doesn't change in them. `on_ran` is only called
+/// @brief after the frames the core actually ran, as the core is behind on its timers during the skipped ones.
+template<typename F, typename R>
+static void run_frames(const BatchJob& job, Core& core, uint32_t from, uint32_t to, F on_frame, R on_ran) {
+    size_t next_event = 0;
+    uint16_t bitmap = 0;
+    // the input held when the core left off.
+    while (next_event < job.inputs.size() && job.inputs[next_event].frame < from) {
+        bitmap = job.inputs[next_event++].hexpad_bitmap;
+    }
+    for (uint32_t frame = from; frame < to; ++frame) {
+        while (next_event < job.inputs.size() && job.inputs[next_event].frame <= frame) {
+            bitmap = job.inputs[next_event++].hexpad_bitmap;
+        }
+        core.run_frame(bitmap, job.instructions_per_frame);
+        if (!on_frame(frame + 1)) break;
+        on_ran(frame + 1);
+
+        uint32_t wake = frame + 1;
+        switch (core_wait(core)) {
+        case CoreWait::None: continue;
+        case CoreWait::Keypress: wake = next_event < job.inputs.size() ? job.inputs[next_event].frame : to; break;
+        case CoreWait::Timer: wake = frame + 1 + core.sleep_frames(); break;
+        case CoreWait::Forever: wake = to; break;
+        }
+        wake = std::min(wake, to);
+        for (uint32_t idle = frame + 1; idle < wake; ++idle) {
+            if (!on_frame(idle + 1)) return;
+        }
+        core.idle_frames(wake - frame - 1, job.instructions_per_frame);
+        frame = wake - 1;
+    }
+}
+
+BatchResult run_job(const BatchJob& job) {
+    Core core = Core::create(nullptr, 0);
+    return run_job(job, core);
+}
+
+BatchResult run_job(const BatchJob& job, Core& core) {
+    BatchResult result;
+    continue_job(job, core, 0, result, nullptr);
+    return result;
+}
+
+void continue_job(const BatchJob& job, Core& core, uint32_t frames_run, BatchResult& result,
+    const std::function<void(uint32_t)>& on_frame) {
+    result.error = validate_job(job);
+    if (!result.error.empty()) {
+        return;
+    }
+    if (frames_run == 0) {
+        core.reset(job.rom.data(), job.rom.size(), job.seed);
+    }
+    run_frames(job, core, frames_run, job.frames, [&](uint32_t frames) {
+        if (frames % job.checkpoint_interval == 0 || frames == job.frames) {
+            result.checkpoints.push_back({ frames, framebuffer_hash(core.framebuffer()) });
+        }
+        // a trapped or halted core never changes its framebuffer again, so the remaining checkpoints are filled in without running.
+        if (core.trap() != CoreTrap::None || core.halted()) {
+            result.halted_frame = frames;
+            const uint64_t hash = framebuffer_hash(core.framebuffer());
+            uint32_t next = (frames / job.checkpoint_interval + 1) * job.checkpoint_interval;
+            for (; next < job.frames; next += job.checkpoint_interval) {
+                result.checkpoints.push_back({ next, hash });
+            }
+            if (frames != job.frames) result.checkpoints.push_back({ job.frames, hash });
+            return false;
+        }
+        return true;
+    }, [&](uint32_t frames) {
+        if (on_frame) on_frame(frames);
+    });
+    result.trap = core.trap();
+    result.trap_pc = core.trap_pc();
+    result.halted = core.halted();
+}
+
+Core replay_job(const BatchJob& job, uint32_t frames) {
+    assert(validate_job(job).empty());
+    Core core = Core::create(job.rom.data(), job.rom.size(), job.seed);
+    run_frames(job, core, 0, frames, [&](uint32_t) { return core.trap() == CoreTrap::None; }, [](uint32_t) {});
+    return core;
+}
+
+std::vector<BatchResult> run_batch(const std::vector<BatchJob>& jobs, size_t threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    std::vector<BatchResult> results(jobs.size());
+    // every thread takes the next job that hasn't been taken, so threads that get short jobs simply take more of them.
+    std::atomic<size_t> next_job { 0 };
+    auto worker = [&]() {
+        Core core = Core::create(nullptr, 0);
+        for (size_t job = next_job++; job < jobs.size(); job = next_job++) {
+            results[job] = run_job(jobs[job], core);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (size_t thread = 1; thread < threads; ++thread) {
+        pool.emplace_back(worker);
+    }
+    worker(); // the calling thread works too.
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+    return results;
+}
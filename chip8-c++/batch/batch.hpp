@@ -0,0 +1,111 @@
+// no duplicate includes.
+#pragma once
+
+// the core which the jobs run on.
+#include<core.hpp>
+
+// gives the std::string and std::vector types.
+#include<string>
+#include<vector>
+
+// gives the std::function type used to watch the progress of a job.
+#include<functional>
+
+/// a change of the hexpad during a job, the bitmap is held from `frame` until the next event.
+struct InputEvent {
+    /// the first frame the bitmap is applied to.
+    uint32_t frame;
+    /// the hexpad bitmap.
+    uint16_t hexpad_bitmap;
+};
+
+/// a single headless run of a ROM with scripted input.
+struct BatchJob {
+    /// a name identifying the job in results, usually the ROM path.
+    std::string name;
+    /// the ROM bytes.
+    std::vector<char> rom;
+    /// the scripted input, ordered by frame.
+    std::vector<InputEvent> inputs;
+    /// the amount of frames to run.
+    uint32_t frames = 600;
+    /// a checkpoint is taken every this many frames, and after the last frame.
+    uint32_t checkpoint_interval = 60;
+    /// the seed the core is created with.
+    uint32_t seed = Core::DEFAULT_SEED;
+    /// the amount of instructions run every frame.
+    uint32_t instructions_per_frame = 60;
+};
+
+/// the state of a job's core at a checkpoint.
+struct BatchCheckpoint {
+    /// the amount of frames run when the checkpoint was taken.
+    uint32_t frame;
+    /// the `framebuffer_hash` of the core at the checkpoint.
+    uint64_t hash;
+};
+
+/// the outcome of a job.
+struct BatchResult {
+    /// the checkpoints, in order.
+    std::vector<BatchCheckpoint> checkpoints;
+    /// the trap the core stopped on, if any.
+    CoreTrap trap = CoreTrap::None;
+    /// the address of the trapping instruction.
+    uint16_t trap_pc = 0;
+    /// whether the core halted in an endless loop, see `Core::halted`.
+    bool halted = false;
+    /// the frame the core halted in, only meaningful if `halted` is `true`.
+    uint32_t halted_frame = 0;
+    /// the reason the job couldn't run, empty if it ran.
+    std::string error;
+};
+
+/// @brief hashes the pixels of a framebuffer, identical frames always have identical hashes.
+inline uint64_t framebuffer_hash(const Framebuffer& fb) {
+    return fnv1a_hash(fb.ptr_begin(), fb.len() * sizeof(uint32_t));
+}
+
+/// @brief parses an input script into a job. Every line is either `frames <n>`, `checkpoint <n>`, `instructions <n>` (per
+/// @brief frame), `seed <n>`, `<frame> <hexpad bitmap>` (with the bitmap in hexadecimal) or a comment starting with `#`.
+/// @brief Input lines must be ordered by frame.
+/// @param script the text of the script
+/// @param job the job to fill in, its previous inputs are replaced
+/// @return `false` if a line couldn't be parsed
+bool parse_input_script(const std::string& script, BatchJob& job);
+
+/// @brief runs a job on the calling thread.
+/// @param job the job to run
+/// @return the checkpoints of the job, or why it couldn't run
+BatchResult run_job(const BatchJob& job);
+
+/// @brief runs a job on the calling thread, on a core the caller keeps around. The core is put back in its starting
+/// @brief state with `Core::reset`, so a thread running many jobs never creates a core.
+/// @param job the job to run
+/// @param core the core to run the job on, left in the state the job stopped in
+/// @return the checkpoints of the job, or why it couldn't run
+BatchResult run_job(const BatchJob& job, Core& core);
+
+/// @brief continues a job that already ran `frames_run` frames, to pick up a job saved by a previous process.
+/// @param job the job to run
+/// @param core the core, in the state the job left it in after `frames_run` frames. Untouched if `frames_run` is 0,
+/// the job starts over with `Core::reset` then
+/// @param frames_run the amount of frames the job already ran
+/// @param result the checkpoints of the frames already run, added to
+/// @param on_frame called after every frame the core runs with the amount of frames run, when `core` and `result` are
+/// consistent and could be saved to continue from. Not called for the frames a waiting core skips, nor once the
+/// job stopped
+void continue_job(const BatchJob& job, Core& core, uint32_t frames_run, BatchResult& result,
+    const std::function<void(uint32_t)>& on_frame);
+
+/// @brief runs a job again up to `frames` frames and returns its core, to look at a single checkpoint more closely.
+/// @brief jobs are deterministic, so this reproduces the exact state `run_job` saw after `frames` frames.
+/// @param job the job to run, must be runnable (see `BatchResult::error`)
+/// @param frames the amount of frames to run
+Core replay_job(const BatchJob& job, uint32_t frames);
+
+/// @brief runs every job, spread over `threads` threads.
+/// @param jobs the jobs to run
+/// @param threads the amount of threads, 0 uses one per hardware thread
+/// @return the results, in the same order as `jobs`
+std::vector<BatchResult> run_batch(const std::vector<BatchJob>& jobs, size_t threads);
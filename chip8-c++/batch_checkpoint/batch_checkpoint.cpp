@@ -0,0 +1,321 @@
+// the checkpoint file declarations implemented in this file.
+#include<batch_checkpoint.hpp>
+
+// gives the file and memory mapping functions.
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include<fcntl.h>
+#include<unistd.h>
+
+// gives the threads, the atomics the file is written with and the timer asking for saves.
+#include<thread>
+#include<atomic>
+#include<mutex>
+#include<condition_variable>
+#include<chrono>
+
+// gives the std::map of the jobs to continue.
+#include<map>
+
+// gives the std::memcpy function.
+#include<cstring>
+
+// gives the std::max function.
+#include<algorithm>
+
+// gives the std::is_trivially_copyable check.
+#include<type_traits>
+
+/// the bytes a checkpoint file starts with, "C8BK".
+static const uint32_t BATCH_CHECKPOINT_MAGIC = 0x4b423843;
+/// the version of the layout, files of other versions are started over.
+static const uint32_t BATCH_CHECKPOINT_VERSION = 1;
+
+/// the start of a checkpoint file, followed by a `CheckpointJob` per job, the checkpoints of every job and two
+/// `CheckpointSlot`s per worker.
+struct CheckpointHeader {
+    /// `BATCH_CHECKPOINT_MAGIC`, written last when the file is created.
+    std::atomic<uint32_t> magic;
+    uint32_t version;
+    /// the hash of the jobs, a file of other jobs isn't continued.
+    uint64_t jobs_hash;
+    uint64_t job_count;
+    uint64_t slot_count;
+    /// the amount of checkpoints there's room for, enough for every job.
+    uint64_t checkpoint_capacity;
+};
+
+/// the result of a job, without its checkpoints.
+struct CheckpointJob {
+    /// whether the job finished, set after the rest of the result is written.
+    std::atomic<uint32_t> finished;
+    uint32_t halted_frame;
+    uint16_t trap_pc;
+    uint8_t trap;
+    uint8_t halted;
+    /// the amount of checkpoints of the finished job.
+    uint32_t checkpoint_count;
+    /// the index of the job's first checkpoint.
+    uint64_t first_checkpoint;
+};
+
+/// a save of the job a worker is running.
+struct CheckpointSlot {
+    /// increases with every save of the worker, 0 while being written or if never written.
+    std::atomic<uint64_t> sequence;
+    /// the job the worker runs.
+    uint32_t job;
+    /// the amount of frames of the job run.
+    uint32_t frames_run;
+    /// the amount of checkpoints of the job taken, already in the job's checkpoints.
+    uint32_t checkpoint_count;
+    uint8_t savestate[Core::SAVESTATE_SIZE];
+};
+
+// the file is written in place, so everything in it has to be safe to memcpy and to share between processes.
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "the sequence numbers must be lock free to be in a file");
+static_assert(std::is_trivially_copyable<BatchCheckpoint>::value, "checkpoints are copied into the file as they are");
+
+/// @brief rounds `offset` up to the alignment of everything in the file.
+static size_t align(size_t offset) {
+    return (offset + 7) & ~size_t(7);
+}
+
+/// @brief the most checkpoints a job takes, one every interval and one after the last frame.
+static size_t checkpoint_capacity(const BatchJob& job) {
+    return job.checkpoint_interval == 0 ? 0 : job.frames / job.checkpoint_interval + 1;
+}
+
+/// @brief hashes everything that decides the results of the jobs.
+static uint64_t hash_jobs(const std::vector<BatchJob>& jobs) {
+    std::vector<uint8_t> bytes;
+    for (const BatchJob& job : jobs) {
+        const uint32_t settings[] = { uint32_t(job.rom.size()), uint32_t(job.inputs.size()), job.frames,
+            job.checkpoint_interval, job.seed, job.instructions_per_frame };
+        const uint8_t* settings_bytes = reinterpret_cast<const uint8_t*>(settings);
+        bytes.insert(bytes.end(), settings_bytes, settings_bytes + sizeof(settings));
+        bytes.insert(bytes.end(), job.rom.begin(), job.rom.end());
+        for (const InputEvent& event : job.inputs) {
+            const uint32_t input[] = { event.frame, event.hexpad_bitmap };
+            const uint8_t* input_bytes = reinterpret_cast<const uint8_t*>(input);
+            bytes.insert(bytes.end(), input_bytes, input_bytes + sizeof(input));
+        }
+    }
+    return fnv1a_hash(bytes.data(), bytes.size());
+}
+
+/// the checkpoint file of a batch, mapped into memory.
+struct CheckpointFile {
+    /// @brief maps the file at `path`, creating it if it isn't there or isn't a checkpoint file of this version.
+    /// @return `false` if the file couldn't be mapped or belongs to other jobs
+    bool open(const std::string& path, const std::vector<BatchJob>& jobs, size_t threads) {
+        const uint64_t jobs_hash = hash_jobs(jobs);
+        const int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd < 0) return false;
+        CheckpointHeader existing = {};
+        const bool has_header = pread(fd, &existing, sizeof(existing), 0) == ssize_t(sizeof(existing))
+            && existing.magic.load() == BATCH_CHECKPOINT_MAGIC && existing.version == BATCH_CHECKPOINT_VERSION;
+        if (has_header && (existing.jobs_hash != jobs_hash || existing.job_count != jobs.size())) {
+            close(fd);
+            return false;
+        }
+        this->slot_count = has_header ? existing.slot_count : threads;
+        size_t capacity = 0;
+        for (const BatchJob& job : jobs) capacity += checkpoint_capacity(job);
+
+        this->checkpoints_offset = align(sizeof(CheckpointHeader) + jobs.size() * sizeof(CheckpointJob));
+        this->slots_offset = align(this->checkpoints_offset + capacity * sizeof(BatchCheckpoint));
+        this->size = this->slots_offset + this->slot_count * 2 * sizeof(CheckpointSlot);
+        // a new file starts out zeroed, which is every job unfinished and every slot unwritten.
+        if (!has_header && (ftruncate(fd, 0) != 0 || ftruncate(fd, this->size) != 0)) {
+            close(fd);
+            return false;
+        }
+        struct stat info;
+        void* mapping = fstat(fd, &info) == 0 && size_t(info.st_size) >= this->size
+            ? mmap(nullptr, this->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+        close(fd); // the mapping keeps the file open.
+        if (mapping == MAP_FAILED) return false;
+        this->mapping = static_cast<uint8_t*>(mapping);
+
+        if (!has_header) {
+            CheckpointHeader& header = *reinterpret_cast<CheckpointHeader*>(this->mapping);
+            header.version = BATCH_CHECKPOINT_VERSION;
+            header.jobs_hash = jobs_hash;
+            header.job_count = jobs.size();
+            header.slot_count = this->slot_count;
+            header.checkpoint_capacity = capacity;
+            uint64_t first_checkpoint = 0;
+            for (size_t index = 0; index < jobs.size(); ++index) {
+                this->job(index).first_checkpoint = first_checkpoint;
+                first_checkpoint += checkpoint_capacity(jobs[index]);
+            }
+            // a process dying before this point leaves a file without a header, which is simply created again.
+            header.magic.store(BATCH_CHECKPOINT_MAGIC, std::memory_order_release);
+        }
+        return true;
+    }
+
+    ~CheckpointFile() {
+        if (this->mapping != nullptr) munmap(this->mapping, this->size);
+    }
+
+    CheckpointJob& job(size_t index) {
+        return reinterpret_cast<CheckpointJob*>(this->mapping + sizeof(CheckpointHeader))[index];
+    }
+
+    /// @brief the checkpoints of a job.
+    BatchCheckpoint* checkpoints(size_t job) {
+        return reinterpret_cast<BatchCheckpoint*>(this->mapping + this->checkpoints_offset) + this->job(job).first_checkpoint;
+    }
+
+    /// @brief the two copies of a worker's slot.
+    CheckpointSlot* slots(size_t worker) {
+        return reinterpret_cast<CheckpointSlot*>(this->mapping + this->slots_offset) + worker * 2;
+    }
+
+    /// @brief saves the job a worker is running, into the older copy of its slot.
+    void save(size_t worker, uint32_t job, uint32_t frames_run, uint32_t checkpoint_count, const Core& core) {
+        CheckpointSlot* slots = this->slots(worker);
+        const uint64_t first = slots[0].sequence.load(std::memory_order_relaxed);
+        const uint64_t second = slots[1].sequence.load(std::memory_order_relaxed);
+        CheckpointSlot& slot = first <= second ? slots[0] : slots[1];
+        // marks the copy as being written, the fence keeps the writes below from being moved above it.
+        slot.sequence.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.job = job;
+        slot.frames_run = frames_run;
+        slot.checkpoint_count = checkpoint_count;
+        core.save_state(slot.savestate);
+        slot.sequence.store(std::max(first, second) + 1, std::memory_order_release);
+    }
+
+    /// @brief writes the result of a finished job, marking it as finished last.
+    void finish(size_t index, const BatchResult& result) {
+        CheckpointJob& job = this->job(index);
+        std::memcpy(this->checkpoints(index), result.checkpoints.data(), result.checkpoints.size() * sizeof(BatchCheckpoint));
+        job.checkpoint_count = result.checkpoints.size();
+        job.trap = static_cast<uint8_t>(result.trap);
+        job.trap_pc = result.trap_pc;
+        job.halted = result.halted;
+        job.halted_frame = result.halted_frame;
+        job.finished.store(1, std::memory_order_release);
+    }
+
+    uint8_t* mapping = nullptr;
+    size_t size = 0;
+    size_t slot_count = 0;
+    size_t checkpoints_offset = 0;
+    size_t slots_offset = 0;
+};
+
+/// a job that was running when the previous process died.
+struct SavedJob {
+    uint32_t frames_run;
+    std::vector<BatchCheckpoint> checkpoints;
+    std::vector<uint8_t> savestate;
+};
+
+bool run_batch_checkpointed(const std::vector<BatchJob>& jobs, size_t threads, const std::string& path,
+    uint32_t interval_ms, std::vector<BatchResult>& results, BatchCheckpointStats& stats) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    CheckpointFile file;
+    if (!file.open(path, jobs, threads)) return false;
+    threads = std::min(threads, file.slot_count);
+
+    // picks up the finished jobs, and copies the saved ones out before the workers write their slots again.
+    results.assign(jobs.size(), BatchResult());
+    std::vector<bool> finished(jobs.size(), false);
+    for (size_t index = 0; index < jobs.size(); ++index) {
+        CheckpointJob& job = file.job(index);
+        if (!job.finished.load(std::memory_order_acquire)) continue;
+        BatchResult& result = results[index];
+        const BatchCheckpoint* checkpoints = file.checkpoints(index);
+        result.checkpoints.assign(checkpoints, checkpoints + job.checkpoint_count);
+        result.trap = static_cast<CoreTrap>(job.trap);
+        result.trap_pc = job.trap_pc;
+        result.halted = job.halted != 0;
+        result.halted_frame = job.halted_frame;
+        finished[index] = true;
+        stats.finished += 1;
+    }
+    std::map<uint32_t, SavedJob> saved;
+    for (size_t worker = 0; worker < file.slot_count; ++worker) {
+        CheckpointSlot* slots = file.slots(worker);
+        const uint64_t first = slots[0].sequence.load(std::memory_order_acquire);
+        const uint64_t second = slots[1].sequence.load(std::memory_order_acquire);
+        const CheckpointSlot& slot = first >= second ? slots[0] : slots[1];
+        if (std::max(first, second) == 0 || slot.job >= jobs.size() || finished[slot.job]) continue;
+        // a job continued before may still be in the slot of its old worker, the furthest save counts.
+        auto found = saved.find(slot.job);
+        if (found != saved.end() && found->second.frames_run >= slot.frames_run) continue;
+        const BatchCheckpoint* checkpoints = file.checkpoints(slot.job);
+        saved[slot.job] = { slot.frames_run, std::vector<BatchCheckpoint>(checkpoints, checkpoints + slot.checkpoint_count),
+            std::vector<uint8_t>(slot.savestate, slot.savestate + Core::SAVESTATE_SIZE) };
+    }
+
+    // the timer asks for a save by moving the epoch on, a worker saves after the first frame it sees a new epoch in.
+    std::atomic<uint32_t> epoch { 0 };
+    std::atomic<size_t> saves { 0 }, resumed { 0 };
+    std::mutex timer_mutex;
+    std::condition_variable timer_stop;
+    bool stopping = false;
+    std::thread timer([&]() {
+        std::unique_lock<std::mutex> lock(timer_mutex);
+        while (!timer_stop.wait_for(lock, std::chrono::milliseconds(interval_ms), [&]() { return stopping; })) {
+            epoch.fetch_add(1, std::memory_order_relaxed);
+            msync(file.mapping, file.size, MS_ASYNC);
+        }
+    });
+
+    std::atomic<size_t> next_job { 0 };
+    auto worker = [&](size_t slot) {
+        Core core = Core::create(nullptr, 0);
+        for (size_t job = next_job++; job < jobs.size(); job = next_job++) {
+            if (finished[job]) continue;
+            BatchResult& result = results[job];
+            uint32_t frames_run = 0;
+            auto found = saved.find(job);
+            if (found != saved.end() && core.load_state(found->second.savestate.data())) {
+                frames_run = found->second.frames_run;
+                result.checkpoints = found->second.checkpoints;
+                resumed += 1;
+            }
+            // the checkpoints already in the file, only the ones after them are copied in at the next save.
+            size_t written = result.checkpoints.size();
+            uint32_t seen = epoch.load(std::memory_order_relaxed);
+            continue_job(jobs[job], core, frames_run, result, [&](uint32_t frames) {
+                const uint32_t now = epoch.load(std::memory_order_relaxed);
+                if (now == seen) return;
+                seen = now;
+                std::memcpy(file.checkpoints(job) + written, result.checkpoints.data() + written,
+                    (result.checkpoints.size() - written) * sizeof(BatchCheckpoint));
+                written = result.checkpoints.size();
+                file.save(slot, job, frames, written, core);
+                saves += 1;
+            });
+            // a job that can't run at all is quick to find out about again, only jobs that ran are kept.
+            if (result.error.empty()) file.finish(job, result);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (size_t thread = 1; thread < threads; ++thread) {
+        pool.emplace_back(worker, thread);
+    }
+    worker(0); // the calling thread works too.
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+    {
+        std::lock_guard<std::mutex> lock(timer_mutex);
+        stopping = true;
+    }
+    timer_stop.notify_one();
+    timer.join();
+    stats.saves = saves;
+    stats.resumed = resumed;
+    unlink(path.c_str());
+    return true;
+}
@@ -0,0 +1,43 @@
+// no duplicate includes.
+#pragma once
+
+// the jobs being run and their results.
+#include<batch.hpp>
+
+/// @brief a checkpoint file keeps the progress of a batch, so a batch whose process dies continues where it left off
+/// @brief instead of starting over.
+/// @brief
+/// @brief the file is memory mapped and holds the result of every finished job, and for every worker thread the
+/// @brief savestate of the core it's running, how many frames of its job it ran and the checkpoints it took so far.
+/// @brief A timer thread asks the workers to save every so often, and each worker copies its own core into the file
+/// @brief after its next frame, about 5 kilobytes, so no worker waits for another. Finished jobs are written as they
+/// @brief finish. Everything written to the mapping survives the process dying, the timer also asks the system to
+/// @brief write it to disk.
+/// @brief
+/// @brief every worker has two copies of its slot and writes the older one, marking it as written with a sequence
+/// @brief number last, so a process dying in the middle of saving still leaves the previous save intact. On restart
+/// @brief the finished jobs are skipped, and the jobs that were running continue from their saved cores. Jobs are
+/// @brief deterministic, so the results are exactly those of an uninterrupted run.
+
+/// what a batch found in its checkpoint file and did with it.
+struct BatchCheckpointStats {
+    /// the amount of jobs that were already finished.
+    size_t finished = 0;
+    /// the amount of jobs continued from a saved core.
+    size_t resumed = 0;
+    /// the amount of times a worker saved its core.
+    size_t saves = 0;
+};
+
+/// @brief runs every job like `run_batch`, saving the progress to a checkpoint file and continuing from it if it's
+/// @brief there. The file is removed once every job finished.
+/// @param jobs the jobs to run
+/// @param threads the amount of threads, 0 uses one per hardware thread. A batch continuing from a file never uses
+/// more threads than the batch that created it
+/// @param path the checkpoint file
+/// @param interval_ms the milliseconds between saves
+/// @param results the results, in the same order as `jobs`
+/// @param stats what was found in the file and saved to it
+/// @return `false` if the file couldn't be created, or belongs to a batch of other jobs
+bool run_batch_checkpointed(const std::vector<BatchJob>& jobs, size_t threads, const std::string& path,
+    uint32_t interval_ms, std::vector<BatchResult>& results, BatchCheckpointStats& stats);
@@ -0,0 +1,477 @@
+// gives the io streams, which has the ability to write to the terminal.
+#include<iostream>
+
+// the core being benchmarked.
+#include<core.hpp>
+
+// the netplay session, whose rollbacks are benchmarked.
+#include<netplay.hpp>
+
+// the session pool, whose throughput is benchmarked.
+#include<session_pool.hpp>
+
+// exploring branches from a checkpoint, on threads and in forked processes.
+#include<explore.hpp>
+#ifdef CHIP8_FORK_SERVER
+#include<fork_server.hpp>
+#endif
+
+// the state store, whose memory per state is measured.
+#ifdef CHIP8_STATE_STORE
+#include<state_store.hpp>
+#endif
+
+// the window surface output, compared against the texture path.
+#include<surface_output.hpp>
+
+// the CPU's performance counters, read around every benchmark where the system has them.
+#ifdef CHIP8_PERF_COUNTERS
+#include<perf_counters.hpp>
+#endif
+
+// SDL2 header, for the windows the outputs are benchmarked with.
+#include<SDL2/SDL.h>
+
+// gives the std::memcpy function.
+#include<cstring>
+
+// gives the clocks used to time the benchmarks.
+#include<chrono>
+
+// gives the filestreams to read a ROM from the host system.
+#include<fstream>
+
+// gives access to the std::vector type.
+#include<vector>
+
+/// a small ROM that keeps the core busy without depending on any particular ROM being available.
+/// it reads random numbers, the hexpad and writes to memory every loop, so different inputs lead to different states.
+static const uint8_t BENCH_ROM[] = {
+    0xc0, 0xff, // 200: C0FF, v0 = random
+    0x71, 0x01, // 202: 7101, v1 += 1
+    0xe2, 0x9e, // 204: E29E, skip the next instruction if the key in v2 is pressed
+    0x73, 0x01, // 206: 7301, v3 += 1
+    0x83, 0x04, // 208: 8304, v3 += v0
+    0xa3, 0x00, // 20A: A300, i = 0x300
+    0xf3, 0x55, // 20C: F355, stores v0 to v3 at i
+    0x72, 0x01, // 20E: 7201, v2 += 1
+    0x12, 0x00, // 210: 1200, jump back to the start
+};
+
+/// the clock every benchmark is timed with.
+using Clock = std::chrono::steady_clock;
+
+/// @brief the microseconds between two time points.
+static double micros(Clock::time_point start, Clock::time_point end) {
+    return std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+/// @brief measures every benchmark with the CPU's performance counters, when they're built and the system lets this
+/// process use them, and prints nothing when it doesn't. Wall clock time alone doesn't say whether a change made the
+/// host run more instructions or made the same instructions stall on mispredictions and cache misses.
+struct BenchCounters {
+    /// opens the counters, and says why when there are none.
+    BenchCounters() {
+#ifdef CHIP8_PERF_COUNTERS
+        this->available = this->counters.open();
+        if (!this->available) std::cout << "performance counters unavailable (" << this->counters.error() << "), timing only" << std::endl;
+#endif
+    }
+
+    /// @brief starts counting a benchmark.
+    void start() {
+#ifdef CHIP8_PERF_COUNTERS
+        if (this->available) this->counters.start();
+#endif
+    }
+
+    /// @brief stops counting and prints the host's instructions per cycle and its misses.
+    /// @param emulated the instructions the emulated cores ran, the misses are reported per emulated instruction, or per
+    /// thousand host instructions when it's 0
+    void report(uint64_t emulated = 0) {
+#ifdef CHIP8_PERF_COUNTERS
+        if (!this->available) return;
+        const PerfSample sample = this->counters.stop();
+        const double per = emulated != 0 ? double(emulated) : sample.values[PERF_INSTRUCTIONS] / 1000.0;
+        std::cout << "    counters: IPC " << sample.ipc();
+        const char* names[PERF_COUNTERS] = { "cycles", "instructions", "branch misses", "L1D misses", "LLC misses" };
+        for (uint32_t counter = 0; counter < PERF_COUNTERS; ++counter) {
+            // per thousand host instructions, the host's own instructions would always be 1000.
+            if (!sample.counted[counter] || (emulated == 0 && counter == PERF_INSTRUCTIONS) || per == 0) continue;
+            std::cout << ", " << sample.values[counter] / per << " " << names[counter];
+        }
+        std::cout << (emulated != 0 ? " per emulated instruction" : " per 1000 instructions") << std::endl;
+#else
+        (void)emulated;
+#endif
+    }
+
+#ifdef CHIP8_PERF_COUNTERS
+    PerfCounters counters;
+    bool available = false;
+#endif
+};
+
+/// @brief benchmarks saving and restoring a core, both as a serialized savestate and as a plain copy.
+static void bench_savestates(const Core& core) {
+    const size_t iterations = 100000;
+    std::vector<uint8_t> buffer(Core::SAVESTATE_SIZE);
+    Core copy = core;
+
+    auto start = Clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        copy.save_state(buffer.data());
+        copy.load_state(buffer.data());
+    }
+    auto end = Clock::now();
+    std::cout << "savestate save+load:   " << micros(start, end) / iterations << " us" << std::endl;
+
+    start = Clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        copy = core;
+        __asm__ volatile ("" : : "g"(&copy) : "memory"); // keeps the copy from being optimized out.
+    }
+    end = Clock::now();
+    std::cout << "core copy:             " << micros(start, end) / iterations << " us" << std::endl;
+}
+
+/// @brief benchmarks two netplay sessions connected over a loopback with latency, reporting the cost of rollbacks.
+static void bench_netplay(const Core& core, uint32_t latency) {
+    NetplaySettings settings;
+    LoopbackTransport transport_a(latency), transport_b(latency);
+    LoopbackTransport::connect(transport_a, transport_b);
+    NetplaySession a(core, transport_a, settings), b(core, transport_b, settings);
+
+    const size_t frames = 20000;
+    double worst_frame = 0, worst_rollback = 0, total = 0;
+    uint32_t input = 0x2545f491;
+    for (size_t frame = 0; frame < frames; ++frame) {
+        // changes the inputs every few frames, so the predictions are often wrong.
+        if (frame % 5 == 0) input = input * 1664525 + 1013904223;
+        // the last frames have no input, so every prediction is correct by the end and the cores must match.
+        const bool settle = frame + 64 >= frames;
+        const uint64_t rollbacks = a.stats().rollbacks;
+        auto start = Clock::now();
+        a.advance_frame(settle ? 0 : input & 0x00ff);
+        auto end = Clock::now();
+        b.advance_frame(settle ? 0 : input >> 24);
+        double elapsed = micros(start, end);
+        worst_frame = std::max(worst_frame, elapsed);
+        if (a.stats().rollbacks != rollbacks) worst_rollback = std::max(worst_rollback, elapsed);
+        total += elapsed;
+    }
+
+    std::vector<uint8_t> state_a(Core::SAVESTATE_SIZE), state_b(Core::SAVESTATE_SIZE);
+    a.core().save_state(state_a.data());
+    b.core().save_state(state_b.data());
+    const bool in_sync = a.frame() == b.frame() && state_a == state_b;
+
+    const NetplayStats& stats = a.stats();
+    std::cout << "netplay (latency " << latency << " frames): "
+        << "average frame " << total / frames << " us, "
+        << "worst frame " << worst_frame << " us, "
+        << "worst rollback " << worst_rollback << " us, "
+        << stats.rollbacks << " rollbacks, "
+        << "deepest " << stats.max_rollback_depth << " frames, "
+        << stats.stalls << " stalls, "
+        << (in_sync ? "in sync" : "DESYNC") << std::endl;
+}
+
+/// a session running frames with a fixed hexpad, for the engine benchmark.
+struct EngineSession : Session {
+    EngineSession(const Core& core, uint64_t frames) : Session(core, 60), frames(frames) {}
+
+    bool frame_begin(uint64_t frame, uint16_t& hexpad_bitmap) override {
+        hexpad_bitmap = uint16_t(frame);
+        return frame != this->frames;
+    }
+
+    /// the amount of frames the session runs.
+    uint64_t frames;
+};
+
+/// @brief benchmarks the ways of running a core, an instruction at a time, a frame at a time and as a session split
+/// into slices of 7 instructions, in emulated instructions a second and with the counters per emulated instruction.
+/// The instructions are the ones the frames ask for, a ROM that sleeps or halts runs fewer.
+static void bench_engines(const Core& core, BenchCounters& counters) {
+    const uint64_t frames = 50000, instructions = frames * 60;
+    const auto print = [&](const char* name, Clock::time_point start, Clock::time_point end) {
+        std::cout << name << instructions / micros(start, end) << " MIPS" << std::endl;
+        counters.report(instructions);
+    };
+
+    Core stepped = core;
+    counters.start();
+    auto start = Clock::now();
+    for (uint64_t frame = 0; frame < frames; ++frame) {
+        stepped.begin_frame(uint16_t(frame));
+        for (size_t instruction = 0; instruction < 60; ++instruction) {
+            stepped.run_for_instructions(1);
+        }
+        stepped.tick_timers();
+    }
+    print("engine instructions:   ", start, Clock::now());
+
+    Core framed = core;
+    counters.start();
+    start = Clock::now();
+    for (uint64_t frame = 0; frame < frames; ++frame) {
+        framed.run_frame(uint16_t(frame), 60);
+    }
+    print("engine frames:         ", start, Clock::now());
+
+    EngineSession session(core, frames);
+    counters.start();
+    start = Clock::now();
+    while (session.resume(7) != SessionYield::Done) {}
+    print("engine session:        ", start, Clock::now());
+
+    std::vector<uint8_t> state_stepped(Core::SAVESTATE_SIZE), state_framed(Core::SAVESTATE_SIZE), state_session(Core::SAVESTATE_SIZE);
+    stepped.save_state(state_stepped.data());
+    framed.save_state(state_framed.data());
+    session.core().save_state(state_session.data());
+    if (state_stepped != state_framed || state_framed != state_session) std::cout << "engines: MISMATCH" << std::endl;
+}
+
+/// a session for the session pool benchmark, with changing input that scores every frame by hashing it.
+struct BenchSession : Session {
+    BenchSession(const Core& core, uint32_t seed) : Session(core, 60), input(seed) {}
+
+    bool frame_begin(uint64_t frame, uint16_t& hexpad_bitmap) override {
+        if (frame == BenchSession::FRAMES) return false;
+        if (frame % 5 == 0) this->input = this->input * 1664525 + 1013904223;
+        hexpad_bitmap = this->input >> 16;
+        return true;
+    }
+
+    void frame_end(uint64_t frame) override {
+        // only frames that changed the screen are hashed again, like a recorder would only encode those.
+        const Framebuffer& fb = this->core().framebuffer();
+        if (fb.dirty_rows() != 0) this->hash = fnv1a_hash(fb.ptr_begin(), fb.len() * sizeof(uint32_t));
+        this->score = this->score * 31 + this->hash + frame;
+    }
+
+    /// the amount of frames every session runs.
+    static const uint64_t FRAMES = 300;
+    /// the state of the input generator.
+    uint32_t input;
+    /// the hash of the last frame.
+    uint64_t hash = 0;
+    /// the hash of every frame so far.
+    uint64_t score = 0;
+};
+
+/// @brief benchmarks running many sessions on a session pool, and checks a small budget, which splits every frame
+/// into several turns, scores every session exactly like a budget that runs whole frames.
+static void bench_sessions(const Core& core) {
+    const size_t count = 1000;
+    std::vector<BenchSession> whole, split;
+    for (uint32_t seed = 0; seed < count; ++seed) {
+        whole.emplace_back(core, seed);
+        split.emplace_back(core, seed);
+    }
+
+    SessionPool pool;
+    for (BenchSession& session : whole) pool.add(session);
+    auto start = Clock::now();
+    const SessionPoolStats stats = pool.run();
+    auto end = Clock::now();
+
+    for (BenchSession& session : split) pool.add(session);
+    const SessionPoolStats split_stats = pool.run(7);
+    bool matches = true;
+    for (size_t index = 0; index < count; ++index) {
+        matches = matches && whole[index].score == split[index].score;
+    }
+
+    std::cout << "sessions: " << count << " sessions, "
+        << stats.frames / (micros(start, end) / 1e6) << " frames/s, "
+        << stats.steals << " steals, "
+        << split_stats.budget_yields << " budget yields at budget 7, "
+        << (matches ? "identical" : "MISMATCH") << std::endl;
+}
+
+/// @brief benchmarks exploring branches from a warmed up checkpoint, with copies of the core on threads and with
+/// forked children when the fork server is built, and checks both explore to identical results.
+static void bench_explore(const Core& core) {
+    const size_t count = 2000, frames = 30;
+    Core checkpoint = core;
+    for (size_t frame = 0; frame < 120; ++frame) {
+        checkpoint.run_frame(0, 60);
+    }
+    std::vector<ExploreBranch> branches(count);
+    uint32_t random = 1;
+    for (ExploreBranch& branch : branches) {
+        for (size_t frame = 0; frame < frames; ++frame) {
+            random = random * 1103515245 + 12345;
+            branch.hexpad.push_back(random >> 16);
+        }
+    }
+    const ExploreScore score = [](const Core& core) { return uint64_t(core.registers().pc) << 8 | core.registers().v[0]; };
+
+    auto start = Clock::now();
+    const std::vector<ExploreResult> clones = explore_clones(checkpoint, branches, 60, score);
+    auto end = Clock::now();
+    std::cout << "explore clones: " << count / (micros(start, end) / 1e6) << " branches/s" << std::endl;
+
+#ifdef CHIP8_FORK_SERVER
+    ForkServer server;
+    start = Clock::now();
+    const std::vector<ExploreResult> forks = server.explore(checkpoint, branches, 60, score);
+    end = Clock::now();
+    bool matches = true;
+    for (size_t index = 0; index < count; ++index) {
+        matches = matches && forks[index].finished && forks[index].state_hash == clones[index].state_hash
+            && forks[index].score == clones[index].score;
+    }
+    std::cout << "explore forks:  " << count / (micros(start, end) / 1e6) << " forks/s, "
+        << server.stats().crashed << " crashed, "
+        << (matches ? "identical" : "MISMATCH") << std::endl;
+#endif
+}
+
+#ifdef CHIP8_STATE_STORE
+/// @brief stores the states of a rewind buffer (a state every frame) and of an explorer (the states of many branches
+/// from a checkpoint, frame by frame) in a state store, reporting the bytes a state takes and checking a few of them.
+static void bench_state_store(const Core& core) {
+    StateStore store;
+    if (!StateStore::create(size_t(1) << 24, nullptr, store)) {
+        std::cout << "state store: skipped, could not map the pages" << std::endl;
+        return;
+    }
+    const size_t frames = 20000, branches = 500, branch_frames = 40;
+    std::vector<StateId> states;
+    std::vector<uint8_t> expected(Core::SAVESTATE_SIZE), stored(Core::SAVESTATE_SIZE);
+    bool matches = true;
+
+    Core rewind = core;
+    auto start = Clock::now();
+    for (size_t frame = 0; frame < frames; ++frame) {
+        rewind.run_frame(frame / 7 % 3 == 0 ? 1 << (frame % 16) : 0, 60);
+        states.push_back(store.put(rewind));
+    }
+    auto end = Clock::now();
+    rewind.save_state(expected.data());
+    store.read(states.back(), stored.data());
+    matches = matches && expected == stored;
+    std::cout << "state store rewind:    " << micros(start, end) / frames << " us per put, "
+        << double(store.stats().bytes) / frames << " bytes per state" << std::endl;
+    for (StateId state : states) store.release(state);
+    states.clear();
+
+    Core checkpoint = core;
+    for (size_t frame = 0; frame < 120; ++frame) checkpoint.run_frame(0, 60);
+    uint32_t random = 1;
+    start = Clock::now();
+    for (size_t branch = 0; branch < branches; ++branch) {
+        Core explorer = checkpoint;
+        for (size_t frame = 0; frame < branch_frames; ++frame) {
+            random = random * 1103515245 + 12345;
+            explorer.run_frame(random >> 16, 60);
+            states.push_back(store.put(explorer));
+        }
+        explorer.save_state(expected.data());
+        store.read(states.back(), stored.data());
+        matches = matches && expected == stored;
+    }
+    end = Clock::now();
+    std::cout << "state store explore:   " << micros(start, end) / states.size() << " us per put, "
+        << double(store.stats().bytes) / states.size() << " bytes per state, against "
+        << Core::SAVESTATE_SIZE << " for a savestate, " << (matches ? "identical" : "MISMATCH") << std::endl;
+    for (StateId state : states) store.release(state);
+    if (store.stats().pages != 0) std::cout << "state store: LEAKED " << store.stats().pages << " pages" << std::endl;
+}
+#endif
+
+/// @brief benchmarks presenting frames through a streaming texture, like the SDL frontend, against writing them into
+/// the window surface. both windows are hidden, and the renderer is a software one so both paths do their work on the CPU.
+static void bench_output(const Core& core) {
+    if (SDL_InitSubSystem(SDL_INIT_VIDEO) != 0) {
+        std::cout << "output: skipped, no video driver (" << SDL_GetError() << "), try SDL_VIDEODRIVER=dummy" << std::endl;
+        return;
+    }
+    const size_t frames = 2000;
+    const int width = core.framebuffer().width(), height = core.framebuffer().height();
+    const int window_width = width * 5, window_height = height * 5;
+
+    // the texture path, the same work the SDL frontend does every frame.
+    SDL_Window* window = SDL_CreateWindow("bench", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, window_width, window_height, SDL_WINDOW_HIDDEN);
+    SDL_Renderer* renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_SOFTWARE);
+    SDL_Texture* texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STREAMING, width, height);
+    Core texture_core = core;
+    double texture_total = 0;
+    for (size_t frame = 0; frame < frames; ++frame) {
+        texture_core.run_frame(0, 60);
+        auto start = Clock::now();
+        void* pixels = nullptr;
+        int pitch = 0;
+        SDL_LockTexture(texture, NULL, &pixels, &pitch);
+        for (int y = 0; y < height; ++y) {
+            std::memcpy(static_cast<uint8_t*>(pixels) + pitch * y, texture_core.framebuffer().ptr_begin() + y * width, width * 4);
+        }
+        SDL_UnlockTexture(texture);
+        SDL_RenderClear(renderer);
+        SDL_RenderCopy(renderer, texture, NULL, NULL);
+        SDL_RenderPresent(renderer);
+        texture_total += micros(start, Clock::now());
+    }
+    SDL_DestroyTexture(texture);
+    SDL_DestroyRenderer(renderer);
+    SDL_DestroyWindow(window);
+
+    // the surface path, once with the rows the core changed and once redrawing every row, the worst case.
+    double surface_total[2] = { 0, 0 };
+    for (int redraw_all = 0; redraw_all < 2; ++redraw_all) {
+        window = SDL_CreateWindow("bench", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, window_width, window_height, SDL_WINDOW_HIDDEN);
+        SurfaceOutput output(window);
+        Core surface_core = core;
+        for (size_t frame = 0; frame < frames; ++frame) {
+            surface_core.run_frame(0, 60);
+            auto start = Clock::now();
+            output.present(surface_core.framebuffer(), redraw_all ? Framebuffer::ALL_ROWS_DIRTY : surface_core.framebuffer().dirty_rows());
+            surface_total[redraw_all] += micros(start, Clock::now());
+        }
+        SDL_DestroyWindow(window);
+    }
+    SDL_QuitSubSystem(SDL_INIT_VIDEO);
+
+    std::cout << "output texture:        " << texture_total / frames << " us per frame" << std::endl;
+    std::cout << "output surface:        " << surface_total[0] / frames << " us per frame (dirty rows), "
+        << surface_total[1] / frames << " us per frame (every row)" << std::endl;
+}
+
+/// the entry point of the benchmark, optionally takes the path of a ROM to benchmark with instead of the built in one.
+int main(int argc, char* argv[]) {
+    std::vector<char> rom(BENCH_ROM, BENCH_ROM + sizeof(BENCH_ROM));
+    if (argc > 1) {
+        std::ifstream ifstream(argv[1], std::ios::binary);
+        rom.assign(std::istreambuf_iterator<char>(ifstream), std::istreambuf_iterator<char>());
+        std::cout << "benchmarking ROM: " << argv[1] << std::endl;
+    }
+    auto core = Core::create(rom.data(), rom.size());
+
+    BenchCounters counters;
+    bench_engines(core, counters);
+    counters.start();
+    bench_savestates(core);
+    counters.report();
+    for (uint32_t latency : { 0, 2, 4, 6 }) {
+        counters.start();
+        bench_netplay(core, latency);
+        counters.report();
+    }
+    counters.start();
+    bench_sessions(core);
+    counters.report();
+    counters.start();
+    bench_explore(core);
+    counters.report();
+#ifdef CHIP8_STATE_STORE
+    counters.start();
+    bench_state_store(core);
+    counters.report();
+#endif
+    counters.start();
+    bench_output(core);
+    counters.report();
+}
@@ -0,0 +1,162 @@
+// the capture declarations implemented in this file.
+#include<capture.hpp>
+
+// gives the std::memcpy and std::memset functions.
+#include<cstring>
+
+// gives the std::string type used to build the Y4M header.
+#include<string>
+
+// gives the std::chrono durations used for the worker's wait timeout.
+#include<chrono>
+
+// the zone profiler, its zones compile to nothing unless it's built.
+#include<profiler.hpp>
+
+// windows names the POSIX pipe functions differently.
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#endif
+
+/// the luma of an on and an off pixel in the Y4M output, using the video range of 16 to 235.
+static const uint8_t Y4M_LUMA_ON = 235;
+static const uint8_t Y4M_LUMA_OFF = 16;
+/// the neutral chroma value, the output is monochrome.
+static const uint8_t Y4M_CHROMA = 128;
+
+bool FrameCapture::open(const char* path, CaptureSettings settings) {
+    assert(this->output == nullptr && settings.scale > 0 && settings.queue_frames > 0);
+    if (path[0] == '|') {
+        this->output = popen(path + 1, "w");
+        this->is_pipe = true;
+    } else if (std::strcmp(path, "-") == 0) {
+        this->output = stdout;
+    } else {
+        this->output = std::fopen(path, "wb");
+    }
+    if (this->output == nullptr) {
+        return false;
+    }
+
+    this->settings = settings;
+    const size_t width = 60 * settings.scale;
+    const size_t height = 60 * settings.scale;
+    if (settings.format == CaptureFormat::Y4M) {
+        std::string header = "YUV4MPEG2 W" + std::to_string(width) + " H" + std::to_string(height)
+            + " F" + std::to_string(settings.frame_rate) + ":1 Ip A1:1 C420jpeg\n";
+        std::fwrite(header.data(), 1, header.size(), this->output);
+        // the luma plane is converted row by row, the chroma planes never change as the output is monochrome.
+        this->converted.assign(width * height + 2 * (width / 2) * (height / 2), Y4M_CHROMA);
+    } else {
+        this->converted.assign(width * height * 4, 0);
+    }
+
+    this->queue.resize(settings.queue_frames);
+    this->pending_dirty = Framebuffer::ALL_ROWS_DIRTY;
+    this->stopping = false;
+    this->worker = std::thread(&FrameCapture::run_worker, this);
+    return true;
+}
+
+bool FrameCapture::submit(const Framebuffer& fb) {
+    const size_t head = this->head.load(std::memory_order_relaxed);
+    size_t tail = this->tail.load(std::memory_order_acquire);
+    while (!this->settings.drop_when_behind && head - tail == this->queue.size()) {
+        std::this_thread::yield();
+        tail = this->tail.load(std::memory_order_acquire);
+    }
+    const uint64_t dirty = fb.dirty_rows() | this->pending_dirty;
+    if (head - tail == this->queue.size()) {
+        // the queue is full, the rows changed by this frame are remembered so the next queued frame includes them.
+        this->dropped += 1;
+        this->pending_dirty = dirty;
+        return false;
+    }
+    QueuedFrame& frame = this->queue[head % this->queue.size()];
+    const uint32_t* pixels = fb.ptr_begin();
+    for (size_t y = 0; y < fb.height(); ++y) {
+        if ((dirty >> y) & 1) {
+            std::memcpy(&frame.pixels[y * fb.width()], pixels + y * fb.width(), fb.width() * sizeof(uint32_t));
+        }
+    }
+    frame.dirty = dirty;
+    this->pending_dirty = 0;
+    this->head.store(head + 1, std::memory_order_release);
+    this->wake.notify_one();
+    return true;
+}
+
+void FrameCapture::close() {
+    if (!this->worker.joinable()) {
+        return;
+    }
+    this->stopping.store(true, std::memory_order_release);
+    this->wake.notify_one();
+    this->worker.join();
+    std::fflush(this->output);
+    if (this->is_pipe) {
+        pclose(this->output);
+    } else if (this->output != stdout) {
+        std::fclose(this->output);
+    }
+    this->output = nullptr;
+}
+
+void FrameCapture::run_worker() {
+    CHIP8_PROFILE_THREAD("capture");
+    while (true) {
+        const size_t tail = this->tail.load(std::memory_order_relaxed);
+        if (tail == this->head.load(std::memory_order_acquire)) {
+            // stops once the queue is empty, checking the queue again as a frame may have been queued right before stopping.
+            if (this->stopping.load(std::memory_order_acquire)) {
+                if (tail == this->head.load(std::memory_order_acquire)) break;
+                continue;
+            }
+            // the emulator notifies without locking, so a wakeup can be missed. The timeout bounds how late the worker can be.
+            std::unique_lock<std::mutex> lock(this->wake_mutex);
+            this->wake.wait_for(lock, std::chrono::milliseconds(2));
+            continue;
+        }
+        {
+            CHIP8_ZONE("capture convert");
+            this->convert(this->queue[tail % this->queue.size()]);
+        }
+        // the slot is handed back before writing, the converted frame is all that's needed from here on.
+        this->tail.store(tail + 1, std::memory_order_release);
+        CHIP8_ZONE("capture write");
+        if (this->settings.format == CaptureFormat::Y4M) {
+            std::fwrite("FRAME\n", 1, 6, this->output);
+        }
+        std::fwrite(this->converted.data(), 1, this->converted.size(), this->output);
+        this->written.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void FrameCapture::convert(const QueuedFrame& frame) {
+    const size_t scale = this->settings.scale;
+    const size_t bytes_per_pixel = this->settings.format == CaptureFormat::Y4M ? 1 : 4;
+    const size_t row_bytes = 60 * scale * bytes_per_pixel;
+    for (size_t y = 0; y < 60; ++y) {
+        if (((frame.dirty >> y) & 1) == 0) {
+            continue;
+        }
+        // converts the first scaled row, then copies it for the remaining rows of the scale.
+        uint8_t* row = &this->converted[y * scale * row_bytes];
+        for (size_t x = 0; x < 60; ++x) {
+            const bool on = frame.pixels[y * 60 + x] == Framebuffer::PIXEL_ON;
+            uint8_t* pixel = row + x * scale * bytes_per_pixel;
+            if (bytes_per_pixel == 1) {
+                std::memset(pixel, on ? Y4M_LUMA_ON : Y4M_LUMA_OFF, scale);
+            } else {
+                const uint8_t rgba[4] = { uint8_t(on ? 255 : 0), uint8_t(on ? 255 : 0), uint8_t(on ? 255 : 0), 255 };
+                for (size_t s = 0; s < scale; ++s) {
+                    std::memcpy(pixel + s * 4, rgba, 4);
+                }
+            }
+        }
+        for (size_t s = 1; s < scale; ++s) {
+            std::memcpy(row + s * row_bytes, row, row_bytes);
+        }
+    }
+}
@@ -0,0 +1,120 @@
+// no duplicate includes.
+#pragma once
+
+// the core whose frames are captured.
+#include<core.hpp>
+
+// gives the threading primitives used by the background writer.
+#include<atomic>
+#include<thread>
+#include<mutex>
+#include<condition_variable>
+
+// gives the std::vector type used for the frame queue and conversion buffer.
+#include<vector>
+
+// gives the FILE type the frames are written to.
+#include<cstdio>
+
+/// the formats frames can be captured in.
+enum class CaptureFormat {
+    /// YUV4MPEG2, a trivial video format most encoders accept directly (for example `ffmpeg -i capture.y4m`).
+    Y4M,
+    /// raw RGBA bytes, 4 bytes per pixel and frames stored back to back with no header.
+    RawRGBA,
+};
+
+/// the settings of a capture.
+struct CaptureSettings {
+    /// the format to write.
+    CaptureFormat format = CaptureFormat::Y4M;
+    /// the integer factor frames are scaled up by, as 60x60 is too small for most video players.
+    uint32_t scale = 4;
+    /// the frame rate written into the Y4M header.
+    uint32_t frame_rate = 60;
+    /// how many frames can be waiting for the writer before new frames are dropped.
+    uint32_t queue_frames = 16;
+    /// whether frames are dropped when the writer falls behind. Runs that don't need to keep real time, like the headless
+    /// frontend, can turn this off to have `submit` wait for the writer instead, so no frame is lost.
+    bool drop_when_behind = true;
+};
+
+/// captures frames to a file or pipe. Frames are handed over by the emulator thread and converted and written by
+/// a worker thread, so the emulator never waits on the disk; if the worker falls behind, frames are dropped and counted.
+struct FrameCapture {
+    FrameCapture() = default;
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+    /// finishes the capture, see `close`.
+    ~FrameCapture() {
+        this->close();
+    }
+
+    /// @brief starts capturing to `path`. A path starting with `|` is run as a shell command with the frames piped into it,
+    /// @brief and `-` writes to the standard output.
+    /// @param path the file, command or `-` to write to
+    /// @param settings the capture settings
+    /// @return whether the output could be opened
+    bool open(const char* path, CaptureSettings settings);
+
+    /// @brief hands a completed frame to the worker. Never blocks unless `drop_when_behind` is off, only the rows
+    /// @brief that changed since the last submitted frame are copied.
+    /// @param fb the framebuffer, its dirty rows must cover every change since the previous call
+    /// @return `false` if the frame was dropped because the worker is behind
+    bool submit(const Framebuffer& fb);
+
+    /// writes every queued frame, then closes the output. Called by the destructor.
+    void close();
+
+    /// the amount of frames written so far.
+    uint64_t frames_written() const {
+        return this->written.load(std::memory_order_relaxed);
+    }
+
+    /// the amount of frames dropped because the worker was behind.
+    uint64_t frames_dropped() const {
+        return this->dropped;
+    }
+private:
+    /// a frame waiting to be converted by the worker.
+    struct QueuedFrame {
+        /// the frame's pixels, only the rows in `dirty` are up to date.
+        std::array<uint32_t, 60 * 60> pixels;
+        /// the rows that changed since the previous queued frame.
+        uint64_t dirty;
+    };
+
+    /// the worker thread's loop.
+    void run_worker();
+
+    /// @brief converts the dirty rows of a frame into `converted`.
+    void convert(const QueuedFrame& frame);
+
+    /// the capture settings.
+    CaptureSettings settings;
+    /// the output, either a file or a pipe.
+    FILE* output = nullptr;
+    /// whether `output` is a pipe opened with `popen`.
+    bool is_pipe = false;
+    /// the frame queue, a single producer single consumer ring buffer.
+    std::vector<QueuedFrame> queue;
+    /// the next slot the emulator writes to, only modified by the emulator thread.
+    std::atomic<size_t> head { 0 };
+    /// the next slot the worker reads from, only modified by the worker thread.
+    std::atomic<size_t> tail { 0 };
+    /// rows changed by frames that were dropped, they are copied with the next frame that isn't.
+    uint64_t pending_dirty = Framebuffer::ALL_ROWS_DIRTY;
+    /// the converted output frame. It persists between frames, so only the dirty rows have to be converted again.
+    std::vector<uint8_t> converted;
+    /// the worker thread.
+    std::thread worker;
+    /// wakes the worker up when frames are queued. The emulator never locks the mutex, the worker waits with a timeout instead.
+    std::mutex wake_mutex;
+    std::condition_variable wake;
+    /// tells the worker to write the remaining frames and stop.
+    std::atomic<bool> stopping { false };
+    /// the amount of frames written.
+    std::atomic<uint64_t> written { 0 };
+    /// the amount of frames dropped, only modified by the emulator thread.
+    uint64_t dropped = 0;
+};
@@ -3,18 +3,13 @@
 // since the header is exposed to the frontend.
 #include<core.hpp>
 
-// includes the STD implementation of a rand() function
-#include<random>
-
-// allows printing errors to the terminal.
-#include<iostream>
-
 // unreachable code macro used for unreachable code.
 #define unreachable_code assert("unreachable code" && false)
 
 void Core::run_for_instruction() {
-    // don't do anything if waiting for a keypress
-    if (this->is_waiting_for_keypress) {
+    // don't do anything if waiting for a keypress, stopped by a trap or halted.
+    if (this->is_waiting_for_keypress || this->trap_reason != CoreTrap::None || this->is_halted || this->sleep_ticks != 0) {
+        if (this->sleep_ticks != 0) this->sleep_advance(1);
         return;
     }
 
@@ -40,7 +35,6 @@ void Core::run_for_instruction() {
 
     const uint8_t v0 = this->reg_read(0);           // the first reigster, or v[0], at the start of the instruction.
     const uint16_t i = this->i_get();               // the i register at the start of the instruction.
-    const uint16_t pc = this->pc_get();
 
     const bool key_pressed = this->hexpad.is_key_pressed(vx & 0xf);
 
@@ -67,11 +61,17 @@ void Core::run_for_instruction() {
         // be implemented here.
         case 0: goto invalid_instr; 
         case 1:{ // 1NNN
+            // a jump to itself never ends, and one 4 bytes back might be a loop waiting on the delay timer.
+            const uint16_t jump_address = (this->pc_get() - 2) & 0x0fff;
+            if (this->fast_paths && (jump_address == nnn || jump_address == nnn + 4)) {
+                this->check_halt_loop(jump_address, nnn);
+            }
             this->pc_set(nnn);
         } break;
         case 2:{ // 2NNN
             this->stack_push();
-            this->pc_set(nnn);
+            // a full stack traps, and like every trap leaves pc just after the call.
+            if (this->trap_reason == CoreTrap::None) this->pc_set(nnn);
         } break;
         case 3:{ // 3XNN
             if (vx == nn) this->skip_instr();
@@ -143,9 +143,10 @@ void Core::run_for_instruction() {
             this->pc_set(v0 + nnn);
         } break;
         case 0xc:{ // CXNN
-            this->reg_write(x, std::rand() & nn);
+            this->reg_write(x, this->random_byte() & nn);
         } break;
         case 0xd:{ // DXYN
+            if (!this->check_i_access(n)) break;
             bool collision = false;
             for (uint32_t h = 0; h < n; ++h){
                 uint8_t row = this->mem_read(i + h); 
@@ -199,6 +200,7 @@ void Core::run_for_instruction() {
                 this->i_set(vx * 5); 
             } break;
             case 0x33:{ // FX33
+                if (!this->check_i_access(3)) break;
                 uint8_t d0 = vx % 10;
                 uint8_t d1 = (vx / 10) % 10;
                 uint8_t d2 = (vx / 100) % 10;
@@ -207,11 +209,13 @@ void Core::run_for_instruction() {
                 this->mem_write(i + 2, d0);
             } break;
             case 0x55:{ // FX55
+                if (!this->check_i_access(x + 1)) break;
                 for (uint32_t j = 0; j <= x; ++j) {
                     this->mem_write(i + j, this->reg_read(j));
                 }
             } break;
             case 0x65:{ // FX65
+                if (!this->check_i_access(x + 1)) break;
                 for (uint32_t j = 0; j <= x; ++j) {
                     this->reg_write(j, this->mem_read(i + j));
                 }
@@ -223,9 +227,130 @@ void Core::run_for_instruction() {
         }
         break;
         invalid_instr:
-        std::cerr << "invalid instruction: [0x" << std::hex << pc - 2 << "] 0x" << instruction << std::endl;
-        assert("invalid instruction" && false); 
+        // stops the core instead of crashing, the frontend decides how to report it.
+        this->raise_trap(CoreTrap::InvalidInstruction);
     };
     }
 
-}
\ No newline at end of file
+}
+
+void Core::check_halt_loop(uint16_t jump_address, uint16_t target) {
+    // a jump to itself never goes anywhere.
+    if (jump_address == target) {
+        this->is_halted = true;
+        return;
+    }
+    // `FX07, 3X00, 1NNN` goes around the same way until the delay timer runs out, so the core can sleep until then.
+    // With VX holding the delay timer the loop only depends on the timer from here on, no matter how the core got here,
+    // so nothing has to be remembered from earlier iterations.
+    const uint16_t first = (this->mem_read(target) << 8) | this->mem_read(target + 1);
+    const uint16_t second = (this->mem_read(target + 2) << 8) | this->mem_read(target + 3);
+    const uint8_t x = (first >> 8) & 0xf;
+    if ((first & 0xf0ff) == 0xf007 && (second & 0xf0ff) == 0x3000 && (second & 0x0f00) == (first & 0x0f00)
+        && this->timer_delay != 0 && this->reg_read(x) == this->timer_delay) {
+        this->sleep_ticks = this->timer_delay;
+        this->sleep_loop = target;
+        this->sleep_register = x;
+        this->sleep_phase = 0;
+        this->sleep_read = this->timer_delay;
+    }
+}
+
+/// the magic bytes at the start of every savestate, "C8" followed by a format version.
+static const uint8_t SAVESTATE_MAGIC[4] = { 'C', '8', 'S', 4 };
+
+void Core::save_state(uint8_t buffer[]) const {
+    size_t at = 0;
+    // writes values in little endian order, so savestates don't depend on the host.
+    auto put = [&](uint32_t value, size_t bytes) {
+        for (size_t b = 0; b < bytes; ++b) {
+            buffer[at++] = (value >> (b * 8)) & 0xff;
+        }
+    };
+    for (uint8_t magic : SAVESTATE_MAGIC) put(magic, 1);
+    for (uint8_t reg : this->v) put(reg, 1);
+    put(this->pc, 2);
+    put(this->i, 2);
+    for (uint8_t byte : this->main_memory) put(byte, 1);
+    put(this->sp, 1);
+    for (uint16_t entry : this->stack) put(entry, 2);
+    put(this->timer_sound, 1);
+    put(this->timer_delay, 1);
+    // packs the framebuffer into bits, as a pixel is only ever on or off.
+    for (size_t p = 0; p < this->fb.len(); p += 8) {
+        uint8_t packed = 0;
+        for (size_t b = 0; b < 8; ++b) {
+            size_t index = p + b;
+            packed |= this->fb.pixel_status(index % this->fb.width(), index / this->fb.width()) << b;
+        }
+        put(packed, 1);
+    }
+    put(this->hexpad.bitmap(), 2);
+    put(this->is_waiting_for_keypress, 1);
+    put(this->keypress_index_register, 1);
+    put(this->rng_state, 4);
+    put(static_cast<uint8_t>(this->trap_reason), 1);
+    put(this->trap_address, 2);
+    put(this->is_halted, 1);
+    put(this->sleep_ticks, 1);
+    put(this->sleep_loop, 2);
+    put(this->sleep_register, 1);
+    put(this->sleep_phase, 1);
+    put(this->sleep_read, 1);
+    assert(at == SAVESTATE_SIZE);
+}
+
+bool Core::load_state(const uint8_t buffer[]) {
+    for (size_t m = 0; m < sizeof(SAVESTATE_MAGIC); ++m) {
+        if (buffer[m] != SAVESTATE_MAGIC[m]) return false;
+    }
+    size_t at = sizeof(SAVESTATE_MAGIC);
+    // reads values in little endian order, the inverse of `put` in `save_state`.
+    auto get = [&](size_t bytes) {
+        uint32_t value = 0;
+        for (size_t b = 0; b < bytes; ++b) {
+            value |= uint32_t(buffer[at++]) << (b * 8);
+        }
+        return value;
+    };
+    // the state is decoded into a copy first, so an invalid savestate leaves this core untouched.
+    Core core = *this;
+    for (uint8_t& reg : core.v) reg = get(1);
+    core.pc = get(2) & 0x0fff;
+    core.i = get(2) & 0x0fff;
+    for (uint8_t& byte : core.main_memory) byte = get(1);
+    core.sp = get(1);
+    for (uint16_t& entry : core.stack) entry = get(2);
+    core.timer_sound = get(1);
+    core.timer_delay = get(1);
+    for (size_t p = 0; p < core.fb.len(); p += 8) {
+        uint8_t packed = get(1);
+        for (size_t b = 0; b < 8; ++b) {
+            size_t index = p + b;
+            core.fb.set_pixel(index % core.fb.width(), index / core.fb.width(), (packed >> b) & 1);
+        }
+    }
+    core.hexpad.update_hexpad(get(2));
+    core.is_waiting_for_keypress = get(1) != 0;
+    core.keypress_index_register = get(1);
+    core.rng_state = get(4);
+    const uint32_t trap = get(1);
+    core.trap_reason = static_cast<CoreTrap>(trap);
+    core.trap_address = get(2) & 0x0fff;
+    core.is_halted = get(1) != 0;
+    core.sleep_ticks = get(1);
+    core.sleep_loop = get(2) & 0x0fff;
+    core.sleep_register = get(1);
+    core.sleep_phase = get(1);
+    core.sleep_read = get(1);
+    assert(at == SAVESTATE_SIZE);
+    const bool trap_valid = trap <= static_cast<uint32_t>(CoreTrap::MemoryOutOfBounds);
+    if (core.sp > STACK_SIZE || core.keypress_index_register >= core.v.size() || core.rng_state == 0 || !trap_valid
+        || core.sleep_register >= core.v.size() || core.sleep_phase > 2) {
+        return false;
+    }
+    // the state might have been saved halted or sleeping, which a core without fast paths runs through instead.
+    if (!core.fast_paths) core.set_fast_paths(false);
+    *this = core;
+    return true;
+}
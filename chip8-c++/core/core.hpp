@@ -10,6 +10,8 @@
 #include<assert.h>
 // gives the log2 function.
 #include<cmath>
+// gives the std::memcpy function, which `reset` loads the ROM with.
+#include<cstring>
 
 /// the framebuffer type encapsulates accessing (modifying and reading) from the framebuffer
 /// to avoid dealing with pointers as much as possible.
@@ -37,14 +39,33 @@ struct Framebuffer {
     /// @param status the value to set the pixel to, on `true` or off `false`
     void set_pixel(size_t x, size_t y, bool status) {
         assert(x < FB_WIDTH && y < FB_HEIGHT);
-        this->pixel_array[y * FB_WIDTH + x] = status ? PIXEL_ON : PIXEL_OFF;
+        uint32_t& pixel = this->pixel_array[y * FB_WIDTH + x];
+        const uint32_t value = status ? PIXEL_ON : PIXEL_OFF;
+        // only rows whose pixels actually change are marked dirty.
+        this->dirty |= uint64_t(pixel != value) << y;
+        pixel = value;
     }
 
     /// clears the entire framebuffer.
     void clear() {
         this->pixel_array = {PIXEL_OFF};
+        this->dirty = ALL_ROWS_DIRTY;
     }
 
+    /// @brief the rows that have changed since `clear_dirty_rows` was last called, where bit `n` is row `n`.
+    /// @brief consumers use this to only convert or upload the rows that changed.
+    uint64_t dirty_rows() const {
+        return this->dirty;
+    }
+
+    /// marks every row as unchanged.
+    void clear_dirty_rows() {
+        this->dirty = 0;
+    }
+
+    /// a dirty row bitmap with every row marked dirty.
+    static const uint64_t ALL_ROWS_DIRTY = (uint64_t(1) << 60) - 1;
+
     /// the width of the framebuffer.
     size_t width() const {
         return FB_WIDTH;
@@ -76,6 +97,9 @@ private:
     static const size_t FB_HEIGHT = 60;
     /// the internal pixel array.
     std::array<uint32_t, FB_HEIGHT * FB_WIDTH> pixel_array;
+    /// the rows changed since the last `clear_dirty_rows`. A 64 bit bitmap fits every row of the framebuffer.
+    uint64_t dirty;
+    static_assert(FB_HEIGHT <= 64, "every row needs a bit in the dirty bitmap");
 };
 
 struct Hexpad {
@@ -98,12 +122,74 @@ private:
     uint16_t hexpad_bitmap;
 };
 
+/// the reasons a core can stop executing. Instead of crashing the host on a broken or hostile ROM, the core
+/// stops at the faulting instruction and reports the reason, which the frontend can then show or ignore.
+enum class CoreTrap : uint8_t {
+    /// the core is running normally.
+    None,
+    /// an instruction that doesn't exist in the CHIP-8 spec was executed.
+    InvalidInstruction,
+    /// a 2NNN call was made with the stack full.
+    StackOverflow,
+    /// a 00EE return was made with the stack empty.
+    StackUnderflow,
+    /// an instruction tried to access memory past the end of main memory through the i register.
+    MemoryOutOfBounds,
+};
+
+/// @brief a short human readable name for a trap, for printing and reports.
+inline const char* trap_name(CoreTrap trap) {
+    switch (trap) {
+    case CoreTrap::None: return "none";
+    case CoreTrap::InvalidInstruction: return "invalid instruction";
+    case CoreTrap::StackOverflow: return "stack overflow";
+    case CoreTrap::StackUnderflow: return "stack underflow";
+    case CoreTrap::MemoryOutOfBounds: return "memory out of bounds";
+    }
+    return "unknown";
+}
+
+/// what `Core::reload_rom` does with the running program.
+enum class RomReload : uint8_t {
+    /// the program continues where it was with the new code, keeping its registers, stack, timers and screen.
+    KeepRegisters,
+    /// the program starts over like a newly created core, only keeping the memory it's told to keep.
+    Restart,
+};
+
+/// a copy of the CPU registers of a core, for tools that inspect a running core without being able to modify it.
+struct CoreRegisters {
+    /// the 16 general purpose registers.
+    std::array<uint8_t, 0x10> v;
+    /// the pc register.
+    uint16_t pc;
+    /// the i register.
+    uint16_t i;
+    /// the stack pointer, the amount of entries on the stack.
+    uint8_t sp;
+    /// the call stack.
+    std::array<uint16_t, 16> stack;
+    /// the delay timer.
+    uint8_t timer_delay;
+    /// the sound timer.
+    uint8_t timer_sound;
+    /// whether the core is waiting for a keypress (FX0A).
+    bool is_waiting_for_keypress;
+};
+
 /// the main core struct.
 /// this is the CHIP-8 implementation core struct, which will be driven by the frontend in `frontend.cpp`.
 struct Core {
+    /// the seed used for the random number generator when none is given to `create`.
+    static const uint32_t DEFAULT_SEED = 0x2545f491;
+
     /// @brief creates a CHIP-8 core to emulate the CHIP-8 specification. Performs basic initialization of the core before it returns.
     /// @return the initialized CHIP-8 core
-    static Core create(char rom[], size_t rom_length) {
+    /// @param rom the ROM bytes, loaded at address 512 (0x200)
+    /// @param rom_length the length of `rom` in bytes
+    /// @param seed the seed for the core's random number generator used by CXNN. Keeping the generator inside the core
+    /// (instead of using the global `std::rand`) makes two cores created with the same ROM, seed and inputs behave identically.
+    static Core create(const char rom[], size_t rom_length, uint32_t seed = DEFAULT_SEED) {
         auto core = Core();
         // assert rom isn't too large.
         if (rom_length > 4096 - 512) {
@@ -118,11 +204,77 @@ struct Core {
             core.mem_write(i, FONT_DATA[i]);
         }
         core.pc = 0x200; // pc starts at address 512 (0x200) in the CHIP-8 spec.
+        // xorshift can never leave the zero state, so a zero seed is replaced by the default one.
+        core.rng_state = seed != 0 ? seed : DEFAULT_SEED;
         return core;
     }
 
+    /// @brief puts the core in the state `create` would return, without creating a new core. Meant for tools that
+    /// @brief start over many times a second, like the fuzzer: the state is copied from a core created once, and the ROM
+    /// @brief is copied in one go instead of a byte at a time.
+    /// @param rom the ROM bytes, loaded at address 512 (0x200)
+    /// @param rom_length the length of `rom` in bytes, at most 3584
+    /// @param seed the seed for the core's random number generator, see `create`
+    void reset(const char rom[], size_t rom_length, uint32_t seed = DEFAULT_SEED) {
+        assert("ROM is too large to be loaded" && rom_length <= 4096 - 512);
+        static const Core initial = Core::create(nullptr, 0);
+        *this = initial;
+        if (rom_length != 0) {
+            std::memcpy(&this->main_memory[512], rom, rom_length);
+        }
+        this->rng_state = seed != 0 ? seed : DEFAULT_SEED;
+    }
+
+    /// @brief replaces the ROM of a running core in place, for reloading a ROM while it's being worked on without
+    /// @brief starting the emulator over. Whatever the core worked out from the old code (a halted or sleeping loop,
+    /// @brief a trap) is thrown away, so it continues on the new code with the next instruction it runs.
+    /// @param rom the new ROM bytes, loaded at address 512 (0x200)
+    /// @param rom_length the length of `rom` in bytes, at most 3584
+    /// @param mode whether the program keeps running or starts over, see `RomReload`
+    /// @param keep_address the start of memory that keeps its current bytes, for example where the program keeps its
+    /// level or score, even if the new ROM has bytes there
+    /// @param keep_length the length of the kept memory, 0 keeps nothing
+    void reload_rom(const char rom[], size_t rom_length, RomReload mode, uint16_t keep_address = 0, uint16_t keep_length = 0) {
+        assert("ROM is too large to be loaded" && rom_length <= 4096 - 512);
+        const size_t keep_end = size_t(keep_address) + keep_length < 0x1000 ? size_t(keep_address) + keep_length : 0x1000;
+        const std::array<uint8_t, 0x1000> kept = this->main_memory;
+        if (mode == RomReload::Restart) {
+            // the random numbers carry on, so starting over doesn't replay the same ones. Whether the core takes fast
+            // paths is a setting rather than state, so it survives the reset like it would a savestate.
+            const bool fast_paths = this->fast_paths;
+            this->reset(rom, rom_length, this->rng_state);
+            this->fast_paths = fast_paths;
+            // the pristine core has nothing dirty, but the old program's pixels are still on whatever shows the frames.
+            this->fb.clear();
+        } else {
+            if (rom_length != 0) {
+                std::memcpy(&this->main_memory[512], rom, rom_length);
+            }
+            if (this->sleep_ticks != 0) {
+                // puts the core where it would be in its loop, it goes on from there on the new code.
+                this->wake_up();
+            }
+            // the instruction that trapped runs again, the new code may have fixed it.
+            if (this->trap_reason != CoreTrap::None) {
+                this->pc_set(this->trap_address);
+                this->trap_reason = CoreTrap::None;
+            }
+            this->is_halted = false;
+        }
+        for (size_t address = keep_address; address < keep_end; ++address) {
+            this->main_memory[address] = kept[address];
+        }
+    }
+
     /// runs `instructions` amount of instructions in our core.
     void run_for_instructions(size_t instructions) {
+        // a halted core would only go around the same loop forever, so there's nothing to run.
+        if (this->is_halted) return;
+        // a sleeping one goes around its loop until the delay timer runs out, which only needs counting.
+        if (this->sleep_ticks != 0) {
+            this->sleep_advance(instructions);
+            return;
+        }
         while (instructions--) {
             this->run_for_instruction();
         }
@@ -133,6 +285,28 @@ struct Core {
     void tick_timers() {
         this->timer_delay = this->timer_delay > 0 ? this->timer_delay - 1 : this->timer_delay;
         this->timer_sound = this->timer_sound > 0 ? this->timer_sound - 1 : this->timer_sound;
+        if (this->sleep_ticks != 0 && --this->sleep_ticks == 0) {
+            this->wake_up();
+        }
+    }
+
+    /// @brief skips `frames` frames of a core that can't run, see `can_run`, doing exactly the same as running them
+    /// @brief with an unchanged hexpad. Lets schedulers leave blocked cores alone until they can run again.
+    /// @param frames the amount of frames, at most `sleep_frames` for a sleeping core
+    /// @param instructions the amount of instructions every frame would have run
+    void idle_frames(uint32_t frames, size_t instructions) {
+        assert(!this->can_run());
+        this->fb.clear_dirty_rows();
+        if (this->sleep_ticks != 0) {
+            assert(frames <= this->sleep_ticks);
+            while (frames--) {
+                this->sleep_advance(instructions);
+                this->tick_timers();
+            }
+            return;
+        }
+        this->timer_delay = frames < this->timer_delay ? this->timer_delay - frames : 0;
+        this->timer_sound = frames < this->timer_sound ? this->timer_sound - frames : 0;
     }
 
     /// implicitly inlined. Runs `instructions` amount of instructions and then ticks the timers.
@@ -141,11 +315,123 @@ struct Core {
         this->tick_timers();
     }
 
+    /// @brief runs a single frame: applies the hexpad bitmap, runs `instructions` amount of instructions and ticks the timers.
+    /// @brief this is the unit used by movies and other tools that need to replay input deterministically.
+    /// @param hexpad_bitmap the hexpad state for this frame, see `update_hexpad_bitmap`
+    /// @param instructions the amount of instructions to run in the frame
+    /// @brief the framebuffer's dirty rows are reset at the start of every frame, so after `run_frame` they are the rows the frame changed.
+    void run_frame(uint16_t hexpad_bitmap, size_t instructions) {
+        this->begin_frame(hexpad_bitmap);
+        this->run_for_instructions_then_tick_timers(instructions);
+    }
+
+    /// @brief the start of `run_frame`, for tools that run a frame's instructions themselves (like the debugger, which
+    /// @brief can stop in the middle of a frame). Such a frame is finished by running its instructions and calling `tick_timers`.
+    /// @param hexpad_bitmap the hexpad state for this frame, see `update_hexpad_bitmap`
+    void begin_frame(uint16_t hexpad_bitmap) {
+        this->fb.clear_dirty_rows();
+        this->update_hexpad_bitmap(hexpad_bitmap);
+    }
+
+    /// the size in bytes of a savestate produced by `save_state`.
+    static const size_t SAVESTATE_SIZE = 4 /* magic and version */
+        + 0x10          /* v */
+        + 2 + 2         /* pc, i */
+        + 0x1000        /* main memory */
+        + 1 + 16 * 2    /* sp, stack */
+        + 1 + 1         /* timers */
+        + 60 * 60 / 8   /* framebuffer, one bit per pixel */
+        + 2             /* hexpad */
+        + 1 + 1         /* keypress waiting state */
+        + 4             /* rng state */
+        + 1 + 2         /* trap */
+        + 1             /* halted */
+        + 1 + 2 + 3;    /* sleeping */
+
+    /// @brief serializes the entire core state into `buffer`. The layout is fixed and little endian, so a savestate
+    /// @brief can be written to disk and loaded on another machine.
+    /// @param buffer the destination, must be at least `SAVESTATE_SIZE` bytes
+    void save_state(uint8_t buffer[]) const;
+
+    /// @brief restores the core state from a buffer written by `save_state`.
+    /// @param buffer the source, must be at least `SAVESTATE_SIZE` bytes
+    /// @return `false` (leaving the core untouched) if the buffer isn't a valid savestate, otherwise `true`
+    bool load_state(const uint8_t buffer[]);
+
     /// allows the frontend to access the framebuffer in an immutable way.
     const Framebuffer& framebuffer() const {
         return this->fb;
     }
 
+    /// @brief copies the registers of the core, allowing them to be inspected without exposing the core's internals.
+    /// @return the current registers
+    CoreRegisters registers() const {
+        return CoreRegisters {
+            this->v, this->pc, this->i, static_cast<uint8_t>(this->sp), this->stack,
+            this->timer_delay, this->timer_sound, this->is_waiting_for_keypress,
+        };
+    }
+
+    /// the main memory of the core, for inspecting it without being able to modify it.
+    const std::array<uint8_t, 0x1000>& memory() const {
+        return this->main_memory;
+    }
+
+    /// the reason the core has stopped executing, `CoreTrap::None` if it's running.
+    CoreTrap trap() const {
+        return this->trap_reason;
+    }
+
+    /// @brief whether the core is stuck jumping to itself (a `1NNN` whose target is its own address), which many ROMs
+    /// @brief end with. Such a jump never changes anything but the timers, so the core stays exactly as it is. A halted
+    /// @brief core returns from `run_for_instructions` immediately, only its timers keep ticking. Longer loops are
+    /// @brief always run, as stopping one would leave the core at the start of the loop, where running it wouldn't.
+    bool halted() const {
+        return this->is_halted;
+    }
+
+    /// @brief whether the core is sleeping in a `FX07, 3X00, 1NNN` loop, which waits for the delay timer to run out.
+    /// @brief A sleeping core returns from `run_for_instructions` immediately, only counting where in the loop it would
+    /// @brief be. Once the timer runs out it continues from exactly where it would have been, see `sleep_frames`.
+    bool sleeping() const {
+        return this->sleep_ticks != 0;
+    }
+
+    /// the amount of timer ticks until a sleeping core wakes up, the value of its delay timer.
+    uint8_t sleep_frames() const {
+        return this->sleep_ticks;
+    }
+
+    /// @brief turns halting and sleeping on or off, they're on by default. Without them every instruction really runs,
+    /// @brief which is slower but is what the two are checked against. Turning them off wakes a sleeping core and
+    /// @brief takes a halted one out of halting, leaving it where running every instruction would have.
+    void set_fast_paths(bool enabled) {
+        this->fast_paths = enabled;
+        if (enabled) return;
+        if (this->sleep_ticks != 0) this->wake_up();
+        this->is_halted = false;
+    }
+
+    /// whether the core is waiting for a key to be pressed (FX0A).
+    bool waiting_for_keypress() const {
+        return this->is_waiting_for_keypress;
+    }
+
+    /// whether running the core can do anything right now: it isn't waiting for a keypress, trapped, halted or sleeping.
+    bool can_run() const {
+        return !this->is_waiting_for_keypress && this->trap_reason == CoreTrap::None && !this->is_halted && this->sleep_ticks == 0;
+    }
+
+    /// the address of the instruction that caused the trap, only meaningful if `trap` isn't `CoreTrap::None`.
+    uint16_t trap_pc() const {
+        return this->trap_address;
+    }
+
+    /// the current state of the hexpad.
+    uint16_t hexpad_bitmap() const {
+        return this->hexpad.bitmap();
+    }
+
     /// @brief updates the hexpand using an array of bools, where each corresponding index is the corresponding hexpad key,
     /// @brief going from top left down to bottom right of the hexpad.
     /// @param hexpad the array of bools corresponding to each key of the hexpad, with pressed being `true` and released being `false`.
@@ -171,6 +457,22 @@ struct Core {
             | hexpad[15] << 15;
         this->update_hexpad_bitmap(bitmap);
     }
+
+    /// @brief updates the hexpad using a bitmap.
+    /// @param bitmap the bitmap corresponding to the hexpad, where bit `n` is the key `n` being pressed.
+    void update_hexpad_bitmap(uint16_t bitmap) {
+        uint16_t old_bitmap = this->hexpad.bitmap();
+        // checks whether or not a new key was pressed.
+        // if a new key is pressed, then set `is_waiting for_keypress` to `false`, otherwise
+        // let `is_watiing_for_keypress` keep its original value.
+        uint16_t diff = ((bitmap ^ old_bitmap) & bitmap);
+        if (this->is_waiting_for_keypress && diff != 0) {
+            this->is_waiting_for_keypress = false;
+            auto log2 = std::log2(diff); // gets the recently toggled leftmost bit which will be the index sent to the vx register.
+            this->reg_write(this->keypress_index_register, log2);
+        }        
+        this->hexpad.update_hexpad(bitmap);
+    }
 private:
     /// the default constructor of the Core type. It's implicit but specified explictly for clarity.
     /// it's private as to force other initailization of the core, but allow to easily have default values internally.
@@ -199,25 +501,65 @@ private:
         0xF0, 0x80, 0xF0, 0x80, 0x80, // f font data.
     };
 
-    /// @brief updates the hexpad using a bitmap.
-    /// @param bitmap the bitmap corresponding to the hexpad.
-    void update_hexpad_bitmap(uint16_t bitmap) {
-        uint16_t old_bitmap = this->hexpad.bitmap();
-        // checks whether or not a new key was pressed.
-        // if a new key is pressed, then set `is_waiting for_keypress` to `false`, otherwise
-        // let `is_watiing_for_keypress` keep its original value.
-        uint16_t diff = ((bitmap ^ old_bitmap) & bitmap);
-        if (this->is_waiting_for_keypress && diff != 0) {
-            this->is_waiting_for_keypress = false;
-            auto log2 = std::log2(diff); // gets the recently toggled leftmost bit which will be the index sent to the vx register.
-            this->reg_write(this->keypress_index_register, log2);
-        }        
-        this->hexpad.update_hexpad(bitmap);
+    /// @brief advances the core's xorshift32 random number generator.
+    /// @return the next random byte
+    uint8_t random_byte() {
+        uint32_t x = this->rng_state;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        this->rng_state = x;
+        return x >> 24; // the upper bits of xorshift have the best quality.
+    }
+
+    /// @brief stops the core at the instruction that was just fetched.
+    /// @param reason why the core stopped
+    void raise_trap(CoreTrap reason) {
+        this->trap_reason = reason;
+        this->trap_address = (this->pc_get() - 2) & 0x0fff;
+    }
+
+    /// @brief checks that `length` bytes starting at the i register are inside main memory, trapping if they aren't.
+    /// @return whether the access is inside main memory
+    bool check_i_access(uint32_t length) {
+        if (this->i_get() + length > this->main_memory.size()) {
+            this->raise_trap(CoreTrap::MemoryOutOfBounds);
+            return false;
+        }
+        return true;
     }
-    
+
     /// fetches, decodes and executes a single CHIP-8 instruction
     void run_for_instruction();
 
+    /// @brief checks whether the loop closed by a backwards jump halts the core or puts it to sleep, see `halted` and
+    /// @brief `sleeping`. Called by 1NNN for a jump to itself or to 4 bytes before it.
+    /// @param jump_address the address of the jump
+    /// @param target where the jump goes, the start of the loop
+    void check_halt_loop(uint16_t jump_address, uint16_t target);
+
+    /// @brief counts `instructions` instructions of a sleeping core going around its loop, tracking where it would be in
+    /// @brief the loop and the last value its FX07 would have read.
+    void sleep_advance(size_t instructions) {
+        // FX07 is the first of the loop's three instructions.
+        if (size_t((3 - this->sleep_phase) % 3) < instructions) {
+            this->sleep_read = this->timer_delay;
+        }
+        this->sleep_phase = (this->sleep_phase + instructions % 3) % 3;
+    }
+
+    /// @brief wakes a sleeping core up, putting it where it would be had it gone around its loop all along. The sleep
+    /// @brief state is cleared, so an awake core saves the same state however it got there.
+    void wake_up() {
+        this->pc_set(this->sleep_loop + this->sleep_phase * 2);
+        this->reg_write(this->sleep_register, this->sleep_read);
+        this->sleep_ticks = 0;
+        this->sleep_loop = 0;
+        this->sleep_register = 0;
+        this->sleep_phase = 0;
+        this->sleep_read = 0;
+    }
+
     /// @brief reads from a register.
     /// @param index the register index, cannot be above 15
     /// @return the value of the register
@@ -301,13 +643,19 @@ private:
 
     /// pushes pc onto the stack.
     void stack_push() {
-        assert(this->sp < STACK_SIZE);
+        if (this->sp >= STACK_SIZE) {
+            this->raise_trap(CoreTrap::StackOverflow);
+            return;
+        }
         this->stack[sp++] = this->pc;
     }
 
     /// pops pc off of the stack.
     void stack_pop() {
-        assert(this->sp > 0);
+        if (this->sp == 0) {
+            this->raise_trap(CoreTrap::StackUnderflow);
+            return;
+        }
         this->stack[--sp] = this->pc;
     }
 
@@ -340,4 +688,38 @@ private:
     bool is_waiting_for_keypress;
     /// tells the core which register to update the recent keypress index to.
     size_t keypress_index_register;
-};
\ No newline at end of file
+    /// the state of the core's random number generator, advanced by every CXNN instruction.
+    uint32_t rng_state;
+    /// why the core stopped executing, if it has.
+    CoreTrap trap_reason;
+    /// the address of the instruction that caused the trap.
+    uint16_t trap_address;
+    /// whether the core is stuck jumping to itself, see `halted`.
+    bool is_halted;
+    /// the timer ticks left until the core wakes up, zero if it isn't sleeping, see `sleeping`.
+    uint8_t sleep_ticks;
+    /// the start of the loop the core sleeps in.
+    uint16_t sleep_loop;
+    /// the register the loop reads the delay timer into.
+    uint8_t sleep_register;
+    /// the instruction of the loop the core would be at, 0 to 2.
+    uint8_t sleep_phase;
+    /// the value the loop's FX07 read last.
+    uint8_t sleep_read;
+    /// whether the core halts and sleeps, see `set_fast_paths`.
+    bool fast_paths = true;
+};
+
+/// @brief hashes a block of bytes with 64 bit FNV-1a. Used to identify ROMs (for example in movies), it's not cryptographic.
+/// @param data the bytes to hash
+/// @param length the amount of bytes in `data`
+/// @return the 64 bit hash
+inline uint64_t fnv1a_hash(const void* data, size_t length) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+    uint64_t hash = 0xcbf29ce484222325;     // the FNV offset basis.
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3;              // the FNV prime.
+    }
+    return hash;
+}
\ No newline at end of file
@@ -0,0 +1,379 @@
+// gives the io streams, which has the ability to write to the terminal.
+#include<iostream>
+
+// the protocol spoken over the socket.
+#include<protocol.hpp>
+
+// gives the Unix domain socket functions.
+#include<sys/socket.h>
+#include<sys/time.h>
+#include<sys/un.h>
+#include<unistd.h>
+#include<csignal>
+#include<cerrno>
+#include<cstring>
+
+// gives the threads and the queue of jobs waiting for one.
+#include<thread>
+#include<mutex>
+#include<condition_variable>
+#include<deque>
+#include<memory>
+
+// gives the filestreams to read ROMs and input scripts.
+#include<fstream>
+#include<sstream>
+
+// gives the clock the client measures throughput with.
+#include<chrono>
+
+// gives the std::max function.
+#include<algorithm>
+
+/// @brief a client connected to the daemon. Closed once its reader, its writer and every job it sent are done with
+/// @brief it. Workers never write to the socket themselves: they queue their results, and the connection's own
+/// @brief writer thread sends them, so a client that stops reading can't hold up a worker.
+struct Connection {
+    /// @brief the most bytes of results waiting to be sent. A client that lets more than this pile up isn't reading
+    /// @brief its results, and is dropped.
+    static const size_t MAX_QUEUED_BYTES = 16 * 1024 * 1024;
+    /// the seconds a write may wait for the client to make room, a client taking longer is dropped.
+    static const time_t SEND_TIMEOUT_SECONDS = 10;
+
+    Connection(int fd) : fd(fd) {
+        const timeval timeout = { SEND_TIMEOUT_SECONDS, 0 };
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    }
+    ~Connection() {
+        close(this->fd);
+    }
+
+    /// @brief counts a job whose result is still to come, the writer waits for it before finishing.
+    void job_queued() {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        ++this->pending;
+    }
+
+    /// @brief marks the client done sending jobs, the writer finishes once the results of the jobs are sent.
+    void reading_done() {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->reading = false;
+        this->has_work.notify_one();
+    }
+
+    /// @brief queues the result of a job for the writer, never blocks on the client. A result that doesn't fit in
+    /// @brief `MAX_QUEUED_BYTES` drops the connection.
+    void send(std::vector<uint8_t> message) {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        --this->pending;
+        if (!this->failed) {
+            if (this->queued_bytes + message.size() > MAX_QUEUED_BYTES) {
+                std::cerr << "dropping a connection that isn't reading its results" << std::endl;
+                this->drop();
+            } else {
+                this->queued_bytes += message.size();
+                this->messages.push_back(std::move(message));
+            }
+        }
+        this->has_work.notify_one();
+    }
+
+    /// @brief the loop of the writer, sends the queued results in order until the client is done or dropped.
+    void write_messages() {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        while (true) {
+            this->has_work.wait(lock, [this]() {
+                return !this->messages.empty() || this->failed || (!this->reading && this->pending == 0);
+            });
+            // dropping clears the queue, so an empty queue means there's nothing more to send.
+            if (this->messages.empty()) return;
+            std::vector<uint8_t> message = std::move(this->messages.front());
+            this->messages.pop_front();
+            this->queued_bytes -= message.size();
+            lock.unlock();
+            const bool written = write_all(this->fd, message.data(), message.size());
+            lock.lock();
+            if (!written && !this->failed) this->drop();
+        }
+    }
+
+    int fd;
+
+private:
+    /// @brief gives up on the client: drops its queued results and shuts the socket down, which also ends the reader.
+    /// @brief `mutex` must be held.
+    void drop() {
+        this->failed = true;
+        this->messages.clear();
+        this->queued_bytes = 0;
+        shutdown(this->fd, SHUT_RDWR);
+    }
+
+    /// guards everything below.
+    std::mutex mutex;
+    /// wakes the writer when there's a result to send or nothing more to wait for.
+    std::condition_variable has_work;
+    /// the results waiting to be sent, in the order the jobs finished.
+    std::deque<std::vector<uint8_t>> messages;
+    /// the bytes of `messages`.
+    size_t queued_bytes = 0;
+    /// the jobs queued whose results haven't come back yet.
+    size_t pending = 0;
+    /// whether the client may still send jobs.
+    bool reading = true;
+    /// whether the client was dropped, the remaining results are thrown away.
+    bool failed = false;
+};
+
+/// a job waiting for a worker, with the connection its result goes to.
+struct QueuedJob {
+    std::shared_ptr<Connection> connection;
+    DaemonJob job;
+};
+
+/// the jobs of every connection waiting for a worker.
+struct JobQueue {
+    /// the most jobs waiting at once, a client sending faster than the workers run waits for room.
+    static const size_t MAX_QUEUED = 4096;
+
+    void push(QueuedJob job) {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->has_room.wait(lock, [this]() { return this->jobs.size() < MAX_QUEUED; });
+        this->jobs.push_back(std::move(job));
+        this->has_jobs.notify_one();
+    }
+
+    QueuedJob pop() {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->has_jobs.wait(lock, [this]() { return !this->jobs.empty(); });
+        QueuedJob job = std::move(this->jobs.front());
+        this->jobs.pop_front();
+        this->has_room.notify_one();
+        return job;
+    }
+
+    std::mutex mutex;
+    std::condition_variable has_jobs;
+    std::condition_variable has_room;
+    std::deque<QueuedJob> jobs;
+};
+
+/// @brief packs a framebuffer into a bit per pixel, row by row, the first pixel in the highest bit.
+static std::vector<uint8_t> framebuffer_bits(const Framebuffer& fb) {
+    std::vector<uint8_t> bits(fb.len() / 8);
+    const uint32_t* pixels = fb.ptr_begin();
+    for (size_t index = 0; index < fb.len(); ++index) {
+        bits[index / 8] |= uint8_t(pixels[index] == Framebuffer::PIXEL_ON) << (7 - index % 8);
+    }
+    return bits;
+}
+
+/// @brief the loop of a worker. Every worker keeps its own core warm for the whole life of the daemon, a job only
+/// @brief resets it.
+static void run_worker(JobQueue& queue) {
+    Core core = Core::create(nullptr, 0);
+    while (true) {
+        QueuedJob queued = queue.pop();
+        DaemonResult result;
+        result.id = queued.job.id;
+        result.result = run_job(queued.job.job, core);
+        if (result.result.error.empty()) {
+            if (queued.job.outputs & DAEMON_OUTPUT_FRAMEBUFFER) {
+                result.framebuffer = framebuffer_bits(core.framebuffer());
+            }
+            if (queued.job.outputs & DAEMON_OUTPUT_SAVESTATE) {
+                result.savestate.resize(Core::SAVESTATE_SIZE);
+                core.save_state(result.savestate.data());
+            }
+        }
+        if (!(queued.job.outputs & DAEMON_OUTPUT_CHECKPOINTS)) {
+            result.result.checkpoints.clear();
+        }
+        std::vector<uint8_t> message;
+        encode_result(result, message);
+        queued.connection->send(std::move(message));
+    }
+}
+
+/// @brief reads the jobs of a connection into the queue until the client is done sending.
+static void read_connection(std::shared_ptr<Connection> connection, JobQueue& queue) {
+    uint8_t hello[sizeof(DAEMON_HELLO)];
+    if (!read_all(connection->fd, hello, sizeof(hello)) || !std::equal(hello, hello + sizeof(hello), DAEMON_HELLO)) {
+        return;
+    }
+    DaemonMessage kind;
+    std::vector<uint8_t> body;
+    while (read_message(connection->fd, kind, body)) {
+        QueuedJob queued;
+        if (kind != DaemonMessage::Job || !decode_job(body, queued.job)) {
+            std::cerr << "dropping a connection that sent a broken message" << std::endl;
+            return;
+        }
+        queued.connection = connection;
+        connection->job_queued();
+        queue.push(std::move(queued));
+    }
+}
+
+/// @brief serves a client: reads its jobs on this thread while a writer thread of its own sends the results back.
+static void serve_connection(std::shared_ptr<Connection> connection, JobQueue& queue) {
+    std::thread writer(&Connection::write_messages, connection.get());
+    read_connection(connection, queue);
+    connection->reading_done();
+    writer.join();
+}
+
+/// @brief creates a Unix domain socket at `path`, listening if `listening` and connected otherwise.
+/// @return the socket, or -1 if it couldn't be created
+static int open_socket(const char* path, bool listening) {
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (std::string(path).size() >= sizeof(address.sun_path)) return -1;
+    std::strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (listening) {
+        unlink(path); // removes the socket left behind by a previous daemon.
+        if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0 && listen(fd, 64) == 0) return fd;
+    } else if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) {
+        return fd;
+    }
+    close(fd);
+    return -1;
+}
+
+/// @brief runs the daemon, never returns unless the socket fails.
+static int serve(const char* path, size_t threads) {
+    const int listener = open_socket(path, true);
+    if (listener < 0) {
+        std::cerr << "could not listen on: " << path << std::endl;
+        return 1;
+    }
+    JobQueue queue;
+    for (size_t thread = 0; thread < threads; ++thread) {
+        std::thread(run_worker, std::ref(queue)).detach();
+    }
+    std::cout << "chip8d listening on " << path << " with " << threads << " workers" << std::endl;
+    while (true) {
+        const int fd = accept(listener, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            std::cerr << "could not accept a connection" << std::endl;
+            return 1;
+        }
+        std::thread(serve_connection, std::make_shared<Connection>(fd), std::ref(queue)).detach();
+    }
+}
+
+/// @brief reads a whole file.
+/// @return `false` if the file couldn't be read
+static bool read_file(const std::string& path, std::string& contents) {
+    std::ifstream ifstream(path, std::ios::binary);
+    std::stringstream stream;
+    stream << ifstream.rdbuf();
+    contents = stream.str();
+    return bool(ifstream);
+}
+
+/// @brief sends jobs to a daemon and prints their results, the client side of the protocol.
+static int submit(const char* path, const std::vector<DaemonJob>& jobs, const std::vector<std::string>& names, size_t repeat) {
+    const int fd = open_socket(path, false);
+    if (fd < 0) {
+        std::cerr << "could not connect to: " << path << std::endl;
+        return 1;
+    }
+    const size_t count = jobs.size() * repeat;
+    auto start = std::chrono::steady_clock::now();
+    // the jobs go out on their own thread, so neither side blocks on a full socket while the other waits to write.
+    std::thread sender([&]() {
+        std::vector<uint8_t> message(DAEMON_HELLO, DAEMON_HELLO + sizeof(DAEMON_HELLO));
+        for (size_t index = 0; index < count; ++index) {
+            DaemonJob job = jobs[index % jobs.size()];
+            job.id = index;
+            encode_job(job, message);
+            // sends jobs in batches of about 64 kilobytes instead of a write per job.
+            if (message.size() >= 64 * 1024 || index + 1 == count) {
+                if (!write_all(fd, message.data(), message.size())) break;
+                message.clear();
+            }
+        }
+        shutdown(fd, SHUT_WR);
+    });
+
+    size_t received = 0, failed = 0;
+    DaemonMessage kind;
+    std::vector<uint8_t> body;
+    while (received < count && read_message(fd, kind, body)) {
+        DaemonResult result;
+        if (kind != DaemonMessage::Result || !decode_result(body, result)) break;
+        ++received;
+        const bool ok = result.result.error.empty() && result.result.trap == CoreTrap::None;
+        failed += !ok;
+        // only the results of the first round are printed.
+        if (result.id >= jobs.size()) continue;
+        std::cout << names[result.id] << ": ";
+        if (!result.result.error.empty()) {
+            std::cout << "error: " << result.result.error << std::endl;
+            continue;
+        }
+        if (!result.result.checkpoints.empty()) {
+            std::cout << std::hex << result.result.checkpoints.back().hash << std::dec;
+        }
+        if (result.result.trap != CoreTrap::None) std::cout << ", " << trap_name(result.result.trap);
+        if (result.result.halted) std::cout << ", halted in frame " << result.result.halted_frame;
+        if (!result.savestate.empty()) std::cout << ", savestate " << std::hex << fnv1a_hash(result.savestate.data(), result.savestate.size()) << std::dec;
+        std::cout << std::endl;
+    }
+    sender.join();
+    close(fd);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << received << " of " << count << " results in " << seconds << " s, " << received / seconds << " jobs/s, "
+        << failed << " failed" << std::endl;
+    return received == count && failed == 0 ? 0 : 1;
+}
+
+/// the entry point of chip8d, either the daemon or a client submitting jobs to it.
+int main(int argc, char* argv[]) {
+    // a client going away in the middle of a result shows up as a failed write, not a signal.
+    signal(SIGPIPE, SIG_IGN);
+    const std::string mode = argc > 2 ? argv[1] : "";
+    if (mode == "serve") {
+        size_t threads = std::max(1u, std::thread::hardware_concurrency());
+        if (argc > 4 && std::string(argv[3]) == "--jobs") threads = std::max(1, std::stoi(argv[4]));
+        return serve(argv[2], threads);
+    }
+    if (mode == "submit") {
+        std::vector<DaemonJob> jobs;
+        std::vector<std::string> names;
+        size_t repeat = 1;
+        uint8_t outputs = DAEMON_OUTPUT_CHECKPOINTS;
+        for (int arg = 3; arg < argc; ++arg) {
+            const std::string flag = argv[arg];
+            if (flag == "--repeat" && arg + 1 < argc) {
+                repeat = std::max(1, std::stoi(argv[++arg]));
+                continue;
+            }
+            if (flag == "--framebuffer" || flag == "--savestate") {
+                outputs |= flag == "--framebuffer" ? DAEMON_OUTPUT_FRAMEBUFFER : DAEMON_OUTPUT_SAVESTATE;
+                continue;
+            }
+            // a ROM, optionally followed by a comma and its input script.
+            const size_t comma = flag.find(',');
+            DaemonJob job;
+            std::string rom, script;
+            if (!read_file(flag.substr(0, comma), rom)
+                || (comma != std::string::npos && (!read_file(flag.substr(comma + 1), script) || !parse_input_script(script, job.job)))) {
+                std::cerr << "could not read job: " << flag << std::endl;
+                return 2;
+            }
+            job.job.rom.assign(rom.begin(), rom.end());
+            jobs.push_back(job);
+            names.push_back(flag);
+        }
+        for (DaemonJob& job : jobs) job.outputs = outputs;
+        if (!jobs.empty()) return submit(argv[2], jobs, names, repeat);
+    }
+    std::cerr << "usage: chip8d serve <socket> [--jobs <n>]\n"
+                 "       chip8d submit <socket> [--repeat <n>] [--framebuffer] [--savestate] <rom>[,<input script>]..." << std::endl;
+    return 2;
+}
@@ -0,0 +1,206 @@
+// the protocol declarations implemented in this file.
+#include<protocol.hpp>
+
+// gives the read and write functions.
+#include<unistd.h>
+#include<cerrno>
+
+/// appends little endian values to a message.
+struct MessageWriter {
+    /// @brief starts a message of `kind`, its length is filled in by `finish`.
+    MessageWriter(std::vector<uint8_t>& out, DaemonMessage kind) : out(out), start(out.size()) {
+        this->put(0, 4);
+        this->put(static_cast<uint8_t>(kind), 1);
+    }
+
+    void put(uint64_t value, size_t bytes) {
+        for (size_t byte = 0; byte < bytes; ++byte) {
+            this->out.push_back(value >> (byte * 8));
+        }
+    }
+
+    void put_bytes(const void* data, size_t length) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        this->out.insert(this->out.end(), bytes, bytes + length);
+    }
+
+    /// writes the length of the message, everything after the length itself.
+    void finish() {
+        const uint32_t length = this->out.size() - this->start - 4;
+        for (size_t byte = 0; byte < 4; ++byte) {
+            this->out[this->start + byte] = length >> (byte * 8);
+        }
+    }
+
+    std::vector<uint8_t>& out;
+    /// where the message starts in `out`.
+    size_t start;
+};
+
+/// reads little endian values from a message body, remembering if it ever read past the end.
+struct MessageReader {
+    MessageReader(const std::vector<uint8_t>& body) : body(body) {}
+
+    uint64_t get(size_t bytes) {
+        if (this->at + bytes > this->body.size()) {
+            this->broken = true;
+            return 0;
+        }
+        uint64_t value = 0;
+        for (size_t byte = 0; byte < bytes; ++byte) {
+            value |= uint64_t(this->body[this->at++]) << (byte * 8);
+        }
+        return value;
+    }
+
+    /// @brief the next `length` bytes, or null if there aren't as many left.
+    const uint8_t* get_bytes(size_t length) {
+        if (this->at + length > this->body.size()) {
+            this->broken = true;
+            return nullptr;
+        }
+        const uint8_t* bytes = this->body.data() + this->at;
+        this->at += length;
+        return bytes;
+    }
+
+    /// @brief whether every read was inside the body and the whole body was read.
+    bool complete() const {
+        return !this->broken && this->at == this->body.size();
+    }
+
+    const std::vector<uint8_t>& body;
+    size_t at = 0;
+    bool broken = false;
+};
+
+void encode_message(DaemonMessage kind, std::vector<uint8_t>& out) {
+    MessageWriter writer(out, kind);
+    writer.finish();
+}
+
+void encode_job(const DaemonJob& job, std::vector<uint8_t>& out) {
+    MessageWriter writer(out, DaemonMessage::Job);
+    writer.put(job.id, 4);
+    writer.put(job.outputs, 1);
+    writer.put(job.job.frames, 4);
+    writer.put(job.job.checkpoint_interval, 4);
+    writer.put(job.job.seed, 4);
+    writer.put(job.job.instructions_per_frame, 4);
+    writer.put(job.job.rom.size(), 4);
+    writer.put_bytes(job.job.rom.data(), job.job.rom.size());
+    writer.put(job.job.inputs.size(), 4);
+    for (const InputEvent& event : job.job.inputs) {
+        writer.put(event.frame, 4);
+        writer.put(event.hexpad_bitmap, 2);
+    }
+    writer.finish();
+}
+
+bool decode_job(const std::vector<uint8_t>& body, DaemonJob& job) {
+    MessageReader reader(body);
+    job.id = reader.get(4);
+    job.outputs = reader.get(1);
+    job.job.frames = reader.get(4);
+    job.job.checkpoint_interval = reader.get(4);
+    job.job.seed = reader.get(4);
+    job.job.instructions_per_frame = reader.get(4);
+    const size_t rom_length = reader.get(4);
+    const uint8_t* rom = reader.get_bytes(rom_length);
+    if (rom == nullptr) return false;
+    job.job.rom.assign(rom, rom + rom_length);
+    // every event is 6 bytes, a count that can't fit in the body is rejected before reserving room for it.
+    const size_t events = reader.get(4);
+    if (events > body.size() / 6) return false;
+    job.job.inputs.resize(events);
+    for (InputEvent& event : job.job.inputs) {
+        event.frame = reader.get(4);
+        event.hexpad_bitmap = reader.get(2);
+    }
+    return reader.complete();
+}
+
+void encode_result(const DaemonResult& result, std::vector<uint8_t>& out) {
+    MessageWriter writer(out, DaemonMessage::Result);
+    writer.put(result.id, 4);
+    writer.put(static_cast<uint8_t>(result.result.trap), 1);
+    writer.put(result.result.trap_pc, 2);
+    writer.put(result.result.halted, 1);
+    writer.put(result.result.halted_frame, 4);
+    writer.put(result.result.error.size(), 4);
+    writer.put_bytes(result.result.error.data(), result.result.error.size());
+    writer.put(result.result.checkpoints.size(), 4);
+    for (const BatchCheckpoint& checkpoint : result.result.checkpoints) {
+        writer.put(checkpoint.frame, 4);
+        writer.put(checkpoint.hash, 8);
+    }
+    writer.put(result.framebuffer.size(), 4);
+    writer.put_bytes(result.framebuffer.data(), result.framebuffer.size());
+    writer.put(result.savestate.size(), 4);
+    writer.put_bytes(result.savestate.data(), result.savestate.size());
+    writer.finish();
+}
+
+bool decode_result(const std::vector<uint8_t>& body, DaemonResult& result) {
+    MessageReader reader(body);
+    result.id = reader.get(4);
+    const uint8_t trap = reader.get(1);
+    if (trap > static_cast<uint8_t>(CoreTrap::MemoryOutOfBounds)) return false;
+    result.result.trap = static_cast<CoreTrap>(trap);
+    result.result.trap_pc = reader.get(2);
+    result.result.halted = reader.get(1) != 0;
+    result.result.halted_frame = reader.get(4);
+    const size_t error_length = reader.get(4);
+    const uint8_t* error = reader.get_bytes(error_length);
+    if (error == nullptr) return false;
+    result.result.error.assign(error, error + error_length);
+    // every checkpoint is 12 bytes.
+    const size_t checkpoints = reader.get(4);
+    if (checkpoints > body.size() / 12) return false;
+    result.result.checkpoints.resize(checkpoints);
+    for (BatchCheckpoint& checkpoint : result.result.checkpoints) {
+        checkpoint.frame = reader.get(4);
+        checkpoint.hash = reader.get(8);
+    }
+    for (std::vector<uint8_t>* bytes : { &result.framebuffer, &result.savestate }) {
+        const size_t length = reader.get(4);
+        const uint8_t* data = reader.get_bytes(length);
+        if (data == nullptr) return false;
+        bytes->assign(data, data + length);
+    }
+    return reader.complete();
+}
+
+bool write_all(int fd, const void* data, size_t length) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    while (length != 0) {
+        const ssize_t written = write(fd, bytes, length);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return false;
+        bytes += written;
+        length -= written;
+    }
+    return true;
+}
+
+bool read_all(int fd, void* data, size_t length) {
+    uint8_t* bytes = static_cast<uint8_t*>(data);
+    while (length != 0) {
+        const ssize_t count = read(fd, bytes, length);
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) return false;
+        bytes += count;
+        length -= count;
+    }
+    return true;
+}
+
+bool read_message(int fd, DaemonMessage& kind, std::vector<uint8_t>& body) {
+    uint8_t header[5];
+    if (!read_all(fd, header, sizeof(header))) return false;
+    const uint32_t length = header[0] | header[1] << 8 | header[2] << 16 | uint32_t(header[3]) << 24;
+    if (length == 0 || length - 1 > DAEMON_MAX_MESSAGE) return false;
+    kind = static_cast<DaemonMessage>(header[4]);
+    body.resize(length - 1);
+    return read_all(fd, body.data(), body.size());
+}
@@ -0,0 +1,101 @@
+// no duplicate includes.
+#pragma once
+
+// the jobs and results sent over the protocol.
+#include<batch.hpp>
+
+/// @brief the protocol of chip8d, the job daemon, spoken over a Unix domain socket.
+/// @brief
+/// @brief a connection starts with the client sending `DAEMON_HELLO`. After that both sides send messages, each a
+/// @brief little endian `uint32_t` length of what follows, a `uint8_t` `DaemonMessage` and the message body. A client
+/// @brief sends as many jobs as it likes without waiting, and the daemon sends a result for every job as soon as it
+/// @brief finishes, so results can come back in another order than the jobs went out, they carry the id of their job.
+/// @brief The client closes its side of the connection (`shutdown` for writing) once it has sent every job, the
+/// @brief daemon closes the connection after the last result.
+/// @brief
+/// @brief the batch farm (`farm/farm.hpp`) sends the same messages over TCP, with a few of its own kinds.
+
+/// the bytes a client starts a connection with, "C8D" and the protocol version.
+static const uint8_t DAEMON_HELLO[4] = { 'C', '8', 'D', 1 };
+
+/// the largest message either side accepts, a job with a full ROM and a long input script fits easily.
+static const uint32_t DAEMON_MAX_MESSAGE = 16 * 1024 * 1024;
+
+/// the kinds of messages.
+enum class DaemonMessage : uint8_t {
+    /// a job, from the client.
+    Job = 1,
+    /// the result of a job, from the daemon.
+    Result = 2,
+    /// a worker of the batch farm asking for a work unit, see `farm/farm.hpp`.
+    WorkRequest = 3,
+    /// the end of a work unit's jobs, from the farm coordinator.
+    UnitEnd = 4,
+    /// no work unit is free right now, the worker asks again a little later.
+    Wait = 5,
+    /// every job is finished, the worker can go.
+    Done = 6,
+};
+
+/// the outputs a job asks for, combined into a mask.
+enum DaemonOutput : uint8_t {
+    /// the framebuffer hash of every checkpoint.
+    DAEMON_OUTPUT_CHECKPOINTS = 1 << 0,
+    /// the framebuffer the job ended with, a bit per pixel.
+    DAEMON_OUTPUT_FRAMEBUFFER = 1 << 1,
+    /// a savestate of the core the job ended with.
+    DAEMON_OUTPUT_SAVESTATE = 1 << 2,
+};
+
+/// a job sent to the daemon.
+struct DaemonJob {
+    /// chosen by the client, its result carries the same id.
+    uint32_t id = 0;
+    /// the `DaemonOutput` bits of what the result should have.
+    uint8_t outputs = DAEMON_OUTPUT_CHECKPOINTS;
+    /// the job to run, its name isn't sent.
+    BatchJob job;
+};
+
+/// the result of a job.
+struct DaemonResult {
+    /// the id of the job.
+    uint32_t id = 0;
+    /// the result of running the job, without checkpoints unless they were asked for.
+    BatchResult result;
+    /// the framebuffer with a bit per pixel, row by row, the first pixel in the highest bit, if it was asked for.
+    std::vector<uint8_t> framebuffer;
+    /// the savestate, if it was asked for.
+    std::vector<uint8_t> savestate;
+};
+
+/// @brief appends a job message, with its length and kind, to `out`.
+void encode_job(const DaemonJob& job, std::vector<uint8_t>& out);
+
+/// @brief appends a result message, with its length and kind, to `out`.
+void encode_result(const DaemonResult& result, std::vector<uint8_t>& out);
+
+/// @brief appends a message without a body, with its length and kind, to `out`.
+void encode_message(DaemonMessage kind, std::vector<uint8_t>& out);
+
+/// @brief decodes the body of a job message.
+/// @return `false` if the body is broken
+bool decode_job(const std::vector<uint8_t>& body, DaemonJob& job);
+
+/// @brief decodes the body of a result message.
+/// @return `false` if the body is broken
+bool decode_result(const std::vector<uint8_t>& body, DaemonResult& result);
+
+/// @brief writes every byte to a socket, retrying partial writes.
+/// @return `false` if the socket failed or was closed
+bool write_all(int fd, const void* data, size_t length);
+
+/// @brief reads exactly `length` bytes from a socket.
+/// @return `false` if the socket failed or was closed first
+bool read_all(int fd, void* data, size_t length);
+
+/// @brief reads the next message from a socket.
+/// @param kind the kind of the message
+/// @param body the body of the message
+/// @return `false` at the end of the connection, or if the message is broken or too large
+bool read_message(int fd, DaemonMessage& kind, std::vector<uint8_t>& body);
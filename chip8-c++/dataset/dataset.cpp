@@ -0,0 +1,198 @@
+// the dataset declarations implemented in this file.
+#include<dataset.hpp>
+
+// gives the file and memory mapping functions.
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include<fcntl.h>
+#include<unistd.h>
+
+// gives the std::memcpy function.
+#include<cstring>
+
+// gives the std::upper_bound function.
+#include<algorithm>
+
+// the file is written in place, so the atomics in it have to work without a lock.
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "the chunk counters must be lock free to be in a file");
+
+/// @brief rounds `offset` up to a multiple of `alignment`, a power of two.
+static uint64_t align(uint64_t offset, uint64_t alignment) {
+    return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+/// @brief the size of a value of every column, which only the RAM column doesn't fix.
+static void column_sizes(uint32_t ram_count, uint32_t sizes[DATASET_COLUMNS]) {
+    const uint32_t fixed[DATASET_COLUMNS] = { 4, 4, DATASET_FRAMEBUFFER_SIZE, 2, ram_count, 2, 4 };
+    std::copy(fixed, fixed + DATASET_COLUMNS, sizes);
+}
+
+bool DatasetWriter::create(const char* path, const DatasetSettings& settings, DatasetWriter& writer) {
+    if (settings.ram_addresses.size() > DATASET_MAX_RAM || settings.max_frames == 0) return false;
+    const uint64_t max_chunks = (settings.max_frames + DATASET_CHUNK_FRAMES - 1) / DATASET_CHUNK_FRAMES;
+    if (max_chunks > UINT32_MAX) return false;
+
+    DatasetHeader layout = {};
+    layout.magic = DATASET_MAGIC;
+    layout.version = DATASET_VERSION;
+    layout.max_chunks = max_chunks;
+    layout.ram_count = settings.ram_addresses.size();
+    std::copy(settings.ram_addresses.begin(), settings.ram_addresses.end(), layout.ram_addresses);
+    uint32_t sizes[DATASET_COLUMNS];
+    column_sizes(layout.ram_count, sizes);
+    // every column starts on a cache line, and every chunk on a page.
+    uint64_t offset = 0;
+    for (uint32_t column = 0; column < DATASET_COLUMNS; ++column) {
+        layout.column_sizes[column] = sizes[column];
+        layout.column_offsets[column] = offset;
+        offset = align(offset + uint64_t(sizes[column]) * DATASET_CHUNK_FRAMES, 64);
+    }
+    layout.chunk_size = align(offset, 4096);
+    layout.chunks_offset = align(sizeof(DatasetHeader) + max_chunks * sizeof(DatasetChunk), 4096);
+
+    const int fd = ::open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    // a sparse file, disk space is only used by the chunks written.
+    const size_t size = layout.chunks_offset + max_chunks * layout.chunk_size;
+    void* mapping = ftruncate(fd, size) == 0 ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        unlink(path);
+        return false;
+    }
+    writer.path = path;
+    writer.mapping = static_cast<uint8_t*>(mapping);
+    writer.size = size;
+    writer.header = reinterpret_cast<DatasetHeader*>(writer.mapping);
+    writer.chunks = reinterpret_cast<DatasetChunk*>(writer.mapping + sizeof(DatasetHeader));
+    std::memcpy(static_cast<void*>(writer.header), &layout, sizeof(layout));
+    return true;
+}
+
+DatasetWriter::~DatasetWriter() {
+    if (this->mapping == nullptr) return;
+    const uint32_t used = std::min(this->header->chunk_count.load(), this->header->max_chunks);
+    const size_t size = this->header->chunks_offset + used * this->header->chunk_size;
+    munmap(this->mapping, this->size);
+    // cuts the file down to the chunks used. A file that can't be cut is still a valid dataset, only larger on disk.
+    if (truncate(this->path.c_str(), size) != 0) {
+        return;
+    }
+}
+
+int64_t DatasetWriter::take_chunk() {
+    const uint32_t chunk = this->header->chunk_count.fetch_add(1, std::memory_order_relaxed);
+    if (chunk >= this->header->max_chunks) {
+        this->header->chunk_count.store(this->header->max_chunks, std::memory_order_relaxed);
+        return -1;
+    }
+    return chunk;
+}
+
+DatasetAppender::~DatasetAppender() {
+    if (this->chunk >= 0) this->writer.seal(this->chunk, this->frames);
+}
+
+bool DatasetAppender::append(uint32_t trajectory, uint32_t step, const Core& core, uint16_t hexpad_bitmap, float reward) {
+    if (this->chunk < 0 || this->frames == DATASET_CHUNK_FRAMES) {
+        if (this->chunk >= 0) this->writer.seal(this->chunk, this->frames);
+        this->chunk = this->writer.take_chunk();
+        this->frames = 0;
+        if (this->chunk < 0) return false;
+    }
+    const uint32_t chunk = this->chunk, row = this->frames++;
+    const DatasetHeader& layout = this->writer.layout();
+    std::memcpy(this->writer.column(chunk, DATASET_TRAJECTORY) + row * 4, &trajectory, 4);
+    std::memcpy(this->writer.column(chunk, DATASET_STEP) + row * 4, &step, 4);
+    std::memcpy(this->writer.column(chunk, DATASET_HEXPAD) + row * 2, &hexpad_bitmap, 2);
+    std::memcpy(this->writer.column(chunk, DATASET_REWARD) + row * 4, &reward, 4);
+
+    uint8_t* bits = this->writer.column(chunk, DATASET_FRAMEBUFFER) + row * DATASET_FRAMEBUFFER_SIZE;
+    const uint32_t* pixels = core.framebuffer().ptr_begin();
+    for (size_t byte = 0; byte < DATASET_FRAMEBUFFER_SIZE; ++byte) {
+        uint8_t packed = 0;
+        for (size_t bit = 0; bit < 8; ++bit) {
+            packed |= uint8_t(pixels[byte * 8 + bit] == Framebuffer::PIXEL_ON) << (7 - bit);
+        }
+        bits[byte] = packed;
+    }
+    uint8_t* ram = this->writer.column(chunk, DATASET_RAM) + row * layout.ram_count;
+    const std::array<uint8_t, 0x1000>& memory = core.memory();
+    for (uint32_t index = 0; index < layout.ram_count; ++index) {
+        ram[index] = memory[layout.ram_addresses[index] & 0x0fff];
+    }
+    const CoreRegisters registers = core.registers();
+    uint8_t* timers = this->writer.column(chunk, DATASET_TIMERS) + row * 2;
+    timers[0] = registers.timer_delay;
+    timers[1] = registers.timer_sound;
+    return true;
+}
+
+bool DatasetReader::open(const char* path, DatasetReader& reader) {
+    const int fd = ::open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    const size_t size = fstat(fd, &info) == 0 ? info.st_size : 0;
+    void* mapping = size >= sizeof(DatasetHeader) ? mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (mapping == MAP_FAILED) return false;
+    reader.mapping = static_cast<const uint8_t*>(mapping);
+    reader.size = size;
+    reader.header = reinterpret_cast<const DatasetHeader*>(reader.mapping);
+    reader.chunks = reinterpret_cast<const DatasetChunk*>(reader.mapping + sizeof(DatasetHeader));
+    const DatasetHeader& header = *reader.header;
+    if (header.magic != DATASET_MAGIC || header.version != DATASET_VERSION || header.ram_count > DATASET_MAX_RAM
+        || header.chunks_offset < sizeof(DatasetHeader) + uint64_t(header.max_chunks) * sizeof(DatasetChunk)) {
+        return false;
+    }
+    // every column has to have the width a reader expects and fit in a chunk, or reading a frame would go past it.
+    uint32_t sizes[DATASET_COLUMNS];
+    column_sizes(header.ram_count, sizes);
+    for (uint32_t column = 0; column < DATASET_COLUMNS; ++column) {
+        const uint64_t bytes = uint64_t(sizes[column]) * DATASET_CHUNK_FRAMES;
+        if (header.column_sizes[column] != sizes[column] || header.column_offsets[column] > header.chunk_size
+            || bytes > header.chunk_size - header.column_offsets[column]) {
+            return false;
+        }
+    }
+    // every chunk taken has to be in the file, which a writer closing or dying leaves in place. Written so a chunk
+    // count or size made up to overflow the product is caught too.
+    const uint32_t chunk_count = std::min(header.chunk_count.load(), header.max_chunks);
+    if (header.chunk_size == 0 || header.chunks_offset > size || chunk_count > (size - header.chunks_offset) / header.chunk_size) {
+        return false;
+    }
+    // a writer that died leaves the chunks it didn't complete at 0 frames, which are skipped.
+    reader.first_frames.assign(1, 0);
+    for (uint32_t chunk = 0; chunk < chunk_count; ++chunk) {
+        const uint32_t frames = std::min(reader.chunks[chunk].frames.load(std::memory_order_acquire), DATASET_CHUNK_FRAMES);
+        reader.first_frames.push_back(reader.first_frames.back() + frames);
+    }
+    return true;
+}
+
+DatasetReader::~DatasetReader() {
+    if (this->mapping != nullptr) munmap(const_cast<uint8_t*>(this->mapping), this->size);
+}
+
+const uint8_t* DatasetReader::column(uint32_t chunk, DatasetColumn column, uint32_t& frames) const {
+    frames = this->first_frames[chunk + 1] - this->first_frames[chunk];
+    return this->mapping + this->header->chunks_offset + chunk * this->header->chunk_size + this->header->column_offsets[column];
+}
+
+DatasetFrame DatasetReader::frame(uint64_t index) const {
+    // the last chunk whose first frame is at or before `index`.
+    const uint32_t chunk = std::upper_bound(this->first_frames.begin(), this->first_frames.end(), index) - this->first_frames.begin() - 1;
+    const uint32_t row = index - this->first_frames[chunk];
+    uint32_t frames;
+    DatasetFrame frame;
+    std::memcpy(&frame.trajectory, this->column(chunk, DATASET_TRAJECTORY, frames) + row * 4, 4);
+    std::memcpy(&frame.step, this->column(chunk, DATASET_STEP, frames) + row * 4, 4);
+    frame.framebuffer = this->column(chunk, DATASET_FRAMEBUFFER, frames) + row * DATASET_FRAMEBUFFER_SIZE;
+    std::memcpy(&frame.hexpad_bitmap, this->column(chunk, DATASET_HEXPAD, frames) + row * 2, 2);
+    frame.ram = this->column(chunk, DATASET_RAM, frames) + row * this->header->ram_count;
+    const uint8_t* timers = this->column(chunk, DATASET_TIMERS, frames) + row * 2;
+    frame.timer_delay = timers[0];
+    frame.timer_sound = timers[1];
+    std::memcpy(&frame.reward, this->column(chunk, DATASET_REWARD, frames) + row * 4, 4);
+    return frame;
+}
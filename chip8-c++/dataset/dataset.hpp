@@ -0,0 +1,207 @@
+// no duplicate includes.
+#pragma once
+
+// the cores whose frames are recorded.
+#include<core.hpp>
+
+// gives the atomics shared by the threads writing a dataset.
+#include<atomic>
+
+// gives the std::vector type used for the RAM addresses, and the std::string type of the path.
+#include<vector>
+#include<string>
+
+/// @brief a dataset holds trajectories of frames for training, a frame being what the core showed (the observation),
+/// @brief the hexpad it was run with (the action), a few bytes of its memory, its timers and a reward.
+/// @brief
+/// @brief the file is columnar and made to be memory mapped: after a header and an index of chunks, it's a run of
+/// @brief chunks of `DATASET_CHUNK_FRAMES` frames, and in a chunk every column is a plain array, so a reader finds any
+/// @brief value of any frame with a little arithmetic and reads it in place. Every thread writing to a dataset fills
+/// @brief chunks of its own and only touches shared state to take the next chunk. Values are little endian, as the
+/// @brief hosts writing them are.
+
+/// the bytes a dataset starts with, "C8DS".
+static const uint32_t DATASET_MAGIC = 0x53443843;
+/// the version of the layout.
+static const uint32_t DATASET_VERSION = 1;
+/// the amount of frames in a chunk.
+static const uint32_t DATASET_CHUNK_FRAMES = 4096;
+/// the most memory bytes recorded every frame.
+static const uint32_t DATASET_MAX_RAM = 64;
+/// the size of a packed framebuffer, a bit per pixel, row by row, the first pixel in the highest bit.
+static const uint32_t DATASET_FRAMEBUFFER_SIZE = 60 * 60 / 8;
+
+/// the columns of a dataset, in the order they're laid out in a chunk.
+enum DatasetColumn : uint32_t {
+    /// `uint32_t`, the trajectory the frame belongs to.
+    DATASET_TRAJECTORY,
+    /// `uint32_t`, the index of the frame in its trajectory.
+    DATASET_STEP,
+    /// `DATASET_FRAMEBUFFER_SIZE` bytes, the framebuffer after the frame.
+    DATASET_FRAMEBUFFER,
+    /// `uint16_t`, the hexpad bitmap the frame ran with.
+    DATASET_HEXPAD,
+    /// `ram_count` bytes, the recorded memory bytes after the frame.
+    DATASET_RAM,
+    /// 2 bytes, the delay and sound timers after the frame.
+    DATASET_TIMERS,
+    /// `float`, the reward of the frame.
+    DATASET_REWARD,
+    /// the amount of columns.
+    DATASET_COLUMNS,
+};
+
+/// the start of a dataset, followed by `max_chunks` `DatasetChunk`s and then the chunks themselves.
+struct DatasetHeader {
+    /// `DATASET_MAGIC`.
+    uint32_t magic;
+    /// `DATASET_VERSION`.
+    uint32_t version;
+    /// the amount of chunks there's room for.
+    uint32_t max_chunks;
+    /// the amount of chunks taken by writers so far.
+    std::atomic<uint32_t> chunk_count;
+    /// the size of a chunk in bytes.
+    uint64_t chunk_size;
+    /// where the first chunk starts in the file.
+    uint64_t chunks_offset;
+    /// where every column starts in a chunk.
+    uint64_t column_offsets[DATASET_COLUMNS];
+    /// the size of a value of every column.
+    uint32_t column_sizes[DATASET_COLUMNS];
+    /// the amount of memory bytes recorded every frame.
+    uint32_t ram_count;
+    /// the addresses of the recorded memory bytes.
+    uint16_t ram_addresses[DATASET_MAX_RAM];
+};
+
+/// an entry of the index of chunks.
+struct DatasetChunk {
+    /// the amount of frames in the chunk, written once the chunk is complete, 0 until then.
+    std::atomic<uint32_t> frames;
+};
+
+/// how a dataset is laid out.
+struct DatasetSettings {
+    /// the memory addresses recorded every frame, at most `DATASET_MAX_RAM`.
+    std::vector<uint16_t> ram_addresses;
+    /// the most frames the dataset holds. Every writer can leave a chunk partly empty, the file is cut down to the
+    /// chunks used when it's closed.
+    uint64_t max_frames = 1 << 20;
+};
+
+/// creates a dataset and hands out chunks of it to `DatasetAppender`s, on any amount of threads.
+struct DatasetWriter {
+    /// @brief creates the dataset at `path`, replacing any file there.
+    /// @param writer the created writer, only valid if creating succeeds
+    /// @return `false` if the file couldn't be created or mapped, or the settings are invalid
+    static bool create(const char* path, const DatasetSettings& settings, DatasetWriter& writer);
+
+    DatasetWriter() = default;
+    DatasetWriter(const DatasetWriter&) = delete;
+    DatasetWriter& operator=(const DatasetWriter&) = delete;
+    /// closes the dataset, every appender must be gone by then.
+    ~DatasetWriter();
+
+    /// @brief takes the next free chunk.
+    /// @return the chunk, or -1 if the dataset is full
+    int64_t take_chunk();
+
+    /// @brief a column of a chunk.
+    uint8_t* column(uint32_t chunk, DatasetColumn column) const {
+        return this->mapping + this->header->chunks_offset + chunk * this->header->chunk_size + this->header->column_offsets[column];
+    }
+
+    /// @brief marks a chunk as complete with `frames` frames.
+    void seal(uint32_t chunk, uint32_t frames) {
+        this->chunks[chunk].frames.store(frames, std::memory_order_release);
+    }
+
+    /// the layout of the file.
+    const DatasetHeader& layout() const {
+        return *this->header;
+    }
+private:
+    /// the path of the file, to cut it down when it's closed.
+    std::string path;
+    uint8_t* mapping = nullptr;
+    size_t size = 0;
+    DatasetHeader* header = nullptr;
+    DatasetChunk* chunks = nullptr;
+};
+
+/// writes the frames of one thread into a dataset, a chunk at a time.
+struct DatasetAppender {
+    DatasetAppender(DatasetWriter& writer) : writer(writer) {}
+    DatasetAppender(const DatasetAppender&) = delete;
+    DatasetAppender& operator=(const DatasetAppender&) = delete;
+    /// completes the last chunk.
+    ~DatasetAppender();
+
+    /// @brief records a frame the core just ran.
+    /// @param trajectory the trajectory the frame belongs to
+    /// @param step the index of the frame in its trajectory
+    /// @param core the core after the frame
+    /// @param hexpad_bitmap the hexpad the frame ran with
+    /// @param reward the reward of the frame
+    /// @return `false` if the dataset is full
+    bool append(uint32_t trajectory, uint32_t step, const Core& core, uint16_t hexpad_bitmap, float reward);
+private:
+    DatasetWriter& writer;
+    /// the chunk being filled, -1 if none.
+    int64_t chunk = -1;
+    /// the frames in the chunk.
+    uint32_t frames = 0;
+};
+
+/// a frame of a dataset, pointing into the mapped file.
+struct DatasetFrame {
+    uint32_t trajectory;
+    uint32_t step;
+    /// `DATASET_FRAMEBUFFER_SIZE` bytes.
+    const uint8_t* framebuffer;
+    uint16_t hexpad_bitmap;
+    /// `ram_count` bytes, in the order of `ram_addresses`.
+    const uint8_t* ram;
+    uint8_t timer_delay;
+    uint8_t timer_sound;
+    float reward;
+};
+
+/// reads a dataset in place, the file is mapped and nothing is parsed.
+struct DatasetReader {
+    /// @brief maps the dataset at `path`.
+    /// @param reader the opened reader, only valid if opening succeeds
+    /// @return `false` if the file isn't a dataset of this version, or its header doesn't fit its layout or the file
+    static bool open(const char* path, DatasetReader& reader);
+
+    DatasetReader() = default;
+    DatasetReader(const DatasetReader&) = delete;
+    DatasetReader& operator=(const DatasetReader&) = delete;
+    /// unmaps the file.
+    ~DatasetReader();
+
+    /// the amount of frames in the dataset.
+    uint64_t frames() const {
+        return this->first_frames.empty() ? 0 : this->first_frames.back();
+    }
+
+    /// @brief the frame at `index`, in the order of the chunks.
+    DatasetFrame frame(uint64_t index) const;
+
+    /// @brief a column of a chunk, for reading many frames at once.
+    /// @param frames the amount of frames in the chunk
+    const uint8_t* column(uint32_t chunk, DatasetColumn column, uint32_t& frames) const;
+
+    /// the layout of the file.
+    const DatasetHeader& layout() const {
+        return *this->header;
+    }
+private:
+    const uint8_t* mapping = nullptr;
+    size_t size = 0;
+    const DatasetHeader* header = nullptr;
+    const DatasetChunk* chunks = nullptr;
+    /// the index of the first frame of every chunk, and the amount of frames at the end.
+    std::vector<uint64_t> first_frames;
+};
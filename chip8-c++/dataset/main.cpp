@@ -0,0 +1,190 @@
+// gives the io streams, which has the ability to write to the terminal.
+#include<iostream>
+
+// the dataset being written and read.
+#include<dataset.hpp>
+
+// gives the filestreams to read the ROM.
+#include<fstream>
+
+// gives the threads the trajectories are run on.
+#include<thread>
+
+// gives the clock the export and the reads are timed with.
+#include<chrono>
+
+// gives the std::max function.
+#include<algorithm>
+
+/// how the trajectories of an export are run.
+struct ExportSettings {
+    uint32_t trajectories = 1000;
+    uint32_t frames = 600;
+    uint32_t instructions_per_frame = 60;
+    /// the memory address whose change every frame is the reward, -1 for no reward.
+    int32_t reward_address = -1;
+    /// the amount of threads, at least 1.
+    size_t threads = 0;
+};
+
+/// @brief runs the trajectories with random input, the hexpad changing every few frames, and records every frame.
+static int export_dataset(const std::vector<char>& rom, const char* path, const DatasetSettings& settings, const ExportSettings& run) {
+    DatasetWriter writer;
+    if (!DatasetWriter::create(path, settings, writer)) {
+        std::cerr << "could not create dataset: " << path << std::endl;
+        return 1;
+    }
+    const size_t threads = run.threads;
+    std::atomic<uint32_t> next { 0 };
+    std::atomic<uint64_t> frames { 0 };
+    std::atomic<bool> full { false };
+    const auto start = std::chrono::steady_clock::now();
+    // every thread writes its own chunks, the only thing the threads share is taking the next trajectory and chunk.
+    auto worker = [&]() {
+        DatasetAppender appender(writer);
+        uint64_t written = 0;
+        for (uint32_t trajectory = next++; trajectory < run.trajectories && !full; trajectory = next++) {
+            Core core = Core::create(rom.data(), rom.size(), trajectory + 1);
+            uint32_t random = trajectory * 2654435761u + 1;
+            uint16_t hexpad = 0;
+            uint8_t previous = run.reward_address >= 0 ? core.memory()[run.reward_address] : 0;
+            for (uint32_t step = 0; step < run.frames; ++step) {
+                random ^= random << 13;
+                random ^= random >> 17;
+                random ^= random << 5;
+                if (random % 8 == 0) hexpad = random >> 28 < 12 ? 1 << (random >> 28) : 0;
+                core.run_frame(hexpad, run.instructions_per_frame);
+                float reward = 0;
+                if (run.reward_address >= 0) {
+                    const uint8_t value = core.memory()[run.reward_address];
+                    reward = float(value) - float(previous);
+                    previous = value;
+                }
+                if (!appender.append(trajectory, step, core, hexpad, reward)) {
+                    full = true;
+                    break;
+                }
+                ++written;
+            }
+        }
+        frames += written;
+    };
+    std::vector<std::thread> pool;
+    for (size_t thread = 1; thread < threads; ++thread) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << frames << " frames in " << seconds << " s, " << frames / seconds << " frames/s on " << threads << " threads";
+    if (full) std::cout << ", the dataset is full";
+    std::cout << std::endl;
+    return 0;
+}
+
+/// @brief prints what a dataset holds and times reading random frames from it, or prints a single frame.
+static int show_dataset(const char* path, int64_t index) {
+    DatasetReader reader;
+    if (!DatasetReader::open(path, reader)) {
+        std::cerr << "not a dataset: " << path << std::endl;
+        return 1;
+    }
+    const DatasetHeader& layout = reader.layout();
+    if (index < 0) {
+        std::cout << reader.frames() << " frames in " << layout.chunk_count << " chunks, recording " << layout.ram_count << " memory bytes" << std::endl;
+        if (reader.frames() == 0) return 0;
+        const size_t reads = 1000000;
+        uint64_t random = 88172645463325252ull, checksum = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t read = 0; read < reads; ++read) {
+            random ^= random << 13;
+            random ^= random >> 7;
+            random ^= random << 17;
+            const DatasetFrame frame = reader.frame(random % reader.frames());
+            checksum += frame.framebuffer[frame.step % DATASET_FRAMEBUFFER_SIZE] + frame.hexpad_bitmap + frame.timer_delay;
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "random frames: " << reads / seconds << " reads/s (checksum " << checksum << ")" << std::endl;
+        return 0;
+    }
+    if (uint64_t(index) >= reader.frames()) {
+        std::cerr << "the dataset has " << reader.frames() << " frames" << std::endl;
+        return 1;
+    }
+    const DatasetFrame frame = reader.frame(index);
+    std::cout << "trajectory " << frame.trajectory << ", step " << frame.step << ", hexpad " << std::hex << frame.hexpad_bitmap
+        << std::dec << ", delay " << int(frame.timer_delay) << ", sound " << int(frame.timer_sound) << ", reward " << frame.reward << std::endl;
+    for (uint32_t ram = 0; ram < layout.ram_count; ++ram) {
+        std::cout << std::hex << layout.ram_addresses[ram] << ": " << int(frame.ram[ram]) << std::dec << (ram + 1 == layout.ram_count ? "\n" : ", ");
+    }
+    for (size_t y = 0; y < 60; ++y) {
+        for (size_t x = 0; x < 60; ++x) {
+            const size_t pixel = y * 60 + x;
+            std::cout << (frame.framebuffer[pixel / 8] >> (7 - pixel % 8) & 1 ? '#' : '.');
+        }
+        std::cout << '\n';
+    }
+    return 0;
+}
+
+/// @brief parses memory addresses in hexadecimal, separated by commas, with ranges written as `<first>-<last>`.
+static bool parse_addresses(const std::string& text, std::vector<uint16_t>& addresses) {
+    size_t at = 0;
+    while (at < text.size()) {
+        size_t end = text.find(',', at);
+        if (end == std::string::npos) end = text.size();
+        const std::string part = text.substr(at, end - at);
+        const size_t dash = part.find('-');
+        try {
+            const unsigned long first = std::stoul(part.substr(0, dash), nullptr, 16);
+            const unsigned long last = dash == std::string::npos ? first : std::stoul(part.substr(dash + 1), nullptr, 16);
+            if (last > 0x0fff || first > last) return false;
+            for (unsigned long address = first; address <= last; ++address) addresses.push_back(address);
+        } catch (...) {
+            return false;
+        }
+        at = end + 1;
+    }
+    return addresses.size() <= DATASET_MAX_RAM;
+}
+
+/// the entry point of the dataset tool, either exporting trajectories of a ROM or reading a dataset back.
+int main(int argc, char* argv[]) {
+    const std::string mode = argc > 2 ? argv[1] : "";
+    if (mode == "show") {
+        return show_dataset(argv[2], argc > 3 ? std::stoll(argv[3]) : -1);
+    }
+    if (mode == "export" && argc > 3) {
+        std::ifstream ifstream(argv[2], std::ios::binary);
+        std::vector<char> rom((std::istreambuf_iterator<char>(ifstream)), std::istreambuf_iterator<char>());
+        if (!ifstream || rom.size() > 0x1000 - 0x200) {
+            std::cerr << "could not read ROM: " << argv[2] << std::endl;
+            return 2;
+        }
+        DatasetSettings settings;
+        ExportSettings run;
+        bool valid = true;
+        for (int arg = 4; arg < argc && valid; ++arg) {
+            const std::string flag = argv[arg];
+            const bool has_value = arg + 1 < argc;
+            if (flag == "--trajectories" && has_value) run.trajectories = std::stoul(argv[++arg]);
+            else if (flag == "--frames" && has_value) run.frames = std::stoul(argv[++arg]);
+            else if (flag == "--instructions" && has_value) run.instructions_per_frame = std::stoul(argv[++arg]);
+            else if (flag == "--reward" && has_value) run.reward_address = std::stoul(argv[++arg], nullptr, 16) & 0x0fff;
+            else if (flag == "--jobs" && has_value) run.threads = std::stoul(argv[++arg]);
+            else if (flag == "--ram" && has_value) valid = parse_addresses(argv[++arg], settings.ram_addresses);
+            else valid = false;
+        }
+        // room for every frame, and for a partly filled chunk per thread.
+        if (run.threads == 0) run.threads = std::max(1u, std::thread::hardware_concurrency());
+        settings.max_frames = uint64_t(run.trajectories) * run.frames + uint64_t(DATASET_CHUNK_FRAMES) * run.threads;
+        if (valid) return export_dataset(rom, argv[3], settings, run);
+    }
+    std::cerr << "usage: chip8-c++-dataset export <rom> <dataset> [--trajectories <n>] [--frames <n>] [--instructions <n>]\n"
+                 "                                [--ram <addr>[-<addr>],...] [--reward <addr>] [--jobs <n>]\n"
+                 "       chip8-c++-dataset show <dataset> [<frame>]\n"
+                 "addresses are hexadecimal, the reward is the change of the byte at --reward every frame." << std::endl;
+    return 2;
+}
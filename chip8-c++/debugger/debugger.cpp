@@ -0,0 +1,211 @@
+// the debugger declarations implemented in this file.
+#include<debugger.hpp>
+
+void Debugger::add_breakpoint(uint16_t address) {
+    this->breakpoints.set(address & 0x0fff);
+    Debugger::update_pages(this->breakpoints, this->breakpoint_pages);
+}
+
+void Debugger::remove_breakpoint(uint16_t address) {
+    this->breakpoints.reset(address & 0x0fff);
+    Debugger::update_pages(this->breakpoints, this->breakpoint_pages);
+}
+
+void Debugger::add_watchpoint(uint16_t address, uint16_t length, WatchKind kind) {
+    for (uint32_t offset = 0; offset < length && address + offset < 0x1000; ++offset) {
+        if (static_cast<uint8_t>(kind) & static_cast<uint8_t>(WatchKind::Read)) this->read_watches.set(address + offset);
+        if (static_cast<uint8_t>(kind) & static_cast<uint8_t>(WatchKind::Write)) this->write_watches.set(address + offset);
+    }
+    Debugger::update_pages(this->read_watches, this->read_pages);
+    Debugger::update_pages(this->write_watches, this->write_pages);
+}
+
+void Debugger::remove_watchpoint(uint16_t address, uint16_t length, WatchKind kind) {
+    for (uint32_t offset = 0; offset < length && address + offset < 0x1000; ++offset) {
+        if (static_cast<uint8_t>(kind) & static_cast<uint8_t>(WatchKind::Read)) this->read_watches.reset(address + offset);
+        if (static_cast<uint8_t>(kind) & static_cast<uint8_t>(WatchKind::Write)) this->write_watches.reset(address + offset);
+    }
+    Debugger::update_pages(this->read_watches, this->read_pages);
+    Debugger::update_pages(this->write_watches, this->write_pages);
+}
+
+size_t Debugger::add_condition(RegisterCondition condition) {
+    assert(condition.reg <= CONDITION_REG_I);
+    this->conditions.push_back(condition);
+    return this->conditions.size() - 1;
+}
+
+void Debugger::clear_conditions() {
+    this->conditions.clear();
+}
+
+void Debugger::clear() {
+    this->breakpoints.reset();
+    this->read_watches.reset();
+    this->write_watches.reset();
+    this->breakpoint_pages = this->read_pages = this->write_pages = 0;
+    this->conditions.clear();
+}
+
+void Debugger::update_pages(const std::bitset<0x1000>& map, uint16_t& pages) {
+    pages = 0;
+    for (size_t page = 0; page < 16; ++page) {
+        for (size_t address = page * 0x100; address < (page + 1) * 0x100; ++address) {
+            if (map.test(address)) {
+                pages |= 1 << page;
+                break;
+            }
+        }
+    }
+}
+
+DebugEvent Debugger::run_frame(Core& core, uint16_t hexpad_bitmap, size_t instructions) {
+    if (!this->frame_started) {
+        // nothing set, the core runs the frame at full speed.
+        if (!this->active()) {
+            core.run_frame(hexpad_bitmap, instructions);
+            return DebugEvent();
+        }
+        core.begin_frame(hexpad_bitmap);
+        this->frame_instructions = instructions;
+        this->frame_started = true;
+    }
+    DebugEvent event;
+    if (this->active()) {
+        event = this->run_checked(core, this->frame_instructions);
+    } else {
+        // everything was removed while the core was stopped, the rest of the frame doesn't need checking.
+        core.run_for_instructions(this->frame_instructions);
+        this->frame_instructions = 0;
+    }
+    if (this->frame_instructions == 0) {
+        core.tick_timers();
+        this->frame_started = false;
+    }
+    return event;
+}
+
+void Debugger::step() {
+    this->stepping = Stepping::Step;
+}
+
+void Debugger::step_over(const Core& core) {
+    const CoreRegisters registers = core.registers();
+    // only a 2NNN call is stepped over, every other instruction is a single step.
+    if ((core.memory()[registers.pc] >> 4) == 0x2) {
+        this->stepping = Stepping::StepOver;
+        this->step_sp = registers.sp;
+    } else {
+        this->stepping = Stepping::Step;
+    }
+}
+
+void Debugger::step_out(const Core& core) {
+    const CoreRegisters registers = core.registers();
+    // outside of any call there is nothing to step out of, so it's a single step.
+    if (registers.sp > 0) {
+        this->stepping = Stepping::StepOut;
+        this->step_sp = registers.sp;
+    } else {
+        this->stepping = Stepping::Step;
+    }
+}
+
+DebugStop Debugger::check_watchpoints(const Core& core, uint16_t& address) const {
+    const CoreRegisters registers = core.registers();
+    const auto& memory = core.memory();
+    const uint16_t instruction = (memory[registers.pc] << 8) | memory[(registers.pc + 1) & 0x0fff];
+    const uint32_t x = (instruction >> 8) & 0xf;
+
+    // works out which bytes the instruction accesses through i, if any.
+    uint32_t length = 0;
+    WatchKind kind = WatchKind::Read;
+    if ((instruction & 0xf000) == 0xd000) {
+        length = instruction & 0x000f;
+    } else if ((instruction & 0xf0ff) == 0xf033) {
+        length = 3;
+        kind = WatchKind::Write;
+    } else if ((instruction & 0xf0ff) == 0xf055) {
+        length = x + 1;
+        kind = WatchKind::Write;
+    } else if ((instruction & 0xf0ff) == 0xf065) {
+        length = x + 1;
+    }
+    // out of bounds accesses trap without touching memory.
+    if (length == 0 || registers.i + length > 0x1000) {
+        return DebugStop::None;
+    }
+
+    const std::bitset<0x1000>& watches = kind == WatchKind::Read ? this->read_watches : this->write_watches;
+    const uint16_t pages = kind == WatchKind::Read ? this->read_pages : this->write_pages;
+    const uint16_t accessed_pages = (1 << (registers.i >> 8)) | (1 << ((registers.i + length - 1) >> 8));
+    if ((pages & accessed_pages) == 0) {
+        return DebugStop::None;
+    }
+    for (uint32_t offset = 0; offset < length; ++offset) {
+        if (watches.test(registers.i + offset)) {
+            address = registers.i + offset;
+            return kind == WatchKind::Read ? DebugStop::ReadWatch : DebugStop::WriteWatch;
+        }
+    }
+    return DebugStop::None;
+}
+
+DebugEvent Debugger::run_checked(Core& core, size_t& instructions) {
+    while (instructions > 0) {
+        const CoreRegisters before = core.registers();
+        // a waiting, trapped, halted or sleeping core doesn't run anything for the rest of the frame.
+        if (!core.can_run()) {
+            core.run_for_instructions(instructions); // a sleeping core still counts them.
+            instructions = 0;
+            break;
+        }
+
+        // the checks before the instruction runs, skipped for the instruction the core was stopped at.
+        if (!this->resuming) {
+            if (((this->breakpoint_pages >> (before.pc >> 8)) & 1) && this->breakpoints.test(before.pc)) {
+                this->resuming = true;
+                return DebugEvent { DebugStop::Breakpoint, before.pc, before.pc };
+            }
+            if ((this->read_pages | this->write_pages) != 0) {
+                uint16_t address = 0;
+                const DebugStop stop = this->check_watchpoints(core, address);
+                if (stop != DebugStop::None) {
+                    this->resuming = true;
+                    return DebugEvent { stop, before.pc, address };
+                }
+            }
+        }
+        this->resuming = false;
+
+        core.run_for_instructions(1);
+        --instructions;
+        if (core.trap() != CoreTrap::None) {
+            this->stepping = Stepping::None;
+            return DebugEvent { DebugStop::Trap, core.trap_pc(), 0 };
+        }
+
+        // the checks after the instruction ran.
+        const CoreRegisters after = core.registers();
+        for (size_t index = 0; index < this->conditions.size(); ++index) {
+            const RegisterCondition& condition = this->conditions[index];
+            const uint16_t old_value = condition.reg == CONDITION_REG_I ? before.i : before.v[condition.reg];
+            const uint16_t new_value = condition.reg == CONDITION_REG_I ? after.i : after.v[condition.reg];
+            const bool hit = condition.on_change
+                ? old_value != new_value
+                : new_value == condition.value && old_value != condition.value;
+            if (hit) {
+                return DebugEvent { DebugStop::RegisterCondition, after.pc, static_cast<uint16_t>(index) };
+            }
+        }
+        // a call has returned once the stack pointer is back where it was, wherever the return went.
+        const bool step_done = this->stepping == Stepping::Step
+            || (this->stepping == Stepping::StepOver && after.sp <= this->step_sp)
+            || (this->stepping == Stepping::StepOut && after.sp < this->step_sp);
+        if (step_done) {
+            this->stepping = Stepping::None;
+            return DebugEvent { DebugStop::StepComplete, after.pc, 0 };
+        }
+    }
+    return DebugEvent();
+}
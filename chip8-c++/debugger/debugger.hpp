@@ -0,0 +1,166 @@
+// no duplicate includes.
+#pragma once
+
+// the core being debugged.
+#include<core.hpp>
+
+// gives the std::bitset type used for the breakpoint and watchpoint maps.
+#include<bitset>
+
+// gives the std::vector type used for the register conditions.
+#include<vector>
+
+/// why the debugger stopped a core.
+enum class DebugStop : uint8_t {
+    /// the core didn't stop, the requested instructions all ran.
+    None,
+    /// the core reached a breakpoint, the instruction at the breakpoint hasn't run yet.
+    Breakpoint,
+    /// the next instruction reads a watched address, it hasn't run yet.
+    ReadWatch,
+    /// the next instruction writes a watched address, it hasn't run yet.
+    WriteWatch,
+    /// a register condition became true, the instruction that caused it has run.
+    RegisterCondition,
+    /// a step, step over or step out finished.
+    StepComplete,
+    /// the core stopped on a trap, see `Core::trap`.
+    Trap,
+};
+
+/// @brief a short human readable name for a debugger stop, for printing.
+inline const char* debug_stop_name(DebugStop stop) {
+    switch (stop) {
+    case DebugStop::None: return "none";
+    case DebugStop::Breakpoint: return "breakpoint";
+    case DebugStop::ReadWatch: return "read watchpoint";
+    case DebugStop::WriteWatch: return "write watchpoint";
+    case DebugStop::RegisterCondition: return "register condition";
+    case DebugStop::StepComplete: return "step";
+    case DebugStop::Trap: return "trap";
+    }
+    return "unknown";
+}
+
+/// the kind of memory access a watchpoint stops on.
+enum class WatchKind : uint8_t {
+    Read = 1,
+    Write = 2,
+    ReadWrite = 3,
+};
+
+/// a condition on a register that stops the core once it's true.
+struct RegisterCondition {
+    /// the register, 0 to 15 for v0 to vF and 16 for the i register.
+    uint8_t reg;
+    /// whether the condition is the register changing at all, instead of it becoming `value`.
+    bool on_change;
+    /// the value the register has to become, when `on_change` is `false`.
+    uint16_t value;
+};
+
+/// the register index of the i register in a `RegisterCondition`.
+static const uint8_t CONDITION_REG_I = 16;
+
+/// what stopped the core, returned by the debugger's run functions.
+struct DebugEvent {
+    /// why the core stopped, `DebugStop::None` if it didn't.
+    DebugStop reason = DebugStop::None;
+    /// the pc when the core stopped.
+    uint16_t pc = 0;
+    /// the watched address for watchpoints, the index of the condition for register conditions.
+    uint16_t detail = 0;
+};
+
+/// breakpoints, watchpoints, register conditions and stepping for a core.
+///
+/// the core itself knows nothing of the debugger: while nothing is set the debugger calls `Core::run_frame` and adds no
+/// cost at all. Once something is set it runs a single instruction at a time, but only does the expensive checks
+/// where they can matter. The 4096 addresses are split into 16 pages of 256 bytes, with a bit per page telling whether
+/// any breakpoint or watchpoint is inside of it, so most instructions only test a page bit. Memory is only ever accessed
+/// through the i register by DXYN, FX33, FX55 and FX65, so only those are checked against the watchpoints, before
+/// they run, which stops the core with the access still pending.
+struct Debugger {
+    /// @brief stops the core before the instruction at `address` runs.
+    void add_breakpoint(uint16_t address);
+    /// @brief removes the breakpoint at `address`, if there's any.
+    void remove_breakpoint(uint16_t address);
+
+    /// @brief stops the core before an instruction accesses memory in `[address, address + length)`.
+    /// @param kind whether reads, writes or both stop the core
+    void add_watchpoint(uint16_t address, uint16_t length, WatchKind kind);
+    /// @brief removes the watchpoints of `kind` in `[address, address + length)`.
+    void remove_watchpoint(uint16_t address, uint16_t length, WatchKind kind);
+
+    /// @brief stops the core after an instruction makes `condition` true.
+    /// @return the index of the condition, reported in `DebugEvent::detail`
+    size_t add_condition(RegisterCondition condition);
+    /// @brief removes every register condition.
+    void clear_conditions();
+
+    /// removes every breakpoint, watchpoint and register condition.
+    void clear();
+
+    /// @brief runs a frame of the core, like `Core::run_frame`, stopping when a breakpoint, watchpoint or condition hits.
+    /// @brief if the previous call stopped in the middle of a frame, the rest of that frame runs instead of a new one,
+    /// @brief and the arguments are ignored. The instruction the core stopped at doesn't stop it again.
+    /// @return why the core stopped, `DebugStop::None` if the frame finished
+    DebugEvent run_frame(Core& core, uint16_t hexpad_bitmap, size_t instructions);
+
+    /// makes the next `run_frame` stop after a single instruction.
+    void step();
+    /// @brief makes the next `run_frame` stop after the next instruction, running a whole call if the instruction is a 2NNN call.
+    void step_over(const Core& core);
+    /// @brief makes the next `run_frame` stop once the current call returns.
+    void step_out(const Core& core);
+
+    /// whether `run_frame` stopped in the middle of a frame that hasn't finished yet.
+    bool in_frame() const {
+        return this->frame_started;
+    }
+private:
+    /// @brief runs up to `instructions` instructions one at a time, checking everything that is set.
+    /// @return why the core stopped, `instructions` is decremented for every instruction that ran
+    DebugEvent run_checked(Core& core, size_t& instructions);
+
+    /// @brief checks whether the instruction at pc accesses watched memory.
+    /// @return `DebugStop::None`, or the watchpoint and the address through `address`
+    DebugStop check_watchpoints(const Core& core, uint16_t& address) const;
+
+    /// @brief recalculates the page bits of `map` into `pages`.
+    static void update_pages(const std::bitset<0x1000>& map, uint16_t& pages);
+
+    /// whether anything needs `run_checked`, otherwise the core runs unchecked.
+    bool active() const {
+        return this->breakpoint_pages != 0 || this->read_pages != 0 || this->write_pages != 0
+            || !this->conditions.empty() || this->stepping != Stepping::None;
+    }
+
+    /// the kinds of stepping.
+    enum class Stepping : uint8_t { None, Step, StepOver, StepOut };
+
+    /// the addresses with a breakpoint.
+    std::bitset<0x1000> breakpoints;
+    /// the addresses watched for reads.
+    std::bitset<0x1000> read_watches;
+    /// the addresses watched for writes.
+    std::bitset<0x1000> write_watches;
+    /// a bit for every page with a breakpoint in it.
+    uint16_t breakpoint_pages = 0;
+    /// a bit for every page with a read watchpoint in it.
+    uint16_t read_pages = 0;
+    /// a bit for every page with a write watchpoint in it.
+    uint16_t write_pages = 0;
+    /// the register conditions.
+    std::vector<RegisterCondition> conditions;
+    /// the pending step.
+    Stepping stepping = Stepping::None;
+    /// the stack pointer when the step over or step out was started.
+    uint8_t step_sp = 0;
+    /// whether a frame was started by `run_frame` and hasn't finished.
+    bool frame_started = false;
+    /// the instructions left in the started frame.
+    size_t frame_instructions = 0;
+    /// whether the core stopped before an instruction, which shouldn't stop it again when resuming.
+    bool resuming = false;
+};
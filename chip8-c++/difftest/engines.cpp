@@ -0,0 +1,192 @@
+// the engine declarations implemented in this file.
+#include<engines.hpp>
+
+// the engines built on the other ways of running cores.
+#include<session_pool.hpp>
+#include<scheduler.hpp>
+#include<debugger.hpp>
+
+/// gives the hexpad bitmap of every frame of a job in order, from its input events.
+struct JobInput {
+    JobInput(const BatchJob& job) : job(job) {}
+
+    /// @brief the bitmap of `frame`, frames must be asked for in order.
+    uint16_t at(uint32_t frame) {
+        while (this->next < this->job.inputs.size() && this->job.inputs[this->next].frame <= frame) {
+            this->bitmap = this->job.inputs[this->next++].hexpad_bitmap;
+        }
+        return this->bitmap;
+    }
+
+    const BatchJob& job;
+    /// the next event to apply.
+    size_t next = 0;
+    /// the bitmap of the last frame asked for.
+    uint16_t bitmap = 0;
+};
+
+/// @brief creates the core of a job.
+static Core job_core(const BatchJob& job) {
+    return Core::create(job.rom.data(), job.rom.size(), job.seed);
+}
+
+/// @brief runs every instruction on its own.
+/// @param fast_paths whether the core halts and sleeps, see `Core::set_fast_paths`
+static Core run_each_instruction(const BatchJob& job, bool fast_paths) {
+    Core core = job_core(job);
+    core.set_fast_paths(fast_paths);
+    JobInput input(job);
+    for (uint32_t frame = 0; frame < job.frames; ++frame) {
+        core.begin_frame(input.at(frame));
+        for (uint32_t instruction = 0; instruction < job.instructions_per_frame; ++instruction) {
+            core.run_for_instructions(1);
+        }
+        core.tick_timers();
+    }
+    return core;
+}
+
+/// runs every instruction without halting or sleeping, the reference the others are compared against.
+static Core run_reference(const BatchJob& job) {
+    return run_each_instruction(job, false);
+}
+
+/// runs every instruction on its own.
+static Core run_instructions(const BatchJob& job) {
+    return run_each_instruction(job, true);
+}
+
+/// runs whole frames with `Core::run_frame`.
+static Core run_frames(const BatchJob& job) {
+    Core core = job_core(job);
+    JobInput input(job);
+    for (uint32_t frame = 0; frame < job.frames; ++frame) {
+        core.run_frame(input.at(frame), job.instructions_per_frame);
+    }
+    return core;
+}
+
+/// a session playing back a job.
+struct JobSession : Session {
+    JobSession(const BatchJob& job) : Session(job_core(job), job.instructions_per_frame), input(job) {}
+
+    bool frame_begin(uint64_t frame, uint16_t& hexpad_bitmap) override {
+        if (frame == this->input.job.frames) return false;
+        hexpad_bitmap = this->input.at(frame);
+        return true;
+    }
+
+    JobInput input;
+};
+
+/// runs a `Session` with a budget of 3 instructions, which splits frames at every possible point.
+static Core run_session(const BatchJob& job) {
+    JobSession session(job);
+    while (session.resume(3) != SessionYield::Done) {}
+    return session.core();
+}
+
+/// runs the core through a `CoreScheduler`, which parks it while it waits for a key or sleeps.
+static Core run_scheduler(const BatchJob& job) {
+    std::vector<Core> cores = { job_core(job) };
+    CoreScheduler scheduler(1, job.instructions_per_frame);
+    JobInput input(job);
+    uint16_t bitmap = 0;
+    for (uint32_t frame = 0; frame < job.frames; ++frame) {
+        bitmap = input.at(frame);
+        for (uint32_t index : scheduler.begin_frame(cores, [&](size_t) { return bitmap; })) {
+            cores[index].run_frame(bitmap, job.instructions_per_frame);
+        }
+        scheduler.end_frame(cores);
+    }
+    scheduler.sync(cores, [&](size_t) { return bitmap; });
+    return cores[0];
+}
+
+/// moves the state to another core through a savestate after every frame.
+static Core run_savestates(const BatchJob& job) {
+    Core core = job_core(job);
+    // starts out as a different core, so anything a savestate leaves out shows up.
+    Core other = Core::create(nullptr, 0, job.seed + 1);
+    std::vector<uint8_t> state(Core::SAVESTATE_SIZE);
+    JobInput input(job);
+    for (uint32_t frame = 0; frame < job.frames; ++frame) {
+        core.run_frame(input.at(frame), job.instructions_per_frame);
+        core.save_state(state.data());
+        const bool loaded = other.load_state(state.data());
+        assert(loaded);
+        (void) loaded;
+        std::swap(core, other);
+    }
+    return core;
+}
+
+/// runs the core under a `Debugger`, which checks every instruction once anything is set.
+static Core run_debugger(const BatchJob& job) {
+    Core core = job_core(job);
+    Debugger debugger;
+    // a breakpoint the generated programs don't reach, it only makes the debugger check every instruction.
+    debugger.add_breakpoint(0x001);
+    JobInput input(job);
+    for (uint32_t frame = 0; frame < job.frames; ++frame) {
+        const uint16_t bitmap = input.at(frame);
+        do {
+            debugger.run_frame(core, bitmap, job.instructions_per_frame);
+        } while (debugger.in_frame());
+    }
+    return core;
+}
+
+/// runs the job like the batch runner, which skips over the frames a core can't run in.
+static Core run_batch_job(const BatchJob& job) {
+    return replay_job(job, job.frames);
+}
+
+const std::vector<DiffEngine>& diff_engines() {
+    static const std::vector<DiffEngine> engines = {
+        { "reference", run_reference, true },
+        { "instructions", run_instructions, true },
+        { "frames", run_frames, true },
+        { "session", run_session, true },
+        { "scheduler", run_scheduler, true },
+        { "savestates", run_savestates, true },
+        { "debugger", run_debugger, true },
+        // stops at a trap, so the timers of a trapped core aren't ticked to the end.
+        { "batch", run_batch_job, false },
+    };
+    return engines;
+}
+
+uint64_t state_hash(const Core& core) {
+    // a halted or sleeping core is compared as where it would be without fast paths, which is what the reference has.
+    Core settled = core;
+    settled.set_fast_paths(false);
+    std::vector<uint8_t> state(Core::SAVESTATE_SIZE);
+    settled.save_state(state.data());
+    return fnv1a_hash(state.data(), state.size());
+}
+
+/// @brief hashes what every engine keeps up to date, the framebuffer and the trap. Whether the core halted isn't
+/// @brief part of it, the reference never halts.
+static uint64_t outcome_hash(const Core& core) {
+    return framebuffer_hash(core.framebuffer()) ^ uint64_t(core.trap()) << 56;
+}
+
+DiffResult diff_job(const BatchJob& job) {
+    DiffResult result;
+    const std::vector<DiffEngine>& engines = diff_engines();
+    const Core reference = engines[0].run(job);
+    const uint64_t reference_state = state_hash(reference), reference_outcome = outcome_hash(reference);
+    for (size_t index = 1; index < engines.size(); ++index) {
+        const Core core = engines[index].run(job);
+        const uint64_t expected = engines[index].whole_state ? reference_state : reference_outcome;
+        const uint64_t actual = engines[index].whole_state ? state_hash(core) : outcome_hash(core);
+        if (expected != actual) {
+            result.engine = engines[index].name;
+            result.expected = expected;
+            result.actual = actual;
+            break;
+        }
+    }
+    return result;
+}
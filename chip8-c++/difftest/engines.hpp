@@ -0,0 +1,41 @@
+// no duplicate includes.
+#pragma once
+
+// the jobs the engines run.
+#include<batch.hpp>
+
+// gives the std::vector type.
+#include<vector>
+
+/// a way of running a job, all of which must end in the same state.
+struct DiffEngine {
+    /// the name of the engine, for reports.
+    const char* name;
+    /// @brief runs a job to its last frame.
+    /// @return the core after the last frame
+    Core (*run)(const BatchJob& job);
+    /// whether the whole state is compared, or only the framebuffer and trap, which is all the engine keeps up to
+    /// date once a core stops.
+    bool whole_state;
+};
+
+/// @brief every engine. The first one runs an instruction at a time with halting and sleeping turned off (see
+/// @brief `Core::set_fast_paths`), and is what the others are compared against.
+const std::vector<DiffEngine>& diff_engines();
+
+/// @brief hashes the whole state of a core, its savestate, identical states always have identical hashes. A halted or
+/// @brief sleeping core is hashed as it would be with fast paths turned off.
+uint64_t state_hash(const Core& core);
+
+/// the first disagreement between the engines on a job.
+struct DiffResult {
+    /// the engine disagreeing with the first engine, `nullptr` if they all agree.
+    const char* engine = nullptr;
+    /// the hash the first engine ended with, a `state_hash` or a `framebuffer_hash`.
+    uint64_t expected = 0;
+    /// the hash the disagreeing engine ended with.
+    uint64_t actual = 0;
+};
+
+/// @brief runs a job on every engine and compares how they end.
+DiffResult diff_job(const BatchJob& job);
@@ -0,0 +1,176 @@
+// gives the io streams, which has the ability to write to the terminal.
+#include<iostream>
+
+// the generator of the programs.
+#include<proggen.hpp>
+
+// the engines the programs are run on.
+#include<engines.hpp>
+
+// runs the programs on every hardware thread.
+#include<worker_pool.hpp>
+
+// gives the filestreams to write failing programs.
+#include<fstream>
+
+// gives the functions to create the output directory.
+#include<filesystem>
+
+// gives the std::sort function.
+#include<algorithm>
+
+// gives the std::snprintf function.
+#include<cstdio>
+
+/// a program the engines disagreed on.
+struct Failure {
+    /// the seed the program was generated from.
+    uint64_t seed;
+    /// the first disagreement on the generated program.
+    DiffResult result;
+    /// the program after minimizing.
+    BatchJob minimized;
+};
+
+/// a program an earlier version of the core got wrong, run before the generated ones every time.
+struct RegressionProgram {
+    /// the name it's reported under.
+    const char* name;
+    /// the instructions, from 0x200 on.
+    std::vector<uint16_t> words;
+};
+
+/// @brief the regression programs, `NOP_INSTRUCTION`s fill the gaps up to the jump at 0x220.
+static std::vector<RegressionProgram> regression_programs() {
+    const uint16_t n = NOP_INSTRUCTION;
+    return {
+        // a register-only loop was remembered after the core left it, so coming back to it later looked like it had
+        // gone around with the same registers and halted the core.
+        { "stale-halt-loop", { 0x6000, 0x7001, 0x3002, 0x1204, 0x6000, 0xf118, 0x7100, 0x00e0, 0x1220, n, n, n, n, n, n, n, 0x1202 } },
+        { "stale-halt-loop-reentered", { 0x6000, 0x7001, 0x3002, 0x1202, 0x00e0, 0xf118, 0x1220, n, n, n, n, n, n, n, n, n, 0x1200 } },
+    };
+}
+
+/// @brief the job running a regression program for a few seconds.
+static BatchJob regression_job(const RegressionProgram& program) {
+    BatchJob job;
+    job.name = program.name;
+    for (uint16_t word : program.words) {
+        job.rom.push_back(char(word >> 8));
+        job.rom.push_back(char(word & 0xff));
+    }
+    job.frames = 180;
+    return job;
+}
+
+/// @brief formats a hash as 16 hexadecimal digits.
+static std::string hash_hex(uint64_t hash) {
+    char text[17];
+    std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(hash));
+    return text;
+}
+
+/// @brief writes a job as a ROM and an input script next to it, which the regression runner can run as it is.
+/// @return `false` if a file couldn't be written
+static bool write_job(const std::filesystem::path& rom_path, const BatchJob& job) {
+    std::ofstream rom(rom_path, std::ios::binary);
+    rom.write(job.rom.data(), job.rom.size());
+    std::ofstream script(rom_path.string() + ".inputs");
+    script << "frames " << job.frames << "\n"
+           << "checkpoint " << job.checkpoint_interval << "\n"
+           << "instructions " << job.instructions_per_frame << "\n"
+           << "seed " << job.seed << "\n";
+    for (const InputEvent& event : job.inputs) {
+        script << event.frame << " " << std::hex << event.hexpad_bitmap << std::dec << "\n";
+    }
+    return bool(rom) && bool(script);
+}
+
+/// the entry point of the differential tester, generates programs, runs them on every engine and minimizes the ones
+/// the engines disagree on.
+int main(int argc, char* argv[]) {
+    ProgramSettings settings;
+    uint64_t first_seed = 1;
+    size_t count = 1000, threads = 0;
+    std::filesystem::path out_dir;
+    for (int arg = 1; arg < argc; ++arg) {
+        std::string flag = argv[arg];
+        const bool has_value = arg + 1 < argc;
+        if (flag == "--seed" && has_value) first_seed = std::stoull(argv[++arg]);
+        else if (flag == "--count" && has_value) count = std::stoul(argv[++arg]);
+        else if (flag == "--instructions" && has_value) settings.instructions = std::stoul(argv[++arg]);
+        else if (flag == "--frames" && has_value) settings.frames = std::stoul(argv[++arg]);
+        else if (flag == "--jobs" && has_value) threads = std::stoul(argv[++arg]);
+        else if (flag == "--out" && has_value) out_dir = argv[++arg];
+        else if (flag == "--mix" && has_value) {
+            if (!settings.mix.parse(argv[++arg])) {
+                std::cerr << "could not parse mix: " << argv[arg] << std::endl;
+                return 2;
+            }
+        } else {
+            std::cerr << "usage: chip8-c++-difftest [--seed <n>] [--count <n>] [--instructions <n>] [--frames <n>]\n"
+                         "                          [--mix <class>=<weight>,...] [--out <dir>] [--jobs <n>]\n"
+                         "the classes are";
+            for (size_t index = 0; index < OPCODE_CLASSES; ++index) {
+                std::cerr << " " << opcode_class_name(static_cast<OpcodeClass>(index));
+            }
+            std::cerr << std::endl;
+            return 2;
+        }
+    }
+    // the program and its data have to fit in memory.
+    if (settings.instructions == 0 || settings.instructions > 1500 || settings.frames == 0) {
+        std::cerr << "--instructions must be between 1 and 1500 and --frames above zero" << std::endl;
+        return 2;
+    }
+
+    // the regression programs are already as small as they get, so they're only reported.
+    size_t regressions_failed = 0;
+    for (const RegressionProgram& program : regression_programs()) {
+        const DiffResult result = diff_job(regression_job(program));
+        if (result.engine == nullptr) continue;
+        std::cout << program.name << ": " << result.engine << " differs, expected " << hash_hex(result.expected)
+            << " got " << hash_hex(result.actual) << std::endl;
+        ++regressions_failed;
+    }
+
+    std::vector<Failure> failures;
+    std::mutex failures_mutex;
+    WorkerPool pool(threads != 0 ? threads : std::max(1u, std::thread::hardware_concurrency()));
+    pool.run(count, [&](size_t index) {
+        const uint64_t seed = first_seed + index;
+        const BatchJob job = generate_job(seed, settings);
+        const DiffResult result = diff_job(job);
+        if (result.engine == nullptr) return;
+        const BatchJob minimized = minimize_job(job, [](const BatchJob& candidate) {
+            return diff_job(candidate).engine != nullptr;
+        });
+        std::lock_guard<std::mutex> lock(failures_mutex);
+        failures.push_back({ seed, result, minimized });
+    });
+    std::sort(failures.begin(), failures.end(), [](const Failure& a, const Failure& b) { return a.seed < b.seed; });
+
+    if (!out_dir.empty() && !failures.empty()) {
+        std::filesystem::create_directories(out_dir);
+    }
+    for (const Failure& failure : failures) {
+        size_t instructions = 0;
+        for (size_t word = 0; word + 1 < failure.minimized.rom.size(); word += 2) {
+            const uint16_t instruction = uint8_t(failure.minimized.rom[word]) << 8 | uint8_t(failure.minimized.rom[word + 1]);
+            if (instruction != NOP_INSTRUCTION) ++instructions;
+        }
+        std::cout << "seed " << failure.seed << ": " << failure.result.engine << " differs, expected "
+            << hash_hex(failure.result.expected) << " got " << hash_hex(failure.result.actual) << ", minimized to "
+            << instructions << " words and " << failure.minimized.frames << " frames";
+        if (!out_dir.empty()) {
+            const std::filesystem::path path = out_dir / (failure.minimized.name + ".ch8");
+            if (write_job(path, failure.minimized)) std::cout << ", written to " << path.string();
+            else std::cout << ", could not write " << path.string();
+        }
+        std::cout << std::endl;
+    }
+    std::cout << count << " programs, " << failures.size() << " with engines disagreeing";
+    if (regressions_failed != 0) std::cout << ", " << regressions_failed << " regression programs failing";
+    std::cout << std::endl;
+    return failures.empty() && regressions_failed == 0 ? 0 : 1;
+}
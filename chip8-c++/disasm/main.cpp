@@ -0,0 +1,81 @@
+// gives the io streams, which has the ability to write to the terminal.
+#include<iostream>
+
+// the analysis being printed.
+#include<analysis.hpp>
+
+// gives the filestreams to read the ROM.
+#include<fstream>
+
+// gives the std::printf function, used to line up the listing.
+#include<cstdio>
+
+// gives the std::vector type the ROM is read into.
+#include<vector>
+
+// gives the std::min function.
+#include<algorithm>
+
+/// @brief prints the analysis of a ROM as a listing: code as instructions with labels for functions, jumps
+/// @brief and loops, and data as bytes.
+static void print_listing(const RomAnalysis& analysis, const Core& core, size_t rom_length) {
+    const auto& memory = core.memory();
+    const size_t end = std::min<size_t>(0x200 + rom_length, 0x1000);
+    for (size_t address = 0x200; address < end;) {
+        if (analysis.has(address, ADDRESS_FUNCTION)) std::printf("\nfunction_%03zx:\n", address);
+        else if (analysis.has(address, ADDRESS_LOOP_HEADER)) std::printf("loop_%03zx:\n", address);
+        else if (analysis.has(address, ADDRESS_JUMP_TARGET)) std::printf("label_%03zx:\n", address);
+
+        if (analysis.has(address, ADDRESS_INSTRUCTION)) {
+            const uint16_t instruction = (memory[address] << 8) | memory[(address + 1) & 0x0fff];
+            std::printf("  %03zx  %04x  %-18s", address, instruction, disassemble_instruction(instruction).c_str());
+            if (analysis.has(address, ADDRESS_COMPUTED_JUMP)) std::printf(" ; computed jump");
+            if (analysis.has(address, ADDRESS_SELF_MODIFYING)) std::printf(" ; writes into code");
+            if (analysis.has(address, ADDRESS_INVALID)) std::printf(" ; invalid, traps");
+            std::printf("\n");
+            address += 2;
+        } else {
+            // a run of data, printed 8 bytes to a line.
+            std::printf("  %03zx  .byte", address);
+            for (size_t count = 0; count < 8 && address < end && !analysis.has(address, ADDRESS_INSTRUCTION); ++count, ++address) {
+                std::printf(" %02x", memory[address]);
+            }
+            std::printf("\n");
+        }
+    }
+}
+
+/// the entry point of the disassembler, prints a listing of a ROM followed by a summary of its control flow.
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cout << "usage: chip8-c++-disasm <rom>" << std::endl;
+        return -1;
+    }
+    std::ifstream ifstream(argv[1], std::ios::binary);
+    if (!ifstream) {
+        std::cout << "could not read ROM: " << argv[1] << std::endl;
+        return -1;
+    }
+    std::vector<char> rom((std::istreambuf_iterator<char>(ifstream)), std::istreambuf_iterator<char>());
+    if (rom.size() > 0x1000 - 0x200) {
+        std::cout << "ROM is too large to be loaded" << std::endl;
+        return -1;
+    }
+    const Core core = Core::create(rom.data(), rom.size());
+    const RomAnalysis analysis = analyze_rom(rom.data(), rom.size());
+
+    print_listing(analysis, core, rom.size());
+
+    size_t code_bytes = 0;
+    for (size_t address = 0x200; address < 0x200 + rom.size(); ++address) {
+        code_bytes += analysis.has(address, ADDRESS_CODE);
+    }
+    std::printf("\n; %zu of %zu bytes are code, %zu blocks, %zu functions, %zu loops, %zu computed jumps, %zu writes into code\n",
+        code_bytes, rom.size(), analysis.blocks.size(), analysis.functions.size(), analysis.loops.size(),
+        analysis.computed_jumps.size(), analysis.self_modifying_writes.size());
+    for (const Function& function : analysis.functions) {
+        std::printf("; function_%03x: %zu blocks", function.entry, function.blocks.size());
+        for (uint16_t call : function.calls) std::printf(", calls function_%03x", call);
+        std::printf("\n");
+    }
+}
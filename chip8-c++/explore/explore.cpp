@@ -0,0 +1,34 @@
+// the exploration declarations implemented in this file.
+#include<explore.hpp>
+
+// runs the clones on several threads.
+#include<worker_pool.hpp>
+
+ExploreResult run_branch(Core& core, const ExploreBranch& branch, size_t instructions_per_frame, const ExploreScore& score) {
+    ExploreResult result;
+    for (uint16_t hexpad_bitmap : branch.hexpad) {
+        core.run_frame(hexpad_bitmap, instructions_per_frame);
+    }
+    uint8_t state[Core::SAVESTATE_SIZE];
+    core.save_state(state);
+    const Framebuffer& fb = core.framebuffer();
+    result.state_hash = fnv1a_hash(state, sizeof(state));
+    result.framebuffer_hash = fnv1a_hash(fb.ptr_begin(), fb.len() * sizeof(uint32_t));
+    result.score = score ? score(core) : 0;
+    result.frames = branch.hexpad.size();
+    result.trap = core.trap();
+    result.halted = core.halted();
+    result.finished = true;
+    return result;
+}
+
+std::vector<ExploreResult> explore_clones(const Core& start, const std::vector<ExploreBranch>& branches,
+    size_t instructions_per_frame, const ExploreScore& score, size_t threads) {
+    std::vector<ExploreResult> results(branches.size());
+    WorkerPool pool(threads != 0 ? threads : std::max(1u, std::thread::hardware_concurrency()));
+    pool.run(branches.size(), [&](size_t index) {
+        Core core = start;
+        results[index] = run_branch(core, branches[index], instructions_per_frame, score);
+    });
+    return results;
+}
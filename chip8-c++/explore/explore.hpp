@@ -0,0 +1,58 @@
+// no duplicate includes.
+#pragma once
+
+// the cores being explored.
+#include<core.hpp>
+
+// gives the std::vector type.
+#include<vector>
+
+// gives the std::function type of the scores.
+#include<functional>
+
+/// a branch of an exploration: the input a copy of the starting core continues with.
+struct ExploreBranch {
+    /// the hexpad bitmap of every frame, the branch runs one frame per entry.
+    std::vector<uint16_t> hexpad;
+};
+
+/// how a branch ended. Kept to plain fixed size fields, so the fork server can send it through a pipe as it is.
+struct ExploreResult {
+    /// the hash of the core's savestate, identical states always have identical hashes.
+    uint64_t state_hash = 0;
+    /// the `fnv1a_hash` of the framebuffer's pixels.
+    uint64_t framebuffer_hash = 0;
+    /// what the branch's score function returned.
+    uint64_t score = 0;
+    /// the amount of frames run.
+    uint32_t frames = 0;
+    /// the trap the core stopped on, if any.
+    CoreTrap trap = CoreTrap::None;
+    /// whether the core halted, see `Core::halted`.
+    bool halted = false;
+    /// whether the branch ran to its end, `false` if the process running it died first (fork server only).
+    bool finished = false;
+};
+
+/// @brief scores the core at the end of a branch, with whatever the caller is looking for (how far a player got,
+/// @brief how much of the screen is lit). Called on the thread or in the process that ran the branch.
+using ExploreScore = std::function<uint64_t(const Core&)>;
+
+/// @brief runs a branch on a core.
+/// @param core the core to continue, changed by the branch
+/// @param branch the input to continue with
+/// @param instructions_per_frame the amount of instructions every frame runs
+/// @param score scores the core at the end, or empty to leave the score at 0
+ExploreResult run_branch(Core& core, const ExploreBranch& branch, size_t instructions_per_frame, const ExploreScore& score);
+
+/// @brief runs every branch on its own copy of `start`, spread over threads. Copying a core is a plain copy of a few
+/// @brief kilobytes, so this is the cheapest way to explore from a state when everything the branches need is in the core.
+/// @brief See `ForkServer` for exploring when the host has a lot of its own data to go with every state.
+/// @param start the state every branch continues from
+/// @param branches the branches
+/// @param instructions_per_frame the amount of instructions every frame runs
+/// @param score scores every branch, called from several threads at once
+/// @param threads the amount of threads, 0 uses one per hardware thread
+/// @return the result of every branch, in the same order as `branches`
+std::vector<ExploreResult> explore_clones(const Core& start, const std::vector<ExploreBranch>& branches,
+    size_t instructions_per_frame, const ExploreScore& score, size_t threads = 0);
@@ -0,0 +1,348 @@
+// the farm declarations implemented in this file.
+#include<farm.hpp>
+
+// gives the TCP socket functions.
+#include<sys/socket.h>
+#include<netinet/in.h>
+#include<netinet/tcp.h>
+#include<netdb.h>
+#include<poll.h>
+#include<unistd.h>
+#include<cerrno>
+
+// gives the clock the leases are timed with, and the sleeps of waiting workers.
+#include<chrono>
+#include<thread>
+
+// gives the std::equal and std::min functions.
+#include<algorithm>
+
+// gives the std::iostream, the coordinator reports workers coming and going.
+#include<iostream>
+
+using FarmClock = std::chrono::steady_clock;
+
+/// a range of jobs handed out together.
+struct FarmUnit {
+    /// the first job of the unit.
+    size_t first;
+    /// the amount of jobs in the unit.
+    size_t count;
+    /// the jobs of the unit without a result yet.
+    size_t remaining;
+    /// the amount of times the unit was handed out.
+    uint32_t attempts = 0;
+    /// the connection working on the unit, -1 if no worker has it.
+    int owner = -1;
+    /// when the unit was last handed out.
+    FarmClock::time_point leased_at;
+};
+
+/// a worker connected to the coordinator.
+struct FarmConnection {
+    int fd;
+    /// whether the worker sent `FARM_HELLO`.
+    bool greeted = false;
+    /// the bytes received that don't make up a whole message yet.
+    std::vector<uint8_t> input;
+};
+
+/// @brief sets TCP_NODELAY, the messages are small and every one of them is waited for.
+static void set_no_delay(int fd) {
+    const int enable = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+}
+
+/// the coordinator's side of a farm run.
+struct Coordinator {
+    Coordinator(const std::vector<BatchJob>& jobs, const FarmSettings& settings, std::vector<BatchResult>& results, FarmStats& stats)
+        : jobs(jobs), settings(settings), results(results), stats(stats), done(jobs.size(), false), remaining(jobs.size()) {
+        const size_t unit_size = std::max<size_t>(settings.unit_size, 1);
+        for (size_t first = 0; first < jobs.size(); first += unit_size) {
+            const size_t count = std::min(unit_size, jobs.size() - first);
+            this->units.push_back({ first, count, count });
+        }
+    }
+
+    /// @brief gives up on the jobs of a unit that has been handed out too many times.
+    void give_up(FarmUnit& unit) {
+        for (size_t job = unit.first; job < unit.first + unit.count; ++job) {
+            if (this->done[job]) continue;
+            this->results[job].error = "no worker finished the job in " + std::to_string(unit.attempts) + " attempts";
+            this->done[job] = true;
+            --this->remaining;
+        }
+        unit.remaining = 0;
+        unit.owner = -1;
+    }
+
+    /// @brief the unit to hand to a worker asking for one, null if there's none.
+    FarmUnit* next_unit() {
+        const FarmClock::time_point now = FarmClock::now();
+        // first a unit nobody has, then one whose worker is taking too long.
+        for (int expired = 0; expired < 2; ++expired) {
+            for (FarmUnit& unit : this->units) {
+                if (unit.remaining == 0) continue;
+                const bool free = unit.owner < 0;
+                const bool late = now - unit.leased_at > std::chrono::seconds(this->settings.lease_seconds);
+                if (expired ? free || !late : !free) continue;
+                if (unit.attempts >= this->settings.max_attempts) {
+                    this->give_up(unit);
+                    continue;
+                }
+                return &unit;
+            }
+        }
+        return nullptr;
+    }
+
+    /// @brief answers a worker asking for a unit.
+    /// @return `false` if the worker couldn't be written to
+    bool hand_out(FarmConnection& connection) {
+        std::vector<uint8_t> message;
+        FarmUnit* unit = this->remaining == 0 ? nullptr : this->next_unit();
+        if (this->remaining == 0) {
+            encode_message(DaemonMessage::Done, message);
+        } else if (unit == nullptr) {
+            encode_message(DaemonMessage::Wait, message);
+        } else {
+            this->stats.leases += 1;
+            this->stats.retries += unit->attempts != 0;
+            unit->attempts += 1;
+            unit->owner = connection.fd;
+            unit->leased_at = FarmClock::now();
+            for (size_t job = unit->first; job < unit->first + unit->count; ++job) {
+                if (this->done[job]) continue;
+                DaemonJob daemon_job;
+                daemon_job.id = job;
+                daemon_job.job = this->jobs[job];
+                encode_job(daemon_job, message);
+            }
+            encode_message(DaemonMessage::UnitEnd, message);
+        }
+        return write_all(connection.fd, message.data(), message.size());
+    }
+
+    /// @brief takes the result of a job, the first result of every job counts.
+    void take_result(DaemonResult& result) {
+        if (result.id >= this->jobs.size()) return;
+        if (this->done[result.id]) {
+            this->stats.duplicates += 1;
+            return;
+        }
+        this->results[result.id] = std::move(result.result);
+        this->done[result.id] = true;
+        --this->remaining;
+        FarmUnit& unit = this->units[result.id / std::max<size_t>(this->settings.unit_size, 1)];
+        if (--unit.remaining == 0) unit.owner = -1;
+    }
+
+    /// @brief handles the messages a worker sent.
+    /// @return `false` if the worker broke the protocol or couldn't be written to
+    bool handle_input(FarmConnection& connection) {
+        size_t at = 0;
+        if (!connection.greeted) {
+            if (connection.input.size() < sizeof(FARM_HELLO)) return true;
+            if (!std::equal(FARM_HELLO, FARM_HELLO + sizeof(FARM_HELLO), connection.input.begin())) return false;
+            connection.greeted = true;
+            at = sizeof(FARM_HELLO);
+        }
+        std::vector<uint8_t> body;
+        while (connection.input.size() - at >= 5) {
+            const uint8_t* header = connection.input.data() + at;
+            const uint32_t length = header[0] | header[1] << 8 | header[2] << 16 | uint32_t(header[3]) << 24;
+            if (length == 0 || length - 1 > DAEMON_MAX_MESSAGE) return false;
+            if (connection.input.size() - at - 4 < length) break;
+            const DaemonMessage kind = static_cast<DaemonMessage>(header[4]);
+            body.assign(header + 5, header + 4 + length);
+            at += 4 + length;
+            if (kind == DaemonMessage::WorkRequest) {
+                if (!this->hand_out(connection)) return false;
+            } else if (kind == DaemonMessage::Result) {
+                DaemonResult result;
+                if (!decode_result(body, result)) return false;
+                this->take_result(result);
+            } else {
+                return false;
+            }
+        }
+        connection.input.erase(connection.input.begin(), connection.input.begin() + at);
+        return true;
+    }
+
+    /// @brief releases the units of a worker that went away, for the next worker to take.
+    void release(int fd) {
+        for (FarmUnit& unit : this->units) {
+            if (unit.owner == fd) unit.owner = -1;
+        }
+    }
+
+    const std::vector<BatchJob>& jobs;
+    const FarmSettings& settings;
+    std::vector<BatchResult>& results;
+    FarmStats& stats;
+    std::vector<FarmUnit> units;
+    /// whether every job has its result.
+    std::vector<bool> done;
+    /// the amount of jobs without a result.
+    size_t remaining;
+};
+
+bool run_coordinator(const std::vector<BatchJob>& jobs, uint16_t port, const FarmSettings& settings,
+    std::vector<BatchResult>& results, FarmStats& stats) {
+    results.assign(jobs.size(), BatchResult());
+    const int listener = socket(AF_INET6, SOCK_STREAM, 0);
+    if (listener < 0) return false;
+    const int enable = 1, disable = 0;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+    // listens on IPv4 as well, workers may connect with either.
+    setsockopt(listener, IPPROTO_IPV6, IPV6_V6ONLY, &disable, sizeof(disable));
+    sockaddr_in6 address = {};
+    address.sin6_family = AF_INET6;
+    address.sin6_addr = in6addr_any;
+    address.sin6_port = htons(port);
+    if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 64) != 0) {
+        close(listener);
+        return false;
+    }
+
+    socklen_t address_length = sizeof(address);
+    getsockname(listener, reinterpret_cast<sockaddr*>(&address), &address_length);
+    std::cout << "coordinator listening on port " << ntohs(address.sin6_port) << std::endl;
+
+    Coordinator coordinator(jobs, settings, results, stats);
+    std::vector<FarmConnection> connections;
+    std::vector<pollfd> fds;
+    uint8_t buffer[64 * 1024];
+    while (coordinator.remaining != 0) {
+        fds.assign(1, pollfd{ listener, POLLIN, 0 });
+        for (const FarmConnection& connection : connections) {
+            fds.push_back({ connection.fd, POLLIN, 0 });
+        }
+        if (poll(fds.data(), fds.size(), 1000) < 0 && errno != EINTR) break;
+        if (fds[0].revents & POLLIN) {
+            const int fd = accept(listener, nullptr, nullptr);
+            if (fd >= 0) {
+                set_no_delay(fd);
+                connections.push_back({ fd });
+                stats.workers += 1;
+            }
+        }
+        // the connections are walked backwards, so dropping one doesn't move the ones still to be walked.
+        for (size_t index = fds.size() - 1; index > 0; --index) {
+            if (fds[index].revents == 0) continue;
+            FarmConnection& connection = connections[index - 1];
+            const ssize_t count = read(connection.fd, buffer, sizeof(buffer));
+            if (count < 0 && errno == EINTR) continue;
+            bool keep = count > 0;
+            if (keep) {
+                connection.input.insert(connection.input.end(), buffer, buffer + count);
+                keep = coordinator.handle_input(connection);
+            }
+            if (!keep) {
+                coordinator.release(connection.fd);
+                close(connection.fd);
+                connections.erase(connections.begin() + (index - 1));
+            }
+        }
+    }
+
+    // tells the workers still connected they can go.
+    std::vector<uint8_t> done;
+    encode_message(DaemonMessage::Done, done);
+    for (const FarmConnection& connection : connections) {
+        write_all(connection.fd, done.data(), done.size());
+        close(connection.fd);
+    }
+    close(listener);
+    return true;
+}
+
+/// @brief connects to the coordinator, trying again for a while as workers may start before it.
+/// @return the socket, or -1 if the coordinator couldn't be reached in time
+static int connect_coordinator(const std::string& host, uint16_t port, std::chrono::seconds patience) {
+    const FarmClock::time_point give_up = FarmClock::now() + patience;
+    const std::string service = std::to_string(port);
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    while (true) {
+        addrinfo* addresses = nullptr;
+        if (getaddrinfo(host.c_str(), service.c_str(), &hints, &addresses) == 0) {
+            for (addrinfo* address = addresses; address != nullptr; address = address->ai_next) {
+                const int fd = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+                if (fd < 0) continue;
+                if (connect(fd, address->ai_addr, address->ai_addrlen) == 0) {
+                    freeaddrinfo(addresses);
+                    set_no_delay(fd);
+                    return fd;
+                }
+                close(fd);
+            }
+            freeaddrinfo(addresses);
+        }
+        if (FarmClock::now() >= give_up) return -1;
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    }
+}
+
+/// what a worker's connection ended with.
+enum class WorkerEnd { Done, Dropped };
+
+/// @brief runs units from a connected coordinator until it's done or the connection drops.
+static WorkerEnd work(int fd, size_t threads) {
+    std::vector<uint8_t> request(FARM_HELLO, FARM_HELLO + sizeof(FARM_HELLO));
+    std::vector<DaemonJob> unit;
+    std::vector<BatchJob> jobs;
+    DaemonMessage kind;
+    std::vector<uint8_t> body, message;
+    while (true) {
+        encode_message(DaemonMessage::WorkRequest, request);
+        if (!write_all(fd, request.data(), request.size())) return WorkerEnd::Dropped;
+        request.clear();
+        unit.clear();
+        while (true) {
+            if (!read_message(fd, kind, body)) return WorkerEnd::Dropped;
+            if (kind == DaemonMessage::Job) {
+                unit.emplace_back();
+                if (!decode_job(body, unit.back())) return WorkerEnd::Dropped;
+            } else if (kind == DaemonMessage::UnitEnd || kind == DaemonMessage::Wait) {
+                break;
+            } else if (kind == DaemonMessage::Done) {
+                return WorkerEnd::Done;
+            } else {
+                return WorkerEnd::Dropped;
+            }
+        }
+        if (kind == DaemonMessage::Wait) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            continue;
+        }
+        jobs.clear();
+        for (DaemonJob& job : unit) jobs.push_back(std::move(job.job));
+        std::vector<BatchResult> results = run_batch(jobs, threads);
+        message.clear();
+        for (size_t index = 0; index < unit.size(); ++index) {
+            DaemonResult result;
+            result.id = unit[index].id;
+            result.result = std::move(results[index]);
+            encode_result(result, message);
+        }
+        if (!write_all(fd, message.data(), message.size())) return WorkerEnd::Dropped;
+    }
+}
+
+bool run_farm_worker(const std::string& host, uint16_t port, size_t threads) {
+    // the first connection waits a while for the coordinator to start, later ones only a little, a coordinator that
+    // doesn't come back most likely finished.
+    int fd = connect_coordinator(host, port, std::chrono::seconds(30));
+    if (fd < 0) return false;
+    while (fd >= 0) {
+        const WorkerEnd end = work(fd, threads);
+        close(fd);
+        if (end == WorkerEnd::Done) break;
+        std::cerr << "lost the coordinator, connecting again" << std::endl;
+        fd = connect_coordinator(host, port, std::chrono::seconds(10));
+    }
+    return true;
+}
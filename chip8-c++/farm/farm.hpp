@@ -0,0 +1,58 @@
+// no duplicate includes.
+#pragma once
+
+// the jobs and results the farm runs, and the messages it sends them in.
+#include<protocol.hpp>
+
+/// @brief the batch farm spreads batch jobs over worker processes on other hosts, over TCP.
+/// @brief
+/// @brief the coordinator splits the jobs into work units of a few jobs each. Workers connect, send `FARM_HELLO` and then
+/// @brief ask for a unit with `DaemonMessage::WorkRequest`. The coordinator answers with the unit's `Job` messages and a
+/// @brief `UnitEnd`, with `Wait` if every unit is taken, or with `Done` once every job has a result. The worker runs the
+/// @brief unit with the batch runner, sends a `Result` for every job and asks for the next unit.
+/// @brief
+/// @brief a unit whose worker disconnects goes back to the other workers right away, and one whose worker takes longer
+/// @brief than the lease is handed out again to the next worker without a unit, so a stuck worker only slows the run
+/// @brief down. The first result of every job counts, duplicates from a unit that ran twice are dropped.
+
+/// the bytes a worker starts a connection with, "C8F" and the protocol version.
+static const uint8_t FARM_HELLO[4] = { 'C', '8', 'F', 1 };
+
+/// how the coordinator hands out work.
+struct FarmSettings {
+    /// the amount of jobs in a work unit.
+    size_t unit_size = 8;
+    /// the seconds a worker has to finish a unit before it's handed out again.
+    uint32_t lease_seconds = 120;
+    /// the amount of times a unit is handed out before its jobs are given up on, as its jobs probably crash workers.
+    uint32_t max_attempts = 3;
+};
+
+/// what the coordinator did.
+struct FarmStats {
+    /// the amount of workers that connected.
+    size_t workers = 0;
+    /// the amount of times a unit was handed out.
+    size_t leases = 0;
+    /// the amount of times a unit was handed out again, after its worker disconnected or its lease ran out.
+    size_t retries = 0;
+    /// the amount of results dropped because their job already had one.
+    size_t duplicates = 0;
+};
+
+/// @brief runs jobs on the workers that connect to `port`, returning once every job has a result.
+/// @param jobs the jobs to run
+/// @param port the TCP port to listen on, on every interface
+/// @param settings how work is handed out
+/// @param results the results, in the same order as `jobs`. A job given up on has an error saying so
+/// @param stats what the coordinator did
+/// @return `false` if the port couldn't be listened on
+bool run_coordinator(const std::vector<BatchJob>& jobs, uint16_t port, const FarmSettings& settings,
+    std::vector<BatchResult>& results, FarmStats& stats);
+
+/// @brief works for the coordinator at `host` and `port` until it's done, connecting again if the connection drops.
+/// @param host the name or address of the coordinator
+/// @param port the port of the coordinator
+/// @param threads the amount of threads units run on, 0 uses one per hardware thread
+/// @return `false` if the coordinator couldn't be reached
+bool run_farm_worker(const std::string& host, uint16_t port, size_t threads);
@@ -0,0 +1,125 @@
+// the fork server declarations implemented in this file.
+#include<fork_server.hpp>
+
+// gives the fork, pipe, poll and wait functions.
+#include<unistd.h>
+#include<poll.h>
+#include<sys/wait.h>
+#include<climits>
+#include<cerrno>
+
+// gives the std::thread::hardware_concurrency function.
+#include<thread>
+
+// gives the std::max function.
+#include<algorithm>
+
+// gives the std::is_trivially_copyable trait.
+#include<type_traits>
+
+// results are written in a single write, which the pipe keeps whole as long as it's at most PIPE_BUF bytes.
+static_assert(std::is_trivially_copyable<ExploreResult>::value, "results are sent through pipes as they are");
+static_assert(sizeof(ExploreResult) <= PIPE_BUF, "results must fit in a single atomic pipe write");
+
+/// a child that hasn't reported yet.
+struct ForkChild {
+    /// the process of the child.
+    pid_t pid;
+    /// the branch the child runs.
+    size_t branch;
+    /// the bytes of the result received so far.
+    size_t received = 0;
+    /// the result, complete once `received` is its size.
+    ExploreResult result;
+};
+
+/// @brief the body of a child, never returns.
+[[noreturn]] static void run_child(int pipe_out, Core& core, const ExploreBranch& branch, size_t instructions_per_frame,
+    const ExploreScore& score) {
+    const ExploreResult result = run_branch(core, branch, instructions_per_frame, score);
+    const ssize_t written = write(pipe_out, &result, sizeof(result));
+    // _exit skips the parent's atexit handlers and stream flushes, which belong to the parent.
+    _exit(written == ssize_t(sizeof(result)) ? 0 : 1);
+}
+
+ForkServer::ForkServer(size_t max_children) {
+    this->max_children = max_children != 0 ? max_children : std::max(1u, std::thread::hardware_concurrency());
+}
+
+std::vector<ExploreResult> ForkServer::explore(const Core& start, const std::vector<ExploreBranch>& branches,
+    size_t instructions_per_frame, const ExploreScore& score) {
+    std::vector<ExploreResult> results(branches.size());
+    // the children and the read ends of their pipes, at the same indices.
+    std::vector<ForkChild> children;
+    std::vector<pollfd> pipes;
+    // every child continues from a copy of this core, which it owns after the fork.
+    Core core = start;
+    size_t next = 0;
+    while (next < branches.size() || !children.empty()) {
+        while (next < branches.size() && children.size() < this->max_children) {
+            int fds[2];
+            if (pipe(fds) != 0) {
+                ++this->server_stats.fork_failures;
+                ++next;
+                continue;
+            }
+            const pid_t pid = fork();
+            if (pid == 0) {
+                close(fds[0]);
+                run_child(fds[1], core, branches[next], instructions_per_frame, score);
+            }
+            // the parent never writes, closing its write end lets it see the end of the pipe once the child exits.
+            close(fds[1]);
+            if (pid < 0) {
+                close(fds[0]);
+                ++this->server_stats.fork_failures;
+                ++next;
+                continue;
+            }
+            ++this->server_stats.forks;
+            ForkChild child;
+            child.pid = pid;
+            child.branch = next++;
+            children.push_back(child);
+            pipes.push_back({ fds[0], POLLIN, 0 });
+        }
+        if (children.empty()) break;
+
+        if (poll(pipes.data(), pipes.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        for (size_t index = children.size(); index-- > 0;) {
+            if (pipes[index].revents == 0) continue;
+            ForkChild& child = children[index];
+            char* destination = reinterpret_cast<char*>(&child.result) + child.received;
+            const ssize_t count = read(pipes[index].fd, destination, sizeof(child.result) - child.received);
+            if (count > 0) {
+                child.received += count;
+                if (child.received < sizeof(child.result)) continue;
+            } else if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            // the result is complete or the child closed its pipe without one, either way it's done.
+            int status = 0;
+            while (waitpid(child.pid, &status, 0) < 0 && errno == EINTR) {}
+            const bool reported = child.received == sizeof(child.result) && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+            if (reported) {
+                results[child.branch] = child.result;
+            } else {
+                ++this->server_stats.crashed;
+            }
+            close(pipes[index].fd);
+            children.erase(children.begin() + index);
+            pipes.erase(pipes.begin() + index);
+        }
+    }
+    // only reached early if poll failed, the remaining children are waited for so none are left as zombies.
+    for (size_t index = 0; index < children.size(); ++index) {
+        int status = 0;
+        while (waitpid(children[index].pid, &status, 0) < 0 && errno == EINTR) {}
+        close(pipes[index].fd);
+        ++this->server_stats.crashed;
+    }
+    return results;
+}
@@ -0,0 +1,46 @@
+// no duplicate includes.
+#pragma once
+
+// the branches and results shared with the in-process exploration.
+#include<explore.hpp>
+
+/// what a `ForkServer` did during an `explore`.
+struct ForkServerStats {
+    /// the amount of children forked.
+    uint64_t forks = 0;
+    /// the amount of children that died before reporting their result.
+    uint64_t crashed = 0;
+    /// the amount of branches that couldn't be forked at all, because the system is out of processes or memory.
+    uint64_t fork_failures = 0;
+};
+
+/// @brief explores branches in forked child processes. The calling process warms a core (and whatever host data goes
+/// @brief with it) up to a checkpoint, then every branch is a child forked from it, which shares all of the parent's
+/// @brief memory copy on write, runs its branch, reports its `ExploreResult` over a pipe and exits. A branch that
+/// @brief crashes its child (a bad score function, a debugging build's assert) only loses that branch.
+/// @brief Forking copies the calling thread only, so the caller's other threads must not be holding locks the
+/// @brief children need (the allocator's among them) while `explore` runs. `run_branch` itself doesn't allocate.
+struct ForkServer {
+    /// @param max_children the most children alive at once, 0 uses one per hardware thread
+    ForkServer(size_t max_children = 0);
+
+    /// @brief runs every branch in its own child of this process, continuing from `start`.
+    /// @param start the state every branch continues from
+    /// @param branches the branches
+    /// @param instructions_per_frame the amount of instructions every frame runs
+    /// @param score scores every branch, called in the child
+    /// @return the result of every branch in the same order as `branches`, `finished` is `false` for branches whose
+    /// @return child crashed or couldn't be forked
+    std::vector<ExploreResult> explore(const Core& start, const std::vector<ExploreBranch>& branches,
+        size_t instructions_per_frame, const ExploreScore& score);
+
+    /// @brief what the server did during every `explore` so far.
+    const ForkServerStats& stats() const {
+        return this->server_stats;
+    }
+private:
+    /// the most children alive at once.
+    size_t max_children;
+    /// what the server did so far.
+    ForkServerStats server_stats;
+};
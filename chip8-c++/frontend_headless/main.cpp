@@ -0,0 +1,106 @@
+// gives the io streams, which has the ability to write to the terminal.
+#include<iostream>
+
+// includes the core header for us to implement in our frontend.
+#include<core.hpp>
+
+// movie playback, which provides the inputs of a headless run.
+#include<movie.hpp>
+
+// the capture pipeline which writes the frames out.
+#include<capture.hpp>
+
+// gives the filestreams to read files from the host system.
+#include<fstream>
+
+// gives access to the std::vector type.
+#include<vector>
+
+// gives the std::string type used to compare arguments.
+#include<string>
+
+/// the entry point of the headless frontend. It runs a ROM without a window, either for a set amount of frames
+/// with no input or by playing a movie, and optionally captures every frame to a video file.
+int main(int argc, char* argv[]) {
+    char* rom_path = nullptr;
+    char* play_path = nullptr;
+    char* capture_path = nullptr;
+    size_t frames = 600;
+    CaptureSettings capture_settings;
+    // a headless run has no real time to keep, so it waits for the writer instead of dropping frames unless told otherwise.
+    capture_settings.drop_when_behind = false;
+    for (int arg = 1; arg < argc; ++arg) {
+        std::string flag = argv[arg];
+        if (flag == "--play" && arg + 1 < argc) {
+            play_path = argv[++arg];
+        } else if (flag == "--capture" && arg + 1 < argc) {
+            capture_path = argv[++arg];
+        } else if (flag == "--frames" && arg + 1 < argc) {
+            frames = std::stoul(argv[++arg]);
+        } else if (flag == "--scale" && arg + 1 < argc) {
+            capture_settings.scale = std::stoul(argv[++arg]);
+        } else if (flag == "--drop") {
+            capture_settings.drop_when_behind = true;
+        } else if (flag == "--raw") {
+            capture_settings.format = CaptureFormat::RawRGBA;
+        } else if (rom_path == nullptr) {
+            rom_path = argv[arg];
+        } else {
+            std::cerr << "unexpected argument: " << flag << std::endl;
+            exit(-1);
+        }
+    }
+    if (rom_path == nullptr) {
+        std::cerr << "usage: chip8-c++-headless <rom> [--frames <n>] [--play <movie>] [--capture <file|-|\"|command\">] [--raw] [--scale <n>] [--drop]" << std::endl;
+        exit(-1);
+    }
+
+    std::ifstream ifstream(rom_path, std::ios::binary);
+    std::vector<char> rom((std::istreambuf_iterator<char>(ifstream)), std::istreambuf_iterator<char>());
+    // a missing ROM would run an empty program, and one past the end of memory can't be loaded at all.
+    if (!ifstream || rom.size() > 0x1000 - 0x200) {
+        std::cerr << "could not read ROM: " << rom_path << std::endl;
+        exit(2);
+    }
+
+    // a movie decides the settings of the core and how many frames are run.
+    Movie movie;
+    if (play_path != nullptr) {
+        if (!Movie::load(play_path, movie)) {
+            std::cerr << "could not read movie: " << play_path << std::endl;
+            exit(-1);
+        }
+        frames = movie.frame_count();
+    }
+    MoviePlayer player(movie);
+    if (play_path != nullptr && !player.matches_rom(rom.data(), rom.size())) {
+        std::cerr << "movie was recorded with a different ROM" << std::endl;
+        exit(-1);
+    }
+    auto core = Core::create(rom.data(), rom.size(), movie.settings.seed);
+
+    FrameCapture capture;
+    if (capture_path != nullptr && !capture.open(capture_path, capture_settings)) {
+        std::cerr << "could not open capture output: " << capture_path << std::endl;
+        exit(-1);
+    }
+
+    for (size_t frame = 0; frame < frames; ++frame) {
+        if (play_path != nullptr) {
+            player.step(core);
+        } else {
+            core.run_frame(0, movie.settings.instructions_per_frame);
+        }
+        if (capture_path != nullptr) {
+            capture.submit(core.framebuffer());
+        }
+    }
+    capture.close();
+
+    // the statistics go to the error stream, as the standard output may be carrying the capture.
+    std::cerr << "ran " << frames << " frames";
+    if (capture_path != nullptr) {
+        std::cerr << ", captured " << capture.frames_written() << " and dropped " << capture.frames_dropped();
+    }
+    std::cerr << std::endl;
+}
@@ -4,6 +4,34 @@
 // includes the core header for us to implement in our frontend.
 #include<core.hpp>
 
+// movie recording and playback.
+#include<movie.hpp>
+
+// the shared memory export is only available on POSIX systems, see CMakeLists.txt.
+#ifdef CHIP8_SHM_EXPORT
+#include<shm_export.hpp>
+#endif
+
+// the ROM watcher uses inotify, so it's only available on Linux, see CMakeLists.txt.
+#ifdef CHIP8_ROM_WATCH
+#include<rom_watch.hpp>
+#endif
+
+// the capture pipeline, which records the frames to a video file.
+#include<capture.hpp>
+
+// the CPU upscaling filters.
+#include<scale.hpp>
+
+// breakpoints and watchpoints.
+#include<debugger.hpp>
+
+// the output writing straight into the window surface.
+#include<surface_output.hpp>
+
+// the zone profiler, its zones compile to nothing unless it's built, see CMakeLists.txt.
+#include<profiler.hpp>
+
 // SDL2 header for rendering and audio.
 #include<SDL2/SDL.h>
 
@@ -16,19 +44,129 @@
 // gives access to the std::vector type.
 #include<vector>
 
+// gives the std::string type used to compare arguments.
+#include<string>
+
+// gives the std::unique_ptr type.
+#include<memory>
+
+// gives the std::max function.
+#include<algorithm>
+
+/// the SDL2 keys mapped to each hexpad key, indexed by the hexpad key.
+static const SDL_Scancode HEXPAD_KEYS[16] = {
+    SDL_SCANCODE_0, SDL_SCANCODE_1, SDL_SCANCODE_2, SDL_SCANCODE_3,
+    SDL_SCANCODE_Q, SDL_SCANCODE_W, SDL_SCANCODE_E, SDL_SCANCODE_R,
+    SDL_SCANCODE_A, SDL_SCANCODE_S, SDL_SCANCODE_D, SDL_SCANCODE_F,
+    SDL_SCANCODE_Z, SDL_SCANCODE_X, SDL_SCANCODE_C, SDL_SCANCODE_V,
+};
+
+/// @brief prints the registers of a stopped core, for the debugger.
+static void print_registers(const Core& core) {
+    const CoreRegisters registers = core.registers();
+    std::cout << std::hex << "  pc=" << registers.pc << " i=" << registers.i << " sp=" << int(registers.sp)
+        << " dt=" << int(registers.timer_delay) << " st=" << int(registers.timer_sound) << std::endl << " ";
+    for (size_t index = 0; index < registers.v.size(); ++index) {
+        std::cout << " v" << index << "=" << int(registers.v[index]);
+    }
+    std::cout << std::dec << std::endl;
+}
+
+/// @brief parses a debugger address argument, `<hex address>[:<length>]`.
+static void parse_address(const std::string& argument, uint16_t& address, uint16_t& length) {
+    const size_t colon = argument.find(':');
+    address = std::stoi(argument.substr(0, colon), nullptr, 16) & 0x0fff;
+    length = colon == std::string::npos ? 1 : std::stoi(argument.substr(colon + 1));
+}
+
+/// @brief reads a ROM for reloading it. A file that's empty or too large is most likely still being written, the
+/// @brief next change reloads it again.
+/// @return whether the file could be read and fits in memory
+static bool read_rom(const char* path, std::vector<char>& rom) {
+    std::ifstream ifstream(path, std::ios::binary);
+    rom.assign(std::istreambuf_iterator<char>(ifstream), std::istreambuf_iterator<char>());
+    return !ifstream.bad() && !rom.empty() && rom.size() <= 4096 - 512;
+}
+
 /// the main entry point of the program and the frontend of the CHIP-8 emulator. 
 int main(int argc, char* argv[]) {
     std::cout << "running chip8-c++-sdl" << std::endl;
-    if (argc < 2) {
-        std::cout << "expected rom path as argument." << std::endl;
-        exit(-1);
-        assert("unreachable" && false);
-    } else if (argc > 2) {
-        std::cout << "got multiple paths to ROM" << std::endl;
+    // parses the arguments, the ROM path and optionally a movie to record to or play back.
+    char* rom_path = nullptr;
+    char* record_path = nullptr;
+    char* play_path = nullptr;
+    char* shm_name = nullptr;
+    char* capture_path = nullptr;
+    char* filter_name = nullptr;
+    size_t filter_scale = 4;
+    size_t filter_threads = 1;
+    bool use_surface = false;
+    bool watch_rom = false;
+    RomReload reload_mode = RomReload::KeepRegisters;
+    uint16_t keep_address = 0, keep_length = 0;
+    Debugger debugger;
+    bool debugging = false;
+    char* profile_path = nullptr;
+    for (int arg = 1; arg < argc; ++arg) {
+        std::string flag = argv[arg];
+        if ((flag == "--record" || flag == "--play") && arg + 1 < argc) {
+            (flag == "--record" ? record_path : play_path) = argv[++arg];
+        } else if (flag == "--export-shm" && arg + 1 < argc) {
+            shm_name = argv[++arg];
+        } else if (flag == "--capture" && arg + 1 < argc) {
+            capture_path = argv[++arg];
+        } else if (flag == "--filter" && arg + 1 < argc) {
+            filter_name = argv[++arg];
+        } else if (flag == "--filter-scale" && arg + 1 < argc) {
+            filter_scale = std::max(1, std::stoi(argv[++arg]));
+        } else if (flag == "--filter-threads" && arg + 1 < argc) {
+            filter_threads = std::max(1, std::stoi(argv[++arg]));
+        } else if ((flag == "--break" || flag == "--watch" || flag == "--watch-read") && arg + 1 < argc) {
+            uint16_t address, length;
+            parse_address(argv[++arg], address, length);
+            if (flag == "--break") debugger.add_breakpoint(address);
+            else debugger.add_watchpoint(address, length, flag == "--watch" ? WatchKind::Write : WatchKind::Read);
+            debugging = true;
+        } else if (flag == "--surface") {
+            use_surface = true;
+        } else if (flag == "--watch-rom") {
+            watch_rom = true;
+        } else if (flag == "--reload-restart") {
+            reload_mode = RomReload::Restart;
+        } else if (flag == "--reload-keep" && arg + 1 < argc) {
+            parse_address(argv[++arg], keep_address, keep_length);
+        } else if (flag == "--profile" && arg + 1 < argc) {
+            profile_path = argv[++arg];
+        } else if (rom_path == nullptr) {
+            rom_path = argv[arg];
+        } else {
+            std::cout << "got multiple paths to ROM" << std::endl;
+            exit(-1);
+        }
+    }
+    if (rom_path == nullptr) {
+        std::cout << "expected rom path as argument. usage: chip8-c++-sdl <rom> [--record <movie>] [--play <movie>] [--export-shm <name>] [--capture <video.y4m>]"
+            " [--filter <nearest|scale2x|scale3x|scale4x|scanlines|phosphor>] [--filter-scale <n>] [--filter-threads <n>] [--surface]"
+            " [--watch-rom] [--reload-restart] [--reload-keep <addr>[:len]]"
+            " [--break <addr>] [--watch <addr>[:len]] [--watch-read <addr>[:len]] [--profile <file>]" << std::endl;
         exit(-1);
     }
     
-    char* rom_path = argv[1];
+    if (use_surface && filter_name != nullptr) {
+        std::cout << "--surface draws the pixels itself, it can't be used with --filter" << std::endl;
+        exit(-1);
+    }
+
+    if (debugging && (record_path != nullptr || play_path != nullptr)) {
+        std::cout << "the debugger can't be used while recording or playing a movie" << std::endl;
+        exit(-1);
+    }
+
+    if (watch_rom && (record_path != nullptr || play_path != nullptr)) {
+        std::cout << "the ROM can't be reloaded while recording or playing a movie" << std::endl;
+        exit(-1);
+    }
+
     std::cout << "reading ROM from path: " << rom_path << std::endl;
 
     SDL_Init(SDL_INIT_EVERYTHING); // initialize all components of SDL2.
@@ -41,95 +179,287 @@ int main(int argc, char* argv[]) {
     ifstream.read(byte_array.data(), file_size);    // read the file and store it into the vector.
     ifstream.close();                               // closes the file as to not hoard resources.
 
+    // loads the movie to play back, its settings decide how the core is created.
+    Movie movie;
+    MovieSettings settings;
+    if (play_path != nullptr) {
+        if (!Movie::load(play_path, movie)) {
+            std::cout << "could not read movie: " << play_path << std::endl;
+            exit(-1);
+        }
+        settings = movie.settings;
+    }
+    MoviePlayer player(movie);
+    if (play_path != nullptr && !player.matches_rom(byte_array.data(), byte_array.size())) {
+        std::cout << "movie was recorded with a different ROM" << std::endl;
+        exit(-1);
+    }
+    MovieRecorder recorder(byte_array.data(), byte_array.size(), settings);
+
     // create the core struct, which represents the backend of our emulator.    
-    auto core = Core::create(byte_array.data(), byte_array.size());
+    auto core = Core::create(byte_array.data(), byte_array.size(), settings.seed);
+
+    // captures every frame to a video file on a background thread, if asked to.
+    FrameCapture capture;
+    if (capture_path != nullptr && !capture.open(capture_path, CaptureSettings())) {
+        std::cout << "could not open capture output: " << capture_path << std::endl;
+        exit(-1);
+    }
+
+    // publishes the core into shared memory every frame, if asked to.
+#ifdef CHIP8_SHM_EXPORT
+    ShmExporter shm_exporter;
+    if (shm_name != nullptr && !ShmExporter::create(shm_name, shm_exporter)) {
+        std::cout << "could not create shared memory segment: " << shm_name << std::endl;
+        exit(-1);
+    }
+    uint64_t instructions_run = 0;      // the amount of instructions run so far, published by the export.
+    uint64_t frame_start = SDL_GetPerformanceCounter();
+#else
+    if (shm_name != nullptr) {
+        std::cout << "the shared memory export isn't available on this platform" << std::endl;
+        exit(-1);
+    }
+#endif
+
+    // watches the ROM for changes and reloads it in place, if asked to.
+#ifdef CHIP8_ROM_WATCH
+    RomWatcher rom_watcher;
+    if (watch_rom && !RomWatcher::create(rom_path, rom_watcher)) {
+        std::cout << "could not watch ROM: " << rom_path << std::endl;
+        exit(-1);
+    }
+#else
+    if (watch_rom) {
+        std::cout << "watching the ROM isn't available on this platform" << std::endl;
+        exit(-1);
+    }
+#endif
+
+    // optionally scales the frames up on the CPU instead of leaving all of the scaling to SDL, which gives the same
+    // output on every renderer, including software ones.
+    std::unique_ptr<Upscaler> upscaler;
+    if (filter_name != nullptr) {
+        ScaleFilter filter;
+        if (!parse_scale_filter(filter_name, filter)) {
+            std::cout << "unknown filter: " << filter_name << std::endl;
+            exit(-1);
+        }
+        upscaler.reset(new Upscaler(filter, filter_scale, filter_threads));
+    }
+    const uint32_t texture_scale = upscaler ? upscaler->factor() : 1;
 
     // the SDL window will automatically upscale or downscale, so we can make it any size we want. It starts 5x the size of the original CHIP-8 display. 
-    uint32_t texture_width = core.framebuffer().width();    // the width of the CHIP-8 display.
-    uint32_t texture_height = core.framebuffer().height();  // the height of the CHIP-8 display.
-    uint32_t window_width = texture_width * 5;              // the rendered window's width. 
-    uint32_t window_height = texture_height * 5;            // the rendered window's height.
-    // create the SDL window and renderer.
-    SDL_Window* window;
-    SDL_Renderer* renderer;
-    SDL_CreateWindowAndRenderer(window_width, window_height, SDL_WINDOW_RESIZABLE, &window, &renderer);
-    SDL_SetWindowTitle(window, "chip8-c++-sdl"); // name out window something meaningful.
-    // create our SDL texture.
-    SDL_Texture* texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STREAMING, texture_width, texture_height);
+    uint32_t texture_width = core.framebuffer().width() * texture_scale;    // the width of the CHIP-8 display, after CPU scaling.
+    uint32_t texture_height = core.framebuffer().height() * texture_scale;  // the height of the CHIP-8 display, after CPU scaling.
+    uint32_t window_width = core.framebuffer().width() * 5;                 // the rendered window's width. 
+    uint32_t window_height = core.framebuffer().height() * 5;               // the rendered window's height.
+    // create the SDL window and renderer. with --surface the window gets no renderer, the frames are written into its surface instead.
+    SDL_Window* window = nullptr;
+    SDL_Renderer* renderer = nullptr;
+    SDL_Texture* texture = nullptr;
+    if (use_surface) {
+        window = SDL_CreateWindow("chip8-c++-sdl", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, window_width, window_height, SDL_WINDOW_RESIZABLE);
+    } else {
+        SDL_CreateWindowAndRenderer(window_width, window_height, SDL_WINDOW_RESIZABLE, &window, &renderer);
+        SDL_SetWindowTitle(window, "chip8-c++-sdl"); // name out window something meaningful.
+        // create our SDL texture.
+        texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STREAMING, texture_width, texture_height);
+    }
+    SurfaceOutput surface_output(window);
     // gets a persistant pointer to the SDL2 keyboard state.
     auto keyboard = SDL_GetKeyboardState(NULL);
     // preparing for the main loop.
-    uint32_t instructions_per_frame = 60; // the instructions to execute per frame, helps determine for how long to delay given 60fps. 
+    bool trap_reported = false;
+    bool halt_reported = false;
+    bool paused = false;    // whether the debugger stopped the core, the core doesn't run until it's resumed.
+    uint32_t instructions_per_frame = settings.instructions_per_frame; // the instructions to execute per frame, helps determine for how long to delay given 60fps. 
+#ifdef CHIP8_PROFILE
+    if (profile_path != nullptr && !profiler_start(profile_path)) {
+        std::cout << "could not create profile: " << profile_path << std::endl;
+        exit(-1);
+    }
+    CHIP8_PROFILE_THREAD("main");
+#else
+    if (profile_path != nullptr) {
+        std::cout << "--profile needs the profiler, configure with -DCHIP8_PROFILE=ON" << std::endl;
+        exit(-1);
+    }
+#endif
     while (true) {
-        // poll all SDL2 events.
-        SDL_Event event;
-        while (SDL_PollEvent(&event)) {
-            switch (event.type) {
-            case SDL_WINDOWEVENT:{
-                switch (event.window.type) {
-                case SDL_WINDOWEVENT_CLOSE: goto exit; // quits the application when closing the window.
+        // the whole host frame, and the zones inside it.
+        CHIP8_ZONE("frame");
+        {
+            CHIP8_ZONE("input poll");
+            // poll all SDL2 events.
+            SDL_Event event;
+            while (SDL_PollEvent(&event)) {
+                switch (event.type) {
+                case SDL_WINDOWEVENT:{
+                    switch (event.window.event) {
+                    case SDL_WINDOWEVENT_CLOSE: goto exit; // quits the application when closing the window.
+                    case SDL_WINDOWEVENT_SIZE_CHANGED: surface_output.invalidate(); break; // the window surface is replaced on resize.
+                    default:;
+                    }
+                }break;
+                case SDL_KEYDOWN:{
+                    // the debugger keys, F5 continues, F10 steps over, F11 steps and F12 steps out.
+                    if (!paused) break;
+                    switch (event.key.keysym.scancode) {
+                    case SDL_SCANCODE_F5: paused = false; break;
+                    case SDL_SCANCODE_F10: debugger.step_over(core); paused = false; break;
+                    case SDL_SCANCODE_F11: debugger.step(); paused = false; break;
+                    case SDL_SCANCODE_F12: debugger.step_out(core); paused = false; break;
+                    default:;
+                    }
+                }break;
+                case SDL_QUIT: goto exit;
                 default:;
                 }
-            }break;
-            case SDL_QUIT: goto exit;
-            default:;
             }
         }
 
-        // run the core for a set amount of instructions
-        core.run_for_instructions_then_tick_timers(instructions_per_frame);
-
-        // update the chip8 hexmap from the SDL2 keys.
-        core.update_hexpad({
-            keyboard[SDL_SCANCODE_0] != 0,
-            keyboard[SDL_SCANCODE_1] != 0,
-            keyboard[SDL_SCANCODE_2] != 0,
-            keyboard[SDL_SCANCODE_3] != 0,
-
-            keyboard[SDL_SCANCODE_Q] != 0,
-            keyboard[SDL_SCANCODE_W] != 0,
-            keyboard[SDL_SCANCODE_E] != 0,
-            keyboard[SDL_SCANCODE_R] != 0,
-            
-            keyboard[SDL_SCANCODE_A] != 0,
-            keyboard[SDL_SCANCODE_S] != 0,
-            keyboard[SDL_SCANCODE_D] != 0,
-            keyboard[SDL_SCANCODE_F] != 0,
-
-            keyboard[SDL_SCANCODE_Z] != 0,
-            keyboard[SDL_SCANCODE_X] != 0,
-            keyboard[SDL_SCANCODE_C] != 0,
-            keyboard[SDL_SCANCODE_V] != 0,
-        });
+#ifdef CHIP8_ROM_WATCH
+        // reloads the ROM into the running core before the next frame, the window and everything else stay as they are.
+        if (watch_rom && rom_watcher.changed()) {
+            std::vector<char> reloaded;
+            if (read_rom(rom_path, reloaded)) {
+                core.reload_rom(reloaded.data(), reloaded.size(), reload_mode, keep_address, keep_length);
+                trap_reported = false;
+                halt_reported = false;
+                surface_output.invalidate();
+                std::cout << "reloaded ROM, " << reloaded.size() << " bytes" << std::endl;
+            } else {
+                std::cout << "could not reload ROM, keeping the old one" << std::endl;
+            }
+        }
+#endif
+
+        {
+            CHIP8_ZONE("emulate");
+            if (play_path != nullptr && !player.finished()) {
+                // plays the next frame of the movie, the keyboard is ignored until the movie ends.
+                player.step(core);
+                if (player.finished()) std::cout << "movie finished after " << player.current_frame() << " frames" << std::endl;
+            } else {
+                // forms the chip8 hexpad bitmap from the SDL2 keys.
+                uint16_t hexpad_bitmap = 0;
+                for (size_t key = 0; key < 16; ++key) {
+                    hexpad_bitmap |= (keyboard[HEXPAD_KEYS[key]] != 0) << key;
+                }
+                // run the core for a set amount of instructions, recording the frame if a movie is being recorded.
+                if (record_path != nullptr) {
+                    recorder.run_frame(core, hexpad_bitmap);
+                } else if (!paused) {
+                    // without breakpoints or watchpoints the debugger runs the frame at full speed.
+                    DebugEvent debug_event = debugger.run_frame(core, hexpad_bitmap, instructions_per_frame);
+                    if (debug_event.reason != DebugStop::None && debug_event.reason != DebugStop::Trap) {
+                        std::cout << "stopped on " << debug_stop_name(debug_event.reason) << " at [0x" << std::hex << debug_event.pc;
+                        if (debug_event.reason == DebugStop::ReadWatch || debug_event.reason == DebugStop::WriteWatch) {
+                            std::cout << "], accessing [0x" << debug_event.detail;
+                        }
+                        std::cout << "]" << std::dec << ", F5 continues, F10 steps over, F11 steps, F12 steps out" << std::endl;
+                        print_registers(core);
+                        paused = true;
+                    }
+                }
+            }
+        }
+
+        // reports when the core stops on a trap, the window stays open showing the last frame.
+        if (core.trap() != CoreTrap::None && !trap_reported) {
+            std::cout << "core stopped: " << trap_name(core.trap()) << " at [0x" << std::hex << core.trap_pc() << std::dec << "]" << std::endl;
+            trap_reported = true;
+        }
+        if (core.halted() && !halt_reported) {
+            std::cout << "core halted in an endless loop at [0x" << std::hex << core.registers().pc << std::dec << "]" << std::endl;
+            halt_reported = true;
+        }
+
+        if (capture_path != nullptr) {
+            CHIP8_ZONE("capture submit");
+            capture.submit(core.framebuffer());
+        }
+
+#ifdef CHIP8_SHM_EXPORT
+        instructions_run += instructions_per_frame;
+        if (shm_name != nullptr) {
+            uint64_t now = SDL_GetPerformanceCounter();
+            uint32_t frame_time_us = (now - frame_start) * 1000000 / SDL_GetPerformanceFrequency();
+            frame_start = now;
+            shm_exporter.publish(core, { instructions_run, frame_time_us });
+        }
+#endif
+
+        if (use_surface) {
+            // only the rows the core changed this frame are drawn and updated on screen.
+            {
+                CHIP8_ZONE("present");
+                if (!surface_output.present(core.framebuffer(), core.framebuffer().dirty_rows())) {
+                    std::cout << "could not draw to the window surface: " << SDL_GetError() << std::endl;
+                }
+            }
+            CHIP8_ZONE("sleep");
+            SDL_Delay(17);
+            continue;
+        }
 
         // updates the texture. the texture will be rendered by itself
         const uint32_t* core_pixel_data = core.framebuffer().ptr_begin();
         const size_t pixel_size = sizeof(*core_pixel_data); // 4
         void* texture_pixel_data = 0;
         int pitch = 0;
-        assert(!SDL_LockTexture(texture, NULL, &texture_pixel_data, &pitch)); // locks the SDL2 texture for modification.
-        for (size_t i = 0; i < texture_height; ++i) {
-            // copies the core framebuffer over to the diplayed SDL2 texture.
-            void* dest_ptr = reinterpret_cast<unsigned char*>(texture_pixel_data) + pitch * i; // casting to unsigned char allows is defined behaviour.
-            const void* src_ptr = core_pixel_data + i * texture_width;
-            std::memcpy(dest_ptr, src_ptr, texture_width * pixel_size);
+        {
+            CHIP8_ZONE("draw");
+            assert(!SDL_LockTexture(texture, NULL, &texture_pixel_data, &pitch)); // locks the SDL2 texture for modification.
+            if (upscaler) {
+                // the upscaler writes straight into the locked texture.
+                upscaler->scale_frame(core.framebuffer(), texture_pixel_data, pitch);
+            } else for (size_t i = 0; i < texture_height; ++i) {
+                // copies the core framebuffer over to the diplayed SDL2 texture.
+                void* dest_ptr = reinterpret_cast<unsigned char*>(texture_pixel_data) + pitch * i; // casting to unsigned char allows is defined behaviour.
+                const void* src_ptr = core_pixel_data + i * texture_width;
+                std::memcpy(dest_ptr, src_ptr, texture_width * pixel_size);
+            }
+        }
+        {
+            CHIP8_ZONE("texture upload");
+            SDL_UnlockTexture(texture); // unlocks the texture, uploading the changes.
         }
-        SDL_UnlockTexture(texture); // unlocks the texture, uploading the changes.
         
         // presents the rendered frame.
-        SDL_RenderClear(renderer);
-        SDL_RenderCopy(renderer, texture, NULL, NULL);
-        SDL_RenderPresent(renderer);
+        {
+            CHIP8_ZONE("present");
+            SDL_RenderClear(renderer);
+            SDL_RenderCopy(renderer, texture, NULL, NULL);
+            SDL_RenderPresent(renderer);
+        }
         
         // sleep for a whole frame.
+        CHIP8_ZONE("sleep");
         SDL_Delay(17 /* 1000 miliseconds is one second, divided by 60 is rougly 17ms */);
 
         __asm__ volatile (""); // prevents infinite loops from being optimized out.
     }
     exit:;
 
+    if (record_path != nullptr && !recorder.movie().save(record_path)) {
+        std::cout << "could not write movie: " << record_path << std::endl;
+    }
+    if (capture_path != nullptr) {
+        capture.close();
+        std::cout << "captured " << capture.frames_written() << " frames, dropped " << capture.frames_dropped() << std::endl;
+    }
+#ifdef CHIP8_PROFILE
+    if (profile_path != nullptr) {
+        // the capture thread and the scaling threads record zones too, they're stopped first so none is cut off.
+        upscaler.reset();
+        std::cout << "profiled " << profiler_stop() << " zones into " << profile_path << std::endl;
+    }
+#endif
+
     // code cleanup.
+    if (texture != nullptr) SDL_DestroyTexture(texture);
+    if (renderer != nullptr) SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
-    SDL_DestroyRenderer(renderer);
-    SDL_DestroyTexture(texture);
 }
\ No newline at end of file
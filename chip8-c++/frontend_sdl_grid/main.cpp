@@ -0,0 +1,165 @@
+// gives the io streams, which has the ability to write to the terminal.
+#include<iostream>
+
+// includes the core header for us to implement in our frontend.
+#include<core.hpp>
+
+// SDL2 header for rendering.
+#include<SDL2/SDL.h>
+
+// gives the std::mempcy function.
+#include<cstring>
+
+// gives the filestreams to read files from the host system.
+#include<fstream>
+
+// gives access to the std::vector and std::string types.
+#include<vector>
+#include<string>
+
+// the pool of threads running the cores.
+#include<worker_pool.hpp>
+
+// only runs the cores that can run.
+#include<scheduler.hpp>
+
+// gives the std::sqrt function.
+#include<cmath>
+
+// gives the std::min and std::max functions.
+#include<algorithm>
+
+/// the SDL2 keys mapped to each hexpad key, indexed by the hexpad key.
+static const SDL_Scancode HEXPAD_KEYS[16] = {
+    SDL_SCANCODE_0, SDL_SCANCODE_1, SDL_SCANCODE_2, SDL_SCANCODE_3,
+    SDL_SCANCODE_Q, SDL_SCANCODE_W, SDL_SCANCODE_E, SDL_SCANCODE_R,
+    SDL_SCANCODE_A, SDL_SCANCODE_S, SDL_SCANCODE_D, SDL_SCANCODE_F,
+    SDL_SCANCODE_Z, SDL_SCANCODE_X, SDL_SCANCODE_C, SDL_SCANCODE_V,
+};
+
+/// the color of the lines between the cells of the grid, in RGBA.
+static const uint32_t GRID_LINE_COLOR = 0x404040ff;
+
+/// the entry point of the grid frontend. It runs many cores at once and shows all of them in a single window,
+/// composited into one texture atlas, so the cost of presenting doesn't grow with the amount of cores.
+int main(int argc, char* argv[]) {
+    std::vector<std::string> rom_paths;
+    size_t copies = 1;
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    for (int arg = 1; arg < argc; ++arg) {
+        std::string flag = argv[arg];
+        if (flag == "--copies" && arg + 1 < argc) {
+            copies = std::stoul(argv[++arg]);
+        } else if (flag == "--threads" && arg + 1 < argc) {
+            threads = std::max<size_t>(1, std::stoul(argv[++arg]));
+        } else {
+            rom_paths.push_back(flag);
+        }
+    }
+    if (rom_paths.empty() || copies == 0) {
+        std::cout << "usage: chip8-c++-sdl-grid <rom>... [--copies <n>] [--threads <n>]" << std::endl;
+        exit(-1);
+    }
+
+    // creates `copies` cores for every ROM, each copy with its own seed so they don't all do the same thing.
+    std::vector<Core> cores;
+    for (const std::string& path : rom_paths) {
+        std::ifstream ifstream(path, std::ios::binary);
+        std::vector<char> rom((std::istreambuf_iterator<char>(ifstream)), std::istreambuf_iterator<char>());
+        if (!ifstream.is_open() || rom.size() > 4096 - 512) {
+            std::cout << "could not load ROM: " << path << std::endl;
+            exit(-1);
+        }
+        for (size_t copy = 0; copy < copies; ++copy) {
+            cores.push_back(Core::create(rom.data(), rom.size(), Core::DEFAULT_SEED + copy));
+        }
+    }
+
+    // lays the cores out in a grid as close to square as possible, with a one pixel gap between cells.
+    const size_t cell_width = cores[0].framebuffer().width();
+    const size_t cell_height = cores[0].framebuffer().height();
+    const size_t columns = std::ceil(std::sqrt(double(cores.size())));
+    const size_t rows = (cores.size() + columns - 1) / columns;
+    const size_t atlas_width = columns * (cell_width + 1) - 1;
+    const size_t atlas_height = rows * (cell_height + 1) - 1;
+    // the atlas is kept on the CPU as well, as a locked streaming texture doesn't keep its previous contents,
+    // and only the changed part of it is uploaded every frame.
+    std::vector<uint32_t> atlas(atlas_width * atlas_height, GRID_LINE_COLOR);
+    for (size_t index = 0; index < cores.size(); ++index) {
+        const size_t cell_x = (index % columns) * (cell_width + 1);
+        const size_t cell_y = (index / columns) * (cell_height + 1);
+        for (size_t y = 0; y < cell_height; ++y) {
+            std::fill_n(&atlas[(cell_y + y) * atlas_width + cell_x], cell_width, Framebuffer::PIXEL_OFF);
+        }
+    }
+    // the dirty atlas rows of every core, written by the workers and read once they're done.
+    std::vector<uint64_t> dirty(cores.size(), 0);
+
+    SDL_Init(SDL_INIT_EVERYTHING);
+    SDL_Window* window;
+    SDL_Renderer* renderer;
+    SDL_CreateWindowAndRenderer(atlas_width * 3, atlas_height * 3, SDL_WINDOW_RESIZABLE, &window, &renderer);
+    SDL_SetWindowTitle(window, "chip8-c++-sdl-grid");
+    SDL_Texture* texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STREAMING, atlas_width, atlas_height);
+    SDL_UpdateTexture(texture, NULL, atlas.data(), atlas_width * sizeof(uint32_t));
+    auto keyboard = SDL_GetKeyboardState(NULL);
+
+    WorkerPool pool(threads);
+    const uint32_t instructions_per_frame = 60;
+    CoreScheduler scheduler(cores.size(), instructions_per_frame);
+    while (true) {
+        SDL_Event event;
+        while (SDL_PollEvent(&event)) {
+            if (event.type == SDL_QUIT) goto exit;
+        }
+
+        // every core gets the same input, the grid is meant for watching rather than playing.
+        uint16_t hexpad_bitmap = 0;
+        for (size_t key = 0; key < 16; ++key) {
+            hexpad_bitmap |= (keyboard[HEXPAD_KEYS[key]] != 0) << key;
+        }
+
+        // runs every core that can run and composites its changed rows into its cell of the atlas. Every core owns
+        // its own cell, so the workers never write to the same memory. Parked cores don't change, so they have no dirty rows.
+        std::fill(dirty.begin(), dirty.end(), 0);
+        const std::vector<uint32_t>& runnable = scheduler.begin_frame(cores, [&](size_t) { return hexpad_bitmap; });
+        pool.run(runnable.size(), [&](size_t job) {
+            const size_t index = runnable[job];
+            Core& core = cores[index];
+            core.run_frame(hexpad_bitmap, instructions_per_frame);
+            const Framebuffer& fb = core.framebuffer();
+            dirty[index] = fb.dirty_rows();
+            const size_t cell_x = (index % columns) * (cell_width + 1);
+            const size_t cell_y = (index / columns) * (cell_height + 1);
+            for (size_t y = 0; y < cell_height; ++y) {
+                if ((dirty[index] >> y) & 1) {
+                    std::memcpy(&atlas[(cell_y + y) * atlas_width + cell_x], fb.ptr_begin() + y * cell_width, cell_width * sizeof(uint32_t));
+                }
+            }
+        });
+        scheduler.end_frame(cores);
+
+        // finds the span of atlas rows that changed, and uploads just that span in a single update.
+        size_t first_row = atlas_height, last_row = 0;
+        for (size_t index = 0; index < cores.size(); ++index) {
+            if (dirty[index] == 0) continue;
+            const size_t cell_y = (index / columns) * (cell_height + 1);
+            first_row = std::min<size_t>(first_row, cell_y + __builtin_ctzll(dirty[index]));
+            last_row = std::max<size_t>(last_row, cell_y + 63 - __builtin_clzll(dirty[index]));
+        }
+        if (first_row <= last_row) {
+            SDL_Rect rect = { 0, int(first_row), int(atlas_width), int(last_row - first_row + 1) };
+            SDL_UpdateTexture(texture, &rect, &atlas[first_row * atlas_width], atlas_width * sizeof(uint32_t));
+        }
+
+        SDL_RenderClear(renderer);
+        SDL_RenderCopy(renderer, texture, NULL, NULL);
+        SDL_RenderPresent(renderer);
+        SDL_Delay(17 /* roughly 60 frames per second */);
+    }
+    exit:;
+
+    SDL_DestroyTexture(texture);
+    SDL_DestroyRenderer(renderer);
+    SDL_DestroyWindow(window);
+}
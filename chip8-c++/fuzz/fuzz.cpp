@@ -0,0 +1,223 @@
+// the core being fuzzed.
+#include<core.hpp>
+
+// the session, one of the ways of running a core that must agree with the others.
+#include<session_pool.hpp>
+
+// the static analysis, which must cope with any ROM as well.
+#include<analysis.hpp>
+
+// gives the std::vector type.
+#include<vector>
+
+// gives the io streams, to say what went wrong before aborting.
+#include<iostream>
+
+// gives the std::abort function.
+#include<cstdlib>
+
+// gives the std::min function.
+#include<algorithm>
+
+// gives the std::memcmp function.
+#include<cstring>
+
+/// the most frames a fuzz input runs.
+static const uint32_t MAX_FRAMES = 32;
+/// the most instructions a fuzz input runs over all of its frames, which keeps every input fast.
+static const uint32_t MAX_INSTRUCTIONS = 512;
+
+/// the coverage reported back to libFuzzer, in its extra counters section. Every counter is a feature the fuzzer
+/// tries to reach, so inputs reaching new emulated addresses or instructions are kept and mutated further.
+#if defined(CHIP8_LIBFUZZER) && defined(__linux__)
+#define FUZZ_COUNTERS __attribute__((section("__libfuzzer_extra_counters")))
+#else
+#define FUZZ_COUNTERS
+#endif
+
+/// counts the instructions run at every address.
+FUZZ_COUNTERS static uint8_t pc_coverage[0x1000];
+/// counts every kind of instruction run, see `opcode_kind`.
+FUZZ_COUNTERS static uint8_t opcode_coverage[16 * 256];
+/// counts how every input ended, by trap and by whether the core halted, slept or waited for a key.
+FUZZ_COUNTERS static uint8_t outcome_coverage[8 * 8];
+
+/// @brief the kind of an instruction, its first nibble and whatever else tells instructions apart, but none of its
+/// operands. Counting operands as well would reward the fuzzer for every new constant.
+static size_t opcode_kind(uint16_t instruction) {
+    const size_t group = instruction >> 12;
+    switch (group) {
+        case 0x0:
+        case 0xE:
+        case 0xF:
+            return group * 256 + (instruction & 0xff);
+        case 0x5:
+        case 0x8:
+        case 0x9:
+            return group * 256 + (instruction & 0xf);
+        default:
+            return group * 256;
+    }
+}
+
+/// a fuzz input taken apart: a ROM, its input script and how fast to run it.
+///
+/// The script and settings are at the end of the input, so ROMs make good seeds as they are. The low 6 bits of the last
+/// byte give the instructions per frame (minus one) and its top bit whether to run the slower checks as well, the byte before
+/// it the amount of input events, and the events before that are 3 bytes each, the frames since the last event and the
+/// hexpad bitmap. Everything in front of them is the ROM.
+struct FuzzCase {
+    /// the ROM bytes.
+    const char* rom = nullptr;
+    /// the length of the ROM, at most 3584.
+    size_t rom_length = 0;
+    /// the hexpad bitmap of every frame.
+    std::vector<uint16_t> hexpad;
+    /// the amount of instructions every frame runs.
+    uint32_t instructions_per_frame = 1;
+    /// whether to check savestates and analyze the ROM as well, which takes far longer than running it, so only some
+    /// inputs do.
+    bool thorough = false;
+
+    /// @brief takes a fuzz input apart.
+    static FuzzCase parse(const uint8_t* data, size_t size) {
+        FuzzCase fuzz_case;
+        size_t events = 0;
+        if (size >= 2) {
+            fuzz_case.instructions_per_frame = 1 + (data[size - 1] & 0x3f);
+            fuzz_case.thorough = (data[size - 1] & 0x80) != 0;
+            events = std::min<size_t>(data[size - 2], (size - 2) / 3);
+            size -= 2;
+        }
+        const uint32_t frames = std::min(MAX_FRAMES, MAX_INSTRUCTIONS / fuzz_case.instructions_per_frame);
+        fuzz_case.hexpad.assign(frames, 0);
+        const uint8_t* event = data + size - events * 3;
+        uint32_t frame = 0;
+        for (size_t index = 0; index < events; ++index, event += 3) {
+            frame += event[0];
+            for (uint32_t held = frame; held < frames; ++held) {
+                fuzz_case.hexpad[held] = event[1] | (event[2] << 8);
+            }
+        }
+        fuzz_case.rom = reinterpret_cast<const char*>(data);
+        fuzz_case.rom_length = std::min<size_t>(size - events * 3, 4096 - 512);
+        return fuzz_case;
+    }
+};
+
+/// a session playing back the input of a fuzz case.
+struct FuzzSession : Session {
+    FuzzSession(const Core& core, const FuzzCase& fuzz_case)
+        : Session(core, fuzz_case.instructions_per_frame), fuzz_case(fuzz_case) {}
+
+    bool frame_begin(uint64_t frame, uint16_t& hexpad_bitmap) override {
+        if (frame == this->fuzz_case.hexpad.size()) return false;
+        hexpad_bitmap = this->fuzz_case.hexpad[frame];
+        return true;
+    }
+
+    /// the fuzz case being played back.
+    const FuzzCase& fuzz_case;
+};
+
+/// @brief aborts the fuzzer with a message if `ok` is `false`, whether asserts are compiled in or not.
+static void check(bool ok, const char* what) {
+    if (!ok) {
+        std::cerr << "fuzz check failed: " << what << std::endl;
+        std::abort();
+    }
+}
+
+/// @brief compares everything the state of two cores can be seen through from outside, much faster than comparing
+/// their savestates.
+static bool same_state(const Core& a, const Core& b) {
+    const CoreRegisters registers_a = a.registers(), registers_b = b.registers();
+    const Framebuffer& fb_a = a.framebuffer();
+    const Framebuffer& fb_b = b.framebuffer();
+    return registers_a.v == registers_b.v && registers_a.pc == registers_b.pc && registers_a.i == registers_b.i
+        && registers_a.sp == registers_b.sp && registers_a.stack == registers_b.stack
+        && registers_a.timer_delay == registers_b.timer_delay && registers_a.timer_sound == registers_b.timer_sound
+        && registers_a.is_waiting_for_keypress == registers_b.is_waiting_for_keypress
+        && a.memory() == b.memory() && a.trap() == b.trap() && a.halted() == b.halted()
+        && a.sleeping() == b.sleeping() && a.sleep_frames() == b.sleep_frames()
+        && fb_a.dirty_rows() == fb_b.dirty_rows()
+        && std::memcmp(fb_a.ptr_begin(), fb_b.ptr_begin(), fb_a.len() * sizeof(uint32_t)) == 0;
+}
+
+/// @brief saves the state of a core into `buffer`.
+static void save(const Core& core, std::vector<uint8_t>& buffer) {
+    buffer.resize(Core::SAVESTATE_SIZE);
+    core.save_state(buffer.data());
+}
+
+/// @brief runs a fuzz case an instruction at a time, counting the coverage.
+static void run_stepped(Core& core, const FuzzCase& fuzz_case) {
+    for (uint16_t hexpad_bitmap : fuzz_case.hexpad) {
+        core.begin_frame(hexpad_bitmap);
+        for (uint32_t instruction = 0; instruction < fuzz_case.instructions_per_frame; ++instruction) {
+            if (core.can_run()) {
+                const uint16_t pc = core.registers().pc;
+                const std::array<uint8_t, 0x1000>& memory = core.memory();
+                pc_coverage[pc]++;
+                opcode_coverage[opcode_kind((memory[pc] << 8) | memory[(pc + 1) & 0xfff])]++;
+            }
+            core.run_for_instructions(1);
+        }
+        core.tick_timers();
+    }
+}
+
+/// @brief the fuzz target: runs the input as a ROM and input script in three different ways, which must all end in the
+/// same state, and checks savestates of the result and of the raw input.
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    const FuzzCase fuzz_case = FuzzCase::parse(data, size);
+    // the cores are kept from one input to the next, `reset` is much cheaper than creating them.
+    static Core stepped = Core::create(nullptr, 0), whole = stepped;
+    static std::vector<uint8_t> stepped_state, whole_state, other_state;
+
+    stepped.reset(fuzz_case.rom, fuzz_case.rom_length);
+    whole.reset(fuzz_case.rom, fuzz_case.rom_length);
+    FuzzSession session(whole, fuzz_case);
+    run_stepped(stepped, fuzz_case);
+    for (uint16_t hexpad_bitmap : fuzz_case.hexpad) {
+        whole.run_frame(hexpad_bitmap, fuzz_case.instructions_per_frame);
+    }
+    while (session.resume(7) != SessionYield::Done) {}
+
+    check(same_state(stepped, whole), "running whole frames differs from running single instructions");
+    check(same_state(stepped, session.core()), "a session differs from running single instructions");
+
+    uint8_t outcome = static_cast<uint8_t>(stepped.trap()) * 8;
+    outcome |= (stepped.halted() ? 1 : 0) | (stepped.sleeping() ? 2 : 0) | (stepped.waiting_for_keypress() ? 4 : 0);
+    outcome_coverage[outcome]++;
+    if (!fuzz_case.thorough) return 0;
+
+    // savestates capture what `same_state` can't see, like where a sleeping core is in its loop.
+    save(stepped, stepped_state);
+    save(whole, whole_state);
+    check(stepped_state == whole_state, "the savestates of whole frames and single instructions differ");
+    save(session.core(), other_state);
+    check(stepped_state == other_state, "the savestates of a session and single instructions differ");
+
+    // a savestate must restore exactly the state it was saved from.
+    check(whole.load_state(stepped_state.data()), "a savestate was rejected");
+    save(whole, other_state);
+    check(stepped_state == other_state, "restoring a savestate changed the state");
+
+    // the input itself as a savestate, which either has to be rejected or give a core that runs like any other.
+    if (size >= Core::SAVESTATE_SIZE && whole.load_state(data)) {
+        for (uint32_t frame = 0; frame < 8; ++frame) {
+            whole.run_frame(0, fuzz_case.instructions_per_frame);
+        }
+        save(whole, whole_state);
+        check(stepped.load_state(whole_state.data()), "a savestate of a loaded savestate was rejected");
+    }
+
+    const RomAnalysis analysis = analyze_rom(fuzz_case.rom, fuzz_case.rom_length);
+    for (const BasicBlock& block : analysis.blocks) {
+        // blocks wrap around the end of memory like the pc does, so the end can come before the start.
+        check(block.start < 0x1000 && block.end < 0x1000, "a basic block is outside of memory");
+        check(analysis.block_at(block.start) == &block, "a basic block can't be found by its start");
+    }
+    return 0;
+}
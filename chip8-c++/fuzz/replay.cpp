@@ -0,0 +1,35 @@
+// gives the io streams, which has the ability to write to the terminal.
+#include<iostream>
+
+// gives the filestreams to read the inputs.
+#include<fstream>
+
+// gives the std::vector type.
+#include<vector>
+
+// gives the basic integer types.
+#include<stdint.h>
+#include<stddef.h>
+
+/// the fuzz target in `fuzz.cpp`.
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+/// runs the fuzz target once for every file given, for reproducing a crash or checking a corpus when the compiler
+/// has no libFuzzer. With libFuzzer, its own main does this (and fuzzes) instead.
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <input>..." << std::endl;
+        return 1;
+    }
+    for (int arg = 1; arg < argc; ++arg) {
+        std::ifstream stream(argv[arg], std::ios::binary);
+        if (!stream) {
+            std::cerr << "couldn't open " << argv[arg] << std::endl;
+            return 1;
+        }
+        std::vector<uint8_t> input((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+        LLVMFuzzerTestOneInput(input.data(), input.size());
+    }
+    std::cout << "ran " << argc - 1 << " inputs" << std::endl;
+    return 0;
+}
@@ -0,0 +1,178 @@
+// the C interface implemented in this file.
+#include<chip8.h>
+
+// the core behind the handles.
+#include<core.hpp>
+
+// gives std::nothrow, no exception may leave the library.
+#include<new>
+
+/// the core behind a `chip8_core` handle, with the stats the core itself doesn't keep.
+struct chip8_core {
+    chip8_core(const Core& core) : core(core) {}
+
+    Core core;
+    /// the amount of frames run.
+    uint64_t frames = 0;
+    /// the amount of instructions run.
+    uint64_t instructions = 0;
+};
+
+/// the largest ROM that fits in memory.
+static const size_t MAX_ROM_LENGTH = 4096 - 512;
+
+static_assert(CHIP8_FRAMEBUFFER_BITS_SIZE * 8 == 60 * 60, "the exported framebuffer has a bit per pixel");
+
+uint32_t chip8_abi_version(void) {
+    return CHIP8_ABI_VERSION;
+}
+
+chip8_core* chip8_create(const uint8_t* rom, size_t rom_length, uint32_t seed) {
+    if (rom_length > MAX_ROM_LENGTH || (rom == nullptr && rom_length != 0)) {
+        return nullptr;
+    }
+    return new (std::nothrow) chip8_core(Core::create(reinterpret_cast<const char*>(rom), rom_length, seed));
+}
+
+void chip8_destroy(chip8_core* core) {
+    delete core;
+}
+
+int chip8_reset(chip8_core* core, const uint8_t* rom, size_t rom_length, uint32_t seed) {
+    if (core == nullptr || (rom == nullptr && rom_length != 0)) return CHIP8_ERROR_NULL;
+    if (rom_length > MAX_ROM_LENGTH) return CHIP8_ERROR_ROM_TOO_LARGE;
+    core->core.reset(reinterpret_cast<const char*>(rom), rom_length, seed);
+    core->frames = 0;
+    core->instructions = 0;
+    return CHIP8_OK;
+}
+
+void chip8_step(chip8_core* core, size_t instructions) {
+    if (core == nullptr) return;
+    core->core.run_for_instructions(instructions);
+    core->instructions += instructions;
+}
+
+void chip8_run_frame(chip8_core* core, uint16_t hexpad_bitmap, size_t instructions) {
+    if (core == nullptr) return;
+    core->core.run_frame(hexpad_bitmap, instructions);
+    core->frames += 1;
+    core->instructions += instructions;
+}
+
+/// @brief the first condition of `stop_mask` that holds for the core after a frame.
+static int stop_reason(const Core& core, uint32_t stop_mask) {
+    if ((stop_mask & CHIP8_STOP_TRAP) && core.trap() != CoreTrap::None) return CHIP8_STOP_TRAP;
+    if ((stop_mask & CHIP8_STOP_HALT) && core.halted()) return CHIP8_STOP_HALT;
+    if ((stop_mask & CHIP8_STOP_KEYPRESS) && core.waiting_for_keypress()) return CHIP8_STOP_KEYPRESS;
+    if ((stop_mask & CHIP8_STOP_DRAW) && core.framebuffer().dirty_rows() != 0) return CHIP8_STOP_DRAW;
+    if ((stop_mask & CHIP8_STOP_SOUND) && core.registers().timer_sound != 0) return CHIP8_STOP_SOUND;
+    return CHIP8_STOP_NONE;
+}
+
+int chip8_run_until(chip8_core* core, uint16_t hexpad_bitmap, size_t instructions, uint64_t max_frames,
+    uint32_t stop_mask, uint64_t* frames_run) {
+    if (frames_run != nullptr) *frames_run = 0;
+    if (core == nullptr) return CHIP8_ERROR_NULL;
+    int reason = CHIP8_STOP_NONE;
+    uint64_t frame = 0;
+    while (frame < max_frames && reason == CHIP8_STOP_NONE) {
+        chip8_run_frame(core, hexpad_bitmap, instructions);
+        ++frame;
+        reason = stop_reason(core->core, stop_mask);
+    }
+    if (frames_run != nullptr) *frames_run = frame;
+    return reason;
+}
+
+void chip8_run_frames(chip8_core* const* cores, const uint16_t* hexpad_bitmaps, size_t count, size_t instructions) {
+    if (cores == nullptr || hexpad_bitmaps == nullptr) return;
+    for (size_t index = 0; index < count; ++index) {
+        chip8_run_frame(cores[index], hexpad_bitmaps[index], instructions);
+    }
+}
+
+size_t chip8_savestate_size(void) {
+    return Core::SAVESTATE_SIZE;
+}
+
+int chip8_save_state(const chip8_core* core, uint8_t* buffer, size_t length) {
+    if (core == nullptr || buffer == nullptr) return CHIP8_ERROR_NULL;
+    if (length < Core::SAVESTATE_SIZE) return CHIP8_ERROR_BUFFER_TOO_SMALL;
+    core->core.save_state(buffer);
+    return CHIP8_OK;
+}
+
+int chip8_load_state(chip8_core* core, const uint8_t* buffer, size_t length) {
+    if (core == nullptr || buffer == nullptr) return CHIP8_ERROR_NULL;
+    if (length < Core::SAVESTATE_SIZE || !core->core.load_state(buffer)) return CHIP8_ERROR_BAD_SAVESTATE;
+    return CHIP8_OK;
+}
+
+void chip8_framebuffer_size(uint32_t* width, uint32_t* height) {
+    if (width != nullptr) *width = 60;
+    if (height != nullptr) *height = 60;
+}
+
+int chip8_framebuffer_pixels(const chip8_core* core, uint32_t* pixels, size_t length) {
+    if (core == nullptr || pixels == nullptr) return CHIP8_ERROR_NULL;
+    const Framebuffer& fb = core->core.framebuffer();
+    if (length < fb.len()) return CHIP8_ERROR_BUFFER_TOO_SMALL;
+    std::memcpy(pixels, fb.ptr_begin(), fb.len() * sizeof(uint32_t));
+    return CHIP8_OK;
+}
+
+int chip8_framebuffer_bits(const chip8_core* core, uint8_t* bits, size_t length) {
+    if (core == nullptr || bits == nullptr) return CHIP8_ERROR_NULL;
+    if (length < CHIP8_FRAMEBUFFER_BITS_SIZE) return CHIP8_ERROR_BUFFER_TOO_SMALL;
+    const uint32_t* pixels = core->core.framebuffer().ptr_begin();
+    for (size_t byte = 0; byte < CHIP8_FRAMEBUFFER_BITS_SIZE; ++byte) {
+        uint8_t packed = 0;
+        for (size_t bit = 0; bit < 8; ++bit) {
+            packed |= uint8_t(pixels[byte * 8 + bit] == Framebuffer::PIXEL_ON) << (7 - bit);
+        }
+        bits[byte] = packed;
+    }
+    return CHIP8_OK;
+}
+
+uint64_t chip8_dirty_rows(const chip8_core* core) {
+    if (core == nullptr) return 0;
+    return core->core.framebuffer().dirty_rows();
+}
+
+int chip8_registers(const chip8_core* core, chip8_registers_t* registers) {
+    if (core == nullptr || registers == nullptr) return CHIP8_ERROR_NULL;
+    const CoreRegisters source = core->core.registers();
+    for (size_t index = 0; index < 16; ++index) {
+        registers->v[index] = source.v[index];
+        registers->stack[index] = source.stack[index];
+    }
+    registers->pc = source.pc;
+    registers->i = source.i;
+    registers->sp = source.sp;
+    registers->timer_delay = source.timer_delay;
+    registers->timer_sound = source.timer_sound;
+    registers->waiting_for_keypress = source.is_waiting_for_keypress;
+    return CHIP8_OK;
+}
+
+int chip8_read_memory(const chip8_core* core, uint16_t address, uint8_t* buffer, size_t length) {
+    if (core == nullptr || (buffer == nullptr && length != 0)) return CHIP8_ERROR_NULL;
+    const std::array<uint8_t, 0x1000>& memory = core->core.memory();
+    for (size_t index = 0; index < length; ++index) {
+        buffer[index] = memory[(address + index) & 0x0fff];
+    }
+    return CHIP8_OK;
+}
+
+int chip8_stats(const chip8_core* core, chip8_stats_t* stats) {
+    if (core == nullptr || stats == nullptr) return CHIP8_ERROR_NULL;
+    stats->frames = core->frames;
+    stats->instructions = core->instructions;
+    stats->trap = static_cast<uint8_t>(core->core.trap());
+    stats->halted = core->core.halted();
+    stats->sleeping = core->core.sleeping();
+    stats->trap_pc = core->core.trap_pc();
+    return CHIP8_OK;
+}
@@ -0,0 +1,179 @@
+// the C interface of libchip8, for embedding the core in programs that aren't written in C++.
+#ifndef CHIP8_H
+#define CHIP8_H
+
+// gives the fixed width integer types and size_t.
+#include<stdint.h>
+#include<stddef.h>
+
+// exports the functions from the shared library and leaves everything else in it hidden.
+#if defined(_WIN32)
+#  ifdef CHIP8_BUILDING_LIBRARY
+#    define CHIP8_API __declspec(dllexport)
+#  else
+#    define CHIP8_API __declspec(dllimport)
+#  endif
+#else
+#  define CHIP8_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// the version of this interface, only changes when an existing function or struct changes. See `chip8_abi_version`.
+#define CHIP8_ABI_VERSION 1
+
+/// the size in bytes of a framebuffer exported with one bit per pixel, see `chip8_framebuffer_bits`.
+#define CHIP8_FRAMEBUFFER_BITS_SIZE (60 * 60 / 8)
+
+/// a core, only ever handled through a pointer. Created with `chip8_create` and freed with `chip8_destroy`.
+typedef struct chip8_core chip8_core;
+
+/// what the functions returning an `int` return, every error is negative.
+enum chip8_result {
+    /// the call succeeded.
+    CHIP8_OK = 0,
+    /// a pointer that can't be null was null.
+    CHIP8_ERROR_NULL = -1,
+    /// the ROM is larger than the 3584 bytes that fit in memory.
+    CHIP8_ERROR_ROM_TOO_LARGE = -2,
+    /// the buffer given is too small for what's written into it.
+    CHIP8_ERROR_BUFFER_TOO_SMALL = -3,
+    /// the savestate is broken or from another version.
+    CHIP8_ERROR_BAD_SAVESTATE = -4,
+};
+
+/// the conditions `chip8_run_until` stops on, combined into a mask. Also what it returns as the reason it stopped.
+enum chip8_stop {
+    /// ran every frame it was given, never set in a mask.
+    CHIP8_STOP_NONE = 0,
+    /// the core trapped on a broken instruction, see `chip8_stats::trap`.
+    CHIP8_STOP_TRAP = 1 << 0,
+    /// the core halted on a jump to itself.
+    CHIP8_STOP_HALT = 1 << 1,
+    /// the core waits for a key to be pressed.
+    CHIP8_STOP_KEYPRESS = 1 << 2,
+    /// a frame changed the framebuffer.
+    CHIP8_STOP_DRAW = 1 << 3,
+    /// the sound timer is running, the core beeps.
+    CHIP8_STOP_SOUND = 1 << 4,
+};
+
+/// the registers of a core, see `chip8_registers`.
+typedef struct chip8_registers_t {
+    /// the 16 general purpose registers.
+    uint8_t v[16];
+    /// the call stack, `sp` entries of it are in use.
+    uint16_t stack[16];
+    /// the pc register.
+    uint16_t pc;
+    /// the i register.
+    uint16_t i;
+    /// the stack pointer.
+    uint8_t sp;
+    /// the delay timer.
+    uint8_t timer_delay;
+    /// the sound timer.
+    uint8_t timer_sound;
+    /// whether the core waits for a keypress, 0 or 1.
+    uint8_t waiting_for_keypress;
+} chip8_registers_t;
+
+/// what a core did since it was created or reset, and the state it's in, see `chip8_stats`.
+typedef struct chip8_stats_t {
+    /// the amount of frames run.
+    uint64_t frames;
+    /// the amount of instructions run, counting the ones a halted, sleeping or waiting core would have gone around.
+    uint64_t instructions;
+    /// the `CoreTrap` the core stopped on, 0 if it's running.
+    uint8_t trap;
+    /// whether the core halted, 0 or 1.
+    uint8_t halted;
+    /// whether the core sleeps until its delay timer runs out, 0 or 1.
+    uint8_t sleeping;
+    /// the address of the instruction that trapped, only meaningful if `trap` isn't 0.
+    uint16_t trap_pc;
+} chip8_stats_t;
+
+/// @brief the `CHIP8_ABI_VERSION` the library was built with, which callers loading it at runtime should check.
+CHIP8_API uint32_t chip8_abi_version(void);
+
+/// @brief creates a core with a ROM loaded at 0x200.
+/// @param rom the ROM bytes, may be null if `rom_length` is 0
+/// @param rom_length the length of the ROM, at most 3584 bytes
+/// @param seed the seed of the core's random numbers, 0 uses the default one
+/// @return the core, or null if the ROM is too large or there's no memory left
+CHIP8_API chip8_core* chip8_create(const uint8_t* rom, size_t rom_length, uint32_t seed);
+
+/// @brief frees a core, null is ignored.
+CHIP8_API void chip8_destroy(chip8_core* core);
+
+/// @brief puts a core back in the state `chip8_create` would return it in, with another ROM, and clears its stats.
+/// @return `CHIP8_OK`, `CHIP8_ERROR_NULL` or `CHIP8_ERROR_ROM_TOO_LARGE`, which leaves the core as it was
+CHIP8_API int chip8_reset(chip8_core* core, const uint8_t* rom, size_t rom_length, uint32_t seed);
+
+/// @brief runs instructions without starting or ending a frame, the timers don't tick. A null core is ignored.
+CHIP8_API void chip8_step(chip8_core* core, size_t instructions);
+
+/// @brief runs a frame: applies the hexpad, runs the instructions and ticks the timers. A null core is ignored.
+/// @param hexpad_bitmap the pressed keys, bit `n` is key `n`
+CHIP8_API void chip8_run_frame(chip8_core* core, uint16_t hexpad_bitmap, size_t instructions);
+
+/// @brief runs frames with the same hexpad until a condition in `stop_mask` holds after a frame, or `max_frames` ran.
+/// @param frames_run the amount of frames run, may be null
+/// @return the first condition of `stop_mask` that held, `CHIP8_STOP_NONE` if none did, or `CHIP8_ERROR_NULL`
+CHIP8_API int chip8_run_until(chip8_core* core, uint16_t hexpad_bitmap, size_t instructions, uint64_t max_frames,
+    uint32_t stop_mask, uint64_t* frames_run);
+
+/// @brief runs a frame on every core, the same as calling `chip8_run_frame` on each of them, in one call.
+/// @param cores the cores, null ones are skipped. Nothing runs if `cores` or `hexpad_bitmaps` is null
+/// @param hexpad_bitmaps the hexpad of every core
+/// @param count the amount of cores
+CHIP8_API void chip8_run_frames(chip8_core* const* cores, const uint16_t* hexpad_bitmaps, size_t count, size_t instructions);
+
+/// @brief the size of a savestate, the same for every core of this version.
+CHIP8_API size_t chip8_savestate_size(void);
+
+/// @brief writes a savestate of the core into `buffer`.
+/// @return `CHIP8_OK`, `CHIP8_ERROR_NULL` or `CHIP8_ERROR_BUFFER_TOO_SMALL` if `length` is below `chip8_savestate_size`
+CHIP8_API int chip8_save_state(const chip8_core* core, uint8_t* buffer, size_t length);
+
+/// @brief loads a savestate, the stats are kept.
+/// @return `CHIP8_OK`, `CHIP8_ERROR_NULL`, or `CHIP8_ERROR_BAD_SAVESTATE`, which leaves the core as it was
+CHIP8_API int chip8_load_state(chip8_core* core, const uint8_t* buffer, size_t length);
+
+/// @brief the size of the framebuffer in pixels, 60 by 60.
+CHIP8_API void chip8_framebuffer_size(uint32_t* width, uint32_t* height);
+
+/// @brief copies the framebuffer, a 32 bit pixel per pixel, row by row, 0 when off and 0xffffffff when on.
+/// @param pixels the destination, at least width * height pixels
+/// @param length the amount of pixels `pixels` has room for
+/// @return `CHIP8_OK`, `CHIP8_ERROR_NULL` or `CHIP8_ERROR_BUFFER_TOO_SMALL`
+CHIP8_API int chip8_framebuffer_pixels(const chip8_core* core, uint32_t* pixels, size_t length);
+
+/// @brief copies the framebuffer with a bit per pixel, row by row, the first pixel in the highest bit of the first byte.
+/// @param length the size of `bits`, at least `CHIP8_FRAMEBUFFER_BITS_SIZE`
+/// @return `CHIP8_OK`, `CHIP8_ERROR_NULL` or `CHIP8_ERROR_BUFFER_TOO_SMALL`
+CHIP8_API int chip8_framebuffer_bits(const chip8_core* core, uint8_t* bits, size_t length);
+
+/// @brief the rows the last frame changed, bit `n` is row `n`. 0 for a null core.
+CHIP8_API uint64_t chip8_dirty_rows(const chip8_core* core);
+
+/// @brief copies the registers of a core.
+/// @return `CHIP8_OK` or `CHIP8_ERROR_NULL`
+CHIP8_API int chip8_registers(const chip8_core* core, chip8_registers_t* registers);
+
+/// @brief copies memory from the core, wrapping around at the end of the 4096 bytes.
+/// @return `CHIP8_OK` or `CHIP8_ERROR_NULL`
+CHIP8_API int chip8_read_memory(const chip8_core* core, uint16_t address, uint8_t* buffer, size_t length);
+
+/// @brief copies the stats of a core.
+/// @return `CHIP8_OK` or `CHIP8_ERROR_NULL`
+CHIP8_API int chip8_stats(const chip8_core* core, chip8_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,134 @@
+// the movie declarations implemented in this file.
+#include<movie.hpp>
+
+// gives the filestreams to read and write movie files.
+#include<fstream>
+
+// gives the std::equal function.
+#include<algorithm>
+
+/// the magic bytes at the start of every movie file, "C8MV" followed by a format version.
+static const uint8_t MOVIE_MAGIC[8] = { 'C', '8', 'M', 'V', 1, 0, 0, 0 };
+
+/// @brief writes `value` as `bytes` little endian bytes to `stream`.
+static void write_le(std::ofstream& stream, uint64_t value, size_t bytes) {
+    for (size_t b = 0; b < bytes; ++b) {
+        stream.put(static_cast<char>((value >> (b * 8)) & 0xff));
+    }
+}
+
+/// @brief reads `bytes` little endian bytes from `stream`. Failures are detected by checking the stream afterwards.
+static uint64_t read_le(std::ifstream& stream, size_t bytes) {
+    uint64_t value = 0;
+    for (size_t b = 0; b < bytes; ++b) {
+        value |= uint64_t(static_cast<uint8_t>(stream.get())) << (b * 8);
+    }
+    return value;
+}
+
+bool Movie::save(const char* path) const {
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    stream.write(reinterpret_cast<const char*>(MOVIE_MAGIC), sizeof(MOVIE_MAGIC));
+    write_le(stream, this->rom_hash, 8);
+    write_le(stream, this->settings.seed, 4);
+    write_le(stream, this->settings.instructions_per_frame, 4);
+    write_le(stream, this->settings.keyframe_interval, 4);
+    write_le(stream, this->inputs.size(), 4);
+    for (uint16_t input : this->inputs) {
+        write_le(stream, input, 2);
+    }
+    write_le(stream, this->keyframes.size(), 4);
+    for (const MovieKeyframe& keyframe : this->keyframes) {
+        assert(keyframe.state.size() == Core::SAVESTATE_SIZE);
+        write_le(stream, keyframe.frame, 4);
+        stream.write(reinterpret_cast<const char*>(keyframe.state.data()), keyframe.state.size());
+    }
+    return stream.good();
+}
+
+bool Movie::load(const char* path, Movie& movie) {
+    std::ifstream stream(path, std::ios::binary | std::ios::ate);
+    const uint64_t file_size = stream ? uint64_t(stream.tellg()) : 0;
+    stream.seekg(0);
+    // the counts are checked against what's left of the file before anything is allocated for them, so a broken
+    // or truncated movie can't ask for gigabytes.
+    auto fits = [&](uint64_t count, uint64_t entry_size) {
+        const std::streamoff at = stream.tellg();
+        return at >= 0 && count * entry_size <= file_size - uint64_t(at);
+    };
+    uint8_t magic[sizeof(MOVIE_MAGIC)];
+    stream.read(reinterpret_cast<char*>(magic), sizeof(magic));
+    if (!stream || !std::equal(magic, magic + sizeof(magic), MOVIE_MAGIC)) {
+        return false;
+    }
+    Movie loaded;
+    loaded.rom_hash = read_le(stream, 8);
+    loaded.settings.seed = read_le(stream, 4);
+    loaded.settings.instructions_per_frame = read_le(stream, 4);
+    loaded.settings.keyframe_interval = read_le(stream, 4);
+    const uint64_t input_count = read_le(stream, 4);
+    if (!stream || !fits(input_count, 2)) {
+        return false;
+    }
+    loaded.inputs.resize(input_count);
+    for (uint16_t& input : loaded.inputs) {
+        input = read_le(stream, 2);
+    }
+    const uint64_t keyframe_count = read_le(stream, 4);
+    if (!stream || !fits(keyframe_count, 4 + Core::SAVESTATE_SIZE)) {
+        return false;
+    }
+    loaded.keyframes.resize(keyframe_count);
+    for (MovieKeyframe& keyframe : loaded.keyframes) {
+        keyframe.frame = read_le(stream, 4);
+        keyframe.state.resize(Core::SAVESTATE_SIZE);
+        stream.read(reinterpret_cast<char*>(keyframe.state.data()), keyframe.state.size());
+    }
+    if (!stream) {
+        return false;
+    }
+    movie = std::move(loaded);
+    return true;
+}
+
+void MovieRecorder::run_frame(Core& core, uint16_t hexpad_bitmap) {
+    const uint32_t frame = this->recording.inputs.size();
+    const uint32_t interval = this->recording.settings.keyframe_interval;
+    // a keyframe is always taken at frame 0, so seeking always has a starting point.
+    if (frame == 0 || (interval != 0 && frame % interval == 0)) {
+        MovieKeyframe keyframe { frame, std::vector<uint8_t>(Core::SAVESTATE_SIZE) };
+        core.save_state(keyframe.state.data());
+        this->recording.keyframes.push_back(std::move(keyframe));
+    }
+    this->recording.inputs.push_back(hexpad_bitmap);
+    core.run_frame(hexpad_bitmap, this->recording.settings.instructions_per_frame);
+}
+
+bool MoviePlayer::step(Core& core) {
+    if (this->finished()) {
+        return false;
+    }
+    core.run_frame(this->movie.inputs[this->frame++], this->movie.settings.instructions_per_frame);
+    return true;
+}
+
+bool MoviePlayer::seek(Core& core, size_t frame) {
+    if (frame > this->movie.frame_count()) {
+        return false;
+    }
+    // finds the last keyframe at or before `frame`, keyframes are ordered so the search can stop early.
+    const MovieKeyframe* nearest = nullptr;
+    for (const MovieKeyframe& keyframe : this->movie.keyframes) {
+        if (keyframe.frame > frame) break;
+        nearest = &keyframe;
+    }
+    if (nearest == nullptr || nearest->state.size() != Core::SAVESTATE_SIZE || !core.load_state(nearest->state.data())) {
+        return false;
+    }
+    // fast forwards from the keyframe without presenting anything.
+    this->frame = nearest->frame;
+    while (this->frame < frame) {
+        this->step(core);
+    }
+    return true;
+}
@@ -0,0 +1,124 @@
+// no duplicate includes.
+#pragma once
+
+// the core which movies record and replay.
+#include<core.hpp>
+
+// gives the std::vector type used for the recorded inputs and keyframes.
+#include<vector>
+
+/// the settings a movie is recorded with. Replaying needs the exact same settings to be bit-exact,
+/// which is why they are stored inside the movie.
+struct MovieSettings {
+    /// the seed the core was created with.
+    uint32_t seed = Core::DEFAULT_SEED;
+    /// the amount of instructions run every frame.
+    uint32_t instructions_per_frame = 60;
+    /// how many frames there are between two embedded savestates. Lower values make seeking faster
+    /// at the cost of a larger movie file, as every keyframe is a full savestate.
+    uint32_t keyframe_interval = 600;
+};
+
+/// a savestate embedded in a movie, taken right before `frame` was run.
+struct MovieKeyframe {
+    /// the frame the savestate was taken before.
+    uint32_t frame;
+    /// the savestate, `Core::SAVESTATE_SIZE` bytes.
+    std::vector<uint8_t> state;
+};
+
+/// a recording of every input given to a core since power-on. Since the core is deterministic for a given
+/// ROM, seed and settings, replaying the inputs reproduces the recorded session exactly.
+struct Movie {
+    /// the `fnv1a_hash` of the ROM the movie was recorded with.
+    uint64_t rom_hash = 0;
+    /// the settings the movie was recorded with.
+    MovieSettings settings;
+    /// the hexpad bitmap of every frame, in order.
+    std::vector<uint16_t> inputs;
+    /// the embedded savestates, ordered by frame. The first is always taken at frame 0.
+    std::vector<MovieKeyframe> keyframes;
+
+    /// the amount of recorded frames.
+    size_t frame_count() const {
+        return this->inputs.size();
+    }
+
+    /// @brief writes the movie to a file.
+    /// @param path the path of the file, which is overwritten
+    /// @return whether the movie was written successfully
+    bool save(const char* path) const;
+
+    /// @brief reads a movie written by `save`.
+    /// @param path the path of the movie file
+    /// @param movie the movie to read into, only modified if reading succeeds
+    /// @return whether the file was a valid movie
+    static bool load(const char* path, Movie& movie);
+};
+
+/// records the inputs of a core frame by frame into a movie.
+struct MovieRecorder {
+    /// @brief creates a recorder for a core created with `Core::create(rom, rom_length, settings.seed)`.
+    /// @param rom the ROM of the recorded core, used to identify the ROM when replaying
+    /// @param rom_length the length of `rom` in bytes
+    /// @param settings the settings to record with
+    MovieRecorder(const char rom[], size_t rom_length, MovieSettings settings) {
+        this->recording.rom_hash = fnv1a_hash(rom, rom_length);
+        this->recording.settings = settings;
+    }
+
+    /// @brief runs a frame of `core` with `hexpad_bitmap` and records it, embedding a keyframe when one is due.
+    /// @param core the recorded core, must be the same core every call
+    /// @param hexpad_bitmap the hexpad state for the frame
+    void run_frame(Core& core, uint16_t hexpad_bitmap);
+
+    /// the movie recorded so far.
+    const Movie& movie() const {
+        return this->recording;
+    }
+private:
+    /// the movie being recorded.
+    Movie recording;
+};
+
+/// plays a movie back on a core, and allows seeking to any frame of it.
+struct MoviePlayer {
+    /// @brief creates a player for `movie`. The movie must outlive the player.
+    /// @param movie the movie to play
+    MoviePlayer(const Movie& movie) : movie(movie) {}
+
+    /// @brief checks whether `rom` is the ROM the movie was recorded with.
+    /// @param rom the ROM bytes
+    /// @param rom_length the length of `rom` in bytes
+    /// @return `true` if the hashes match
+    bool matches_rom(const char rom[], size_t rom_length) const {
+        return fnv1a_hash(rom, rom_length) == this->movie.rom_hash;
+    }
+
+    /// @brief runs the next recorded frame on `core`.
+    /// @param core the core to play on
+    /// @return `false` if the movie has ended and no frame was run
+    bool step(Core& core);
+
+    /// @brief restores the nearest keyframe at or before `frame` and then runs the remaining frames headlessly,
+    /// @brief leaving `core` in the exact state it was in right before `frame` was recorded.
+    /// @param core the core to seek, its current state is irrelevant
+    /// @param frame the frame to seek to, at most `movie.frame_count()`
+    /// @return `false` if the frame is out of range or the movie has no valid keyframe, leaving `core` untouched
+    bool seek(Core& core, size_t frame);
+
+    /// the next frame to be played.
+    size_t current_frame() const {
+        return this->frame;
+    }
+
+    /// whether every frame of the movie has been played.
+    bool finished() const {
+        return this->frame >= this->movie.frame_count();
+    }
+private:
+    /// the movie being played.
+    const Movie& movie;
+    /// the next frame to be played.
+    size_t frame = 0;
+};
@@ -0,0 +1,74 @@
+// the netplay declarations implemented in this file.
+#include<netplay.hpp>
+
+// gives the std::min function.
+#include<algorithm>
+
+NetplaySession::NetplaySession(const Core& core, NetplayTransport& transport, NetplaySettings settings)
+    : transport(transport), settings(settings), current(core) {
+    assert(settings.max_rollback > 0);
+    // the window has to hold every frame from the oldest unconfirmed one up to the furthest input the remote
+    // player can send, which is at most `max_rollback + input_delay` frames ahead of our own inputs.
+    const size_t window = 2 * (settings.max_rollback + settings.input_delay) + 2;
+    this->slots.assign(window, FrameSlot { UINT32_MAX, core, 0, 0, false });
+    // nobody can give input for the frames inside the initial delay, so they are confirmed to be empty.
+    for (uint32_t frame = 0; frame < settings.input_delay; ++frame) {
+        this->slot(frame).confirmed = true;
+    }
+    this->confirmed_frame = settings.input_delay;
+}
+
+void NetplaySession::simulate(uint32_t frame) {
+    FrameSlot& slot = this->slot(frame);
+    slot.state = this->current;
+    // predicts that the remote player is still holding the same keys.
+    if (!slot.confirmed) {
+        slot.remote = this->last_remote;
+    }
+    this->current.run_frame(slot.local | slot.remote, this->settings.instructions_per_frame);
+}
+
+bool NetplaySession::advance_frame(uint16_t local_bitmap) {
+    // confirms every received input, and finds the earliest frame that was simulated with a wrong prediction.
+    this->received.clear();
+    this->transport.receive(this->received);
+    uint32_t rollback_frame = this->next_frame;
+    for (const NetplayPacket& packet : this->received) {
+        FrameSlot& slot = this->slot(packet.frame);
+        if (packet.frame < this->next_frame && slot.remote != packet.hexpad_bitmap) {
+            rollback_frame = std::min(rollback_frame, packet.frame);
+        }
+        slot.remote = packet.hexpad_bitmap;
+        slot.confirmed = true;
+        this->last_remote = packet.hexpad_bitmap;
+    }
+    while (this->slot(this->confirmed_frame).confirmed) {
+        this->confirmed_frame += 1;
+    }
+
+    // rolls back to the misprediction and simulates every frame since again, now with the received inputs.
+    if (rollback_frame < this->next_frame) {
+        const uint32_t depth = this->next_frame - rollback_frame;
+        this->current = this->slot(rollback_frame).state;
+        for (uint32_t frame = rollback_frame; frame < this->next_frame; ++frame) {
+            this->simulate(frame);
+        }
+        this->counters.rollbacks += 1;
+        this->counters.resimulated_frames += depth;
+        this->counters.max_rollback_depth = std::max(this->counters.max_rollback_depth, depth);
+    }
+
+    // stalls when running ahead any further would need a rollback deeper than the window allows.
+    if (this->next_frame >= this->confirmed_frame + this->settings.max_rollback) {
+        this->counters.stalls += 1;
+        return false;
+    }
+
+    // queues and sends the local input for the frame `input_delay` frames from now, then runs the current frame.
+    const uint32_t input_frame = this->next_frame + this->settings.input_delay;
+    this->slot(input_frame).local = local_bitmap;
+    this->transport.send({ input_frame, local_bitmap });
+    this->simulate(this->next_frame);
+    this->next_frame += 1;
+    return true;
+}
@@ -0,0 +1,174 @@
+// no duplicate includes.
+#pragma once
+
+// the core which is kept in sync between the players.
+#include<core.hpp>
+
+// gives the std::vector and std::deque types used for buffering inputs and packets.
+#include<vector>
+#include<deque>
+
+/// a single input sent from one player to the other.
+struct NetplayPacket {
+    /// the frame the input is for.
+    uint32_t frame;
+    /// the hexpad bitmap of the sending player for `frame`.
+    uint16_t hexpad_bitmap;
+};
+
+/// the connection between two players. Implementations only need to deliver packets in order,
+/// the session itself takes care of late packets by rolling back.
+struct NetplayTransport {
+    virtual ~NetplayTransport() = default;
+
+    /// @brief sends a packet to the other player.
+    /// @param packet the packet to send
+    virtual void send(const NetplayPacket& packet) = 0;
+
+    /// @brief receives every packet that has arrived since the last call, without blocking.
+    /// @param packets the received packets are appended to this vector
+    virtual void receive(std::vector<NetplayPacket>& packets) = 0;
+};
+
+/// an in-process stand-in for a socket, connecting two sessions in the same process. Every packet
+/// is held back for `latency` calls to `receive`, which simulates a network round trip and forces rollbacks.
+struct LoopbackTransport : NetplayTransport {
+    /// @brief creates an unconnected loopback end.
+    /// @param latency how many calls to `receive` it takes for a packet sent to this end to arrive
+    LoopbackTransport(uint32_t latency = 0) : latency(latency) {}
+
+    /// @brief connects two loopback ends to each other.
+    static void connect(LoopbackTransport& a, LoopbackTransport& b) {
+        a.peer = &b;
+        b.peer = &a;
+    }
+
+    void send(const NetplayPacket& packet) override {
+        assert(this->peer != nullptr);
+        this->peer->inbox.push_back({ packet, this->peer->latency });
+    }
+
+    void receive(std::vector<NetplayPacket>& packets) override {
+        for (auto& pending : this->inbox) {
+            if (pending.delay > 0) pending.delay -= 1;
+        }
+        while (!this->inbox.empty() && this->inbox.front().delay == 0) {
+            packets.push_back(this->inbox.front().packet);
+            this->inbox.pop_front();
+        }
+    }
+private:
+    /// a packet which has been sent but hasn't arrived yet.
+    struct Pending {
+        NetplayPacket packet;
+        uint32_t delay;
+    };
+    /// the latency of packets sent to this end.
+    uint32_t latency;
+    /// the other end of the loopback.
+    LoopbackTransport* peer = nullptr;
+    /// the packets sent to this end, in order.
+    std::deque<Pending> inbox;
+};
+
+/// the settings of a netplay session, which must be the same for both players.
+struct NetplaySettings {
+    /// how many frames local input is delayed by. A delay that covers the network latency avoids rollbacks entirely,
+    /// at the cost of input lag.
+    uint32_t input_delay = 2;
+    /// how many frames the session may run ahead of the last confirmed remote input before it stalls.
+    uint32_t max_rollback = 8;
+    /// the amount of instructions run every frame.
+    uint32_t instructions_per_frame = 60;
+};
+
+/// counters describing how much work rolling back has cost.
+struct NetplayStats {
+    /// the amount of rollbacks, a rollback happens when a predicted remote input turns out wrong.
+    uint64_t rollbacks = 0;
+    /// the total amount of frames simulated again because of rollbacks.
+    uint64_t resimulated_frames = 0;
+    /// the most frames re-simulated by a single rollback.
+    uint32_t max_rollback_depth = 0;
+    /// the amount of times `advance_frame` stalled waiting on the remote player.
+    uint64_t stalls = 0;
+};
+
+/// a two player session over a single core using rollback. Both players' hexpads are combined into the core's hexpad.
+/// Remote input that hasn't arrived yet is predicted to be the same as the last one received; when the real input
+/// arrives and differs, the core is restored to the frame of the misprediction and the frames since are run again.
+struct NetplaySession {
+    /// @brief creates a session. Both players must create their core with the same ROM and seed.
+    /// @param core the core to run, it's copied into the session
+    /// @param transport the connection to the other player, must outlive the session
+    /// @param settings the session settings
+    NetplaySession(const Core& core, NetplayTransport& transport, NetplaySettings settings);
+
+    /// @brief runs a single frame, unless the remote player is too far behind.
+    /// @param local_bitmap the local player's hexpad, applied `input_delay` frames from now
+    /// @return `false` if the session stalled and no frame was run, the local input is then dropped
+    bool advance_frame(uint16_t local_bitmap);
+
+    /// the core, as of the latest simulated frame.
+    const Core& core() const {
+        return this->current;
+    }
+
+    /// the next frame to be simulated.
+    uint32_t frame() const {
+        return this->next_frame;
+    }
+
+    /// the rollback counters.
+    const NetplayStats& stats() const {
+        return this->counters;
+    }
+private:
+    /// the state of a single frame within the rollback window.
+    struct FrameSlot {
+        /// the frame this slot currently holds, slots are reused as the window moves forward.
+        uint32_t frame;
+        /// the core right before the frame was run.
+        Core state;
+        /// the local input of the frame.
+        uint16_t local = 0;
+        /// the remote input of the frame, either received or predicted.
+        uint16_t remote = 0;
+        /// whether `remote` was received, as opposed to predicted.
+        bool confirmed = false;
+    };
+
+    /// @brief gets the slot of a frame within the rollback window, clearing it if it held an older frame.
+    FrameSlot& slot(uint32_t frame) {
+        FrameSlot& slot = this->slots[frame % this->slots.size()];
+        if (slot.frame != frame) {
+            slot.frame = frame;
+            slot.local = 0;
+            slot.remote = 0;
+            slot.confirmed = false;
+        }
+        return slot;
+    }
+
+    /// @brief runs `frame`, saving the core in its slot first.
+    void simulate(uint32_t frame);
+
+    /// the connection to the remote player.
+    NetplayTransport& transport;
+    /// the session settings.
+    NetplaySettings settings;
+    /// the core as of `next_frame`.
+    Core current;
+    /// the rollback window, indexed by frame modulo its size.
+    std::vector<FrameSlot> slots;
+    /// the next frame to be simulated.
+    uint32_t next_frame = 0;
+    /// every remote input before this frame is confirmed.
+    uint32_t confirmed_frame = 0;
+    /// the latest received remote input, used as the prediction for later frames.
+    uint16_t last_remote = 0;
+    /// the received packets, kept to avoid allocating every frame.
+    std::vector<NetplayPacket> received;
+    /// the rollback counters.
+    NetplayStats counters;
+};
@@ -0,0 +1,94 @@
+// the performance counter declarations implemented in this file.
+#include<perf_counters.hpp>
+
+// gives perf_event_open, which has no glibc wrapper, and the ioctls that control a counter.
+#include<linux/perf_event.h>
+#include<sys/syscall.h>
+#include<sys/ioctl.h>
+#include<unistd.h>
+
+// gives the std::memset function, and std::strerror for the reason counters are unavailable.
+#include<cstring>
+#include<cerrno>
+
+/// @brief the type and config of the event counted by a counter.
+static void event_of(PerfCounter counter, perf_event_attr& attr) {
+    const uint64_t cache_read_miss = (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    switch (counter) {
+        case PERF_CYCLES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case PERF_INSTRUCTIONS:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case PERF_BRANCH_MISSES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+        case PERF_L1D_MISSES:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_L1D | cache_read_miss;
+            break;
+        default:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_LL | cache_read_miss;
+            break;
+    }
+}
+
+PerfCounters::~PerfCounters() {
+    for (int fd : this->fds) {
+        if (fd >= 0) close(fd);
+    }
+}
+
+bool PerfCounters::open() {
+    bool any = false;
+    for (uint32_t counter = 0; counter < PERF_COUNTERS; ++counter) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        event_of(PerfCounter(counter), attr);
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        // the time the event was enabled and actually counted, to scale up the count when counters are shared.
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        // every event is a counter of its own instead of a group, so an event the CPU lacks doesn't take the others with it.
+        this->fds[counter] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        if (this->fds[counter] >= 0) {
+            any = true;
+        } else if (this->reason.empty()) {
+            this->reason = std::strerror(errno);
+        }
+    }
+    return any;
+}
+
+void PerfCounters::start() {
+    for (int fd : this->fds) {
+        if (fd < 0) continue;
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+PerfSample PerfCounters::stop() {
+    for (int fd : this->fds) {
+        if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    }
+    PerfSample sample;
+    for (uint32_t counter = 0; counter < PERF_COUNTERS; ++counter) {
+        // the count, the time enabled and the time running.
+        uint64_t values[3];
+        if (this->fds[counter] < 0 || read(this->fds[counter], values, sizeof(values)) != sizeof(values)) continue;
+        // an event that never got a hardware counter wasn't counted at all.
+        if (values[2] == 0) continue;
+        sample.values[counter] = values[2] < values[1] ? uint64_t(double(values[0]) * values[1] / values[2]) : values[0];
+        sample.counted[counter] = true;
+    }
+    return sample;
+}
@@ -0,0 +1,74 @@
+// no duplicate includes.
+#pragma once
+
+// gives the fixed width integer types.
+#include<cstdint>
+
+// gives the std::string type of the reason counters are unavailable.
+#include<string>
+
+/// the hardware events counted by `PerfCounters`.
+enum PerfCounter : uint32_t {
+    /// CPU cycles.
+    PERF_CYCLES,
+    /// instructions retired by the host CPU.
+    PERF_INSTRUCTIONS,
+    /// mispredicted branches.
+    PERF_BRANCH_MISSES,
+    /// reads missing the level 1 data cache.
+    PERF_L1D_MISSES,
+    /// reads missing the last level cache, going out to memory.
+    PERF_LLC_MISSES,
+    /// the amount of counters.
+    PERF_COUNTERS,
+};
+
+/// what the counters counted between a `start` and a `stop`.
+struct PerfSample {
+    /// the count of every event, scaled up when the kernel had to share the hardware counters between events and
+    /// only counted an event part of the time.
+    uint64_t values[PERF_COUNTERS] = {};
+    /// whether an event was counted, events the CPU or the kernel doesn't have are left out.
+    bool counted[PERF_COUNTERS] = {};
+
+    /// @brief the host instructions retired per cycle, 0 if either isn't counted.
+    double ipc() const {
+        return this->counted[PERF_CYCLES] && this->counted[PERF_INSTRUCTIONS] && this->values[PERF_CYCLES] != 0
+            ? double(this->values[PERF_INSTRUCTIONS]) / this->values[PERF_CYCLES] : 0;
+    }
+};
+
+/// @brief reads the CPU's performance counters (cycles, instructions, branch and cache misses) around a piece of code,
+/// @brief through Linux's `perf_event_open`.
+/// @brief
+/// @brief the counters only count this process in user space, so it works with the default `perf_event_paranoid`
+/// @brief setting. Threads and processes started after `open` are counted as well, but only once they've exited, so
+/// @brief threads that are still running when `stop` is called aren't. Containers and virtual machines often have
+/// @brief no counters at all, or are not allowed to use them, in which case `open` fails and the caller goes without.
+struct PerfCounters {
+    PerfCounters() = default;
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+    /// closes the counters.
+    ~PerfCounters();
+
+    /// @brief opens a counter for every event the CPU has.
+    /// @return `false` if no event could be counted, `error` says why
+    bool open();
+
+    /// @brief zeroes the counters and starts counting.
+    void start();
+
+    /// @brief stops counting.
+    /// @return what was counted since `start`
+    PerfSample stop();
+
+    /// why `open` failed.
+    const std::string& error() const {
+        return this->reason;
+    }
+private:
+    /// the file descriptor of every counter, -1 if the event couldn't be opened.
+    int fds[PERF_COUNTERS] = { -1, -1, -1, -1, -1 };
+    std::string reason;
+};
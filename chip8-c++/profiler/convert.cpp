@@ -0,0 +1,135 @@
+// gives the io streams, which has the ability to write to the terminal.
+#include<iostream>
+
+// the layout of the profiles being read.
+#include<profiler.hpp>
+
+// gives the filestreams to read the profile and write the trace.
+#include<fstream>
+
+// gives the std::vector and std::string types.
+#include<vector>
+#include<string>
+
+// gives the std::sort and std::max functions.
+#include<algorithm>
+
+/// a profile read back from its file.
+struct Profile {
+    ProfileHeader header;
+    std::vector<ProfileEvent> events;
+    std::vector<std::string> zones;
+    std::vector<std::string> threads;
+};
+
+/// @brief reads a name written as its length and its bytes.
+static bool read_name(std::ifstream& file, std::string& name) {
+    uint16_t length = 0;
+    if (!file.read(reinterpret_cast<char*>(&length), sizeof(length))) return false;
+    name.resize(length);
+    return length == 0 || bool(file.read(&name[0], length));
+}
+
+/// @brief reads a profile written by the profiler.
+/// @return `false` if the file isn't a complete profile of this version
+static bool read_profile(const char* path, Profile& profile) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.read(reinterpret_cast<char*>(&profile.header), sizeof(profile.header))) return false;
+    if (profile.header.magic != PROFILE_MAGIC || profile.header.version != PROFILE_VERSION) return false;
+    profile.events.resize(profile.header.event_count);
+    if (!file.read(reinterpret_cast<char*>(profile.events.data()), profile.events.size() * sizeof(ProfileEvent))) return false;
+    profile.zones.resize(profile.header.zone_count);
+    profile.threads.resize(profile.header.thread_count);
+    for (std::string& zone : profile.zones) {
+        if (!read_name(file, zone)) return false;
+    }
+    for (std::string& thread : profile.threads) {
+        if (!read_name(file, thread)) return false;
+    }
+    for (const ProfileEvent& event : profile.events) {
+        if (event.zone >= profile.zones.size() || event.thread >= profile.threads.size()) return false;
+    }
+    return true;
+}
+
+/// @brief a name as a JSON string.
+static std::string json_string(const std::string& text) {
+    std::string quoted = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') quoted += '\\';
+        if (uint8_t(c) >= 0x20) quoted += c;
+    }
+    return quoted + "\"";
+}
+
+/// @brief writes the profile as a Chrome trace, which chrome://tracing and Perfetto open, with a complete event ("X")
+/// @brief for every zone and a name for every thread.
+static bool write_trace(const Profile& profile, const char* path) {
+    std::ofstream file(path);
+    const double tick = 1 / profile.header.ticks_per_microsecond;
+    file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    for (size_t thread = 0; thread < profile.threads.size(); ++thread) {
+        file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread
+            << ",\"args\":{\"name\":" << json_string(profile.threads[thread]) << "}},\n";
+    }
+    file.precision(3);
+    file << std::fixed;
+    for (size_t index = 0; index < profile.events.size(); ++index) {
+        const ProfileEvent& event = profile.events[index];
+        file << "{\"name\":" << json_string(profile.zones[event.zone]) << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread
+            << ",\"ts\":" << (event.start - profile.header.start) * tick << ",\"dur\":" << event.duration * tick << "}"
+            << (index + 1 == profile.events.size() ? "\n" : ",\n");
+    }
+    file << "]}\n";
+    return bool(file);
+}
+
+/// @brief prints the count, total, average and longest time of every zone, the zones taking the most time first.
+static void print_summary(const Profile& profile) {
+    struct ZoneSummary {
+        size_t zone;
+        uint64_t count = 0, total = 0, longest = 0;
+    };
+    std::vector<ZoneSummary> zones(profile.zones.size());
+    uint64_t first = UINT64_MAX, last = 0;
+    for (size_t zone = 0; zone < zones.size(); ++zone) {
+        zones[zone].zone = zone;
+    }
+    for (const ProfileEvent& event : profile.events) {
+        ZoneSummary& zone = zones[event.zone];
+        zone.count += 1;
+        zone.total += event.duration;
+        zone.longest = std::max<uint64_t>(zone.longest, event.duration);
+        first = std::min(first, event.start);
+        last = std::max(last, event.start + event.duration);
+    }
+    std::sort(zones.begin(), zones.end(), [](const ZoneSummary& a, const ZoneSummary& b) { return a.total > b.total; });
+    const double tick = 1 / profile.header.ticks_per_microsecond;
+    const double span = profile.events.empty() ? 0 : (last - first) * tick;
+    std::cout << profile.events.size() << " zones over " << span / 1000 << " ms on " << profile.threads.size() << " threads" << std::endl;
+    for (const ZoneSummary& zone : zones) {
+        if (zone.count == 0) continue;
+        std::cout << "  " << profile.zones[zone.zone] << ": " << zone.count << " times, "
+            << zone.total * tick / 1000 << " ms (" << (span > 0 ? 100 * zone.total * tick / span : 0) << "%), "
+            << "average " << zone.total * tick / zone.count << " us, longest " << zone.longest * tick << " us" << std::endl;
+    }
+}
+
+/// the entry point of the converter, prints a summary of a profile and optionally converts it to a Chrome trace.
+int main(int argc, char* argv[]) {
+    if (argc != 2 && !(argc == 4 && std::string(argv[2]) == "--trace")) {
+        std::cerr << "usage: chip8-c++-profile <profile> [--trace <trace.json>]" << std::endl;
+        return 2;
+    }
+    Profile profile;
+    if (!read_profile(argv[1], profile)) {
+        std::cerr << "not a complete profile: " << argv[1] << std::endl;
+        return 1;
+    }
+    print_summary(profile);
+    if (argc == 4 && !write_trace(profile, argv[3])) {
+        std::cerr << "could not write trace: " << argv[3] << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,235 @@
+// the profiler declarations implemented in this file.
+#include<profiler.hpp>
+
+// gives the file the profile is written to.
+#include<cstdio>
+
+// gives the background thread writing the chunks, and the mutex guarding the names.
+#include<thread>
+#include<mutex>
+#include<condition_variable>
+
+// gives the clock the timestamps are calibrated against.
+#include<chrono>
+
+// gives the std::vector, std::string and std::unique_ptr types for the names and the threads.
+#include<vector>
+#include<string>
+#include<memory>
+
+// gives the std::min function.
+#include<algorithm>
+
+std::atomic<bool> profiler_recording { false };
+
+/// the events a chunk holds, a chunk is 64KiB.
+static const uint32_t CHUNK_EVENTS = 4096;
+
+/// a run of events of one thread.
+struct ProfileChunk {
+    /// the next full chunk waiting to be written.
+    ProfileChunk* next = nullptr;
+    /// the events recorded so far, only the thread owning the chunk writes them.
+    uint32_t count = 0;
+    ProfileEvent events[CHUNK_EVENTS];
+};
+
+/// a thread that recorded events.
+struct ProfileThread {
+    uint16_t id;
+    std::string name;
+    /// whether the thread was given a name.
+    bool named = false;
+    /// the chunk being filled, it belongs to the thread until it's full.
+    ProfileChunk* chunk = nullptr;
+
+    ~ProfileThread() {
+        delete this->chunk;
+    }
+};
+
+/// everything shared by the threads, only used outside of recording a zone.
+struct Profiler {
+    /// guards the names and the threads, which are only added to.
+    std::mutex mutex;
+    std::vector<std::string> zones;
+    std::vector<std::unique_ptr<ProfileThread>> threads;
+    /// the full chunks waiting to be written, the newest first. Threads push onto it, the writer takes all of it at once.
+    std::atomic<ProfileChunk*> full { nullptr };
+
+    std::FILE* file = nullptr;
+    uint64_t events = 0;
+    std::thread writer;
+    std::mutex writer_mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    /// the timestamp and the time the profile started at, to measure how fast the timestamps tick.
+    uint64_t start_ticks = 0;
+    std::chrono::steady_clock::time_point start_time;
+
+    /// completes a profile that's still recording when the program exits.
+    ~Profiler() {
+        this->stop();
+    }
+
+    /// @brief stops recording and completes the profile, see `profiler_stop`.
+    uint64_t stop();
+};
+
+/// @brief the profiler, created on first use so zones in static initializers find it.
+static Profiler& profiler() {
+    static Profiler instance;
+    return instance;
+}
+
+/// the calling thread, registered on its first event.
+static thread_local ProfileThread* current_thread = nullptr;
+
+/// @brief the calling thread, registering it if it's new.
+static ProfileThread& this_thread() {
+    if (current_thread == nullptr) {
+        Profiler& state = profiler();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.threads.emplace_back(new ProfileThread());
+        current_thread = state.threads.back().get();
+        current_thread->id = uint16_t(state.threads.size() - 1);
+        current_thread->name = "thread " + std::to_string(current_thread->id);
+    }
+    return *current_thread;
+}
+
+/// @brief writes the events of a chunk to the file.
+static void write_chunk(Profiler& state, const ProfileChunk& chunk) {
+    std::fwrite(chunk.events, sizeof(ProfileEvent), chunk.count, state.file);
+    state.events += chunk.count;
+}
+
+/// @brief writes every full chunk waiting, oldest first, and frees them.
+static void write_full_chunks(Profiler& state) {
+    ProfileChunk* chunk = state.full.exchange(nullptr, std::memory_order_acquire);
+    // the list is newest first, reversed so the file stays in order.
+    ProfileChunk* oldest = nullptr;
+    while (chunk != nullptr) {
+        ProfileChunk* next = chunk->next;
+        chunk->next = oldest;
+        oldest = chunk;
+        chunk = next;
+    }
+    while (oldest != nullptr) {
+        ProfileChunk* next = oldest->next;
+        write_chunk(state, *oldest);
+        delete oldest;
+        oldest = next;
+    }
+}
+
+/// @brief writes a name as its length and its bytes.
+static void write_name(std::FILE* file, const std::string& name) {
+    const uint16_t length = uint16_t(std::min<size_t>(name.size(), UINT16_MAX));
+    std::fwrite(&length, sizeof(length), 1, file);
+    std::fwrite(name.data(), 1, length, file);
+}
+
+uint64_t Profiler::stop() {
+    if (this->file == nullptr) return 0;
+    profiler_recording.store(false, std::memory_order_relaxed);
+    const uint64_t end_ticks = profiler_ticks();
+    const auto end_time = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(this->writer_mutex);
+        this->stopping = true;
+    }
+    this->wake.notify_one();
+    this->writer.join();
+    write_full_chunks(*this);
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    // the chunks the threads are still filling.
+    for (const std::unique_ptr<ProfileThread>& thread : this->threads) {
+        if (thread->chunk == nullptr) continue;
+        write_chunk(*this, *thread->chunk);
+        thread->chunk->count = 0;
+    }
+    for (const std::string& zone : this->zones) {
+        write_name(this->file, zone);
+    }
+    for (const std::unique_ptr<ProfileThread>& thread : this->threads) {
+        write_name(this->file, thread->name);
+    }
+    const double micros = std::chrono::duration<double, std::micro>(end_time - this->start_time).count();
+    ProfileHeader header;
+    header.magic = PROFILE_MAGIC;
+    header.version = PROFILE_VERSION;
+    header.event_count = this->events;
+    header.zone_count = uint32_t(this->zones.size());
+    header.thread_count = uint32_t(this->threads.size());
+    header.ticks_per_microsecond = micros > 0 ? (end_ticks - this->start_ticks) / micros : 1;
+    header.start = this->start_ticks;
+    std::fseek(this->file, 0, SEEK_SET);
+    std::fwrite(&header, sizeof(header), 1, this->file);
+    std::fclose(this->file);
+    this->file = nullptr;
+    return this->events;
+}
+
+void profiler_record(uint16_t zone, uint64_t start, uint64_t end) {
+    ProfileThread& thread = this_thread();
+    if (thread.chunk == nullptr) thread.chunk = new ProfileChunk();
+    ProfileChunk& chunk = *thread.chunk;
+    const uint64_t duration = end - start;
+    chunk.events[chunk.count++] = { start, uint32_t(std::min<uint64_t>(duration, UINT32_MAX)), zone, thread.id };
+    if (chunk.count == CHUNK_EVENTS) {
+        // hands the chunk to the writer, the only point where threads touch shared state.
+        Profiler& state = profiler();
+        chunk.next = state.full.load(std::memory_order_relaxed);
+        while (!state.full.compare_exchange_weak(chunk.next, &chunk, std::memory_order_release, std::memory_order_relaxed)) {}
+        thread.chunk = nullptr;
+    }
+}
+
+uint16_t profiler_zone(const char* name) {
+    Profiler& state = profiler();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    // zones with the same name in several places are the same zone.
+    for (size_t zone = 0; zone < state.zones.size(); ++zone) {
+        if (state.zones[zone] == name) return uint16_t(zone);
+    }
+    state.zones.push_back(name);
+    return uint16_t(state.zones.size() - 1);
+}
+
+void profiler_name_thread(const char* name) {
+    ProfileThread& thread = this_thread();
+    if (thread.named) return;
+    std::lock_guard<std::mutex> lock(profiler().mutex);
+    thread.name = name;
+    thread.named = true;
+}
+
+bool profiler_start(const char* path) {
+    Profiler& state = profiler();
+    if (state.file != nullptr) return false;
+    state.file = std::fopen(path, "wb");
+    if (state.file == nullptr) return false;
+    // the header is written again once the counts are known.
+    const ProfileHeader header = {};
+    std::fwrite(&header, sizeof(header), 1, state.file);
+    state.events = 0;
+    state.stopping = false;
+    state.start_time = std::chrono::steady_clock::now();
+    state.start_ticks = profiler_ticks();
+    // writes the full chunks a few times a second, so only a few of them are ever waiting.
+    state.writer = std::thread([&state]() {
+        std::unique_lock<std::mutex> lock(state.writer_mutex);
+        while (!state.stopping) {
+            state.wake.wait_for(lock, std::chrono::milliseconds(100));
+            write_full_chunks(state);
+        }
+    });
+    profiler_recording.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+uint64_t profiler_stop() {
+    return profiler().stop();
+}
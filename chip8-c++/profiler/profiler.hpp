@@ -0,0 +1,128 @@
+// no duplicate includes.
+#pragma once
+
+/// @brief a profiler of scoped zones, for seeing where the time of every host frame goes while the frontend runs
+/// @brief normally. `CHIP8_ZONE("name")` records the time from where it's written to the end of its scope, and
+/// @brief `CHIP8_PROFILE_THREAD("name")` names the calling thread in the trace.
+/// @brief
+/// @brief both macros are empty unless `CHIP8_PROFILE` is defined (see the `CHIP8_PROFILE` option in CMakeLists.txt),
+/// @brief so without it the zones and the profiler don't exist in the program at all. With it, a zone costs two
+/// @brief reads of the CPU's time stamp counter and a store into a buffer of the calling thread, and a check of a
+/// @brief flag while the profiler isn't started. Threads never share or lock anything while recording: every thread
+/// @brief fills chunks of its own and hands full ones to a background thread, which writes them to the file.
+
+#ifdef CHIP8_PROFILE
+
+// gives the fixed width integer types.
+#include<cstdint>
+
+// gives the std::atomic flag checked by every zone.
+#include<atomic>
+
+// gives the time stamp counter on x86, other CPUs use the steady clock.
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include<intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include<x86intrin.h>
+#else
+#include<chrono>
+#endif
+
+/// the bytes a profile starts with, "C8PF".
+static const uint32_t PROFILE_MAGIC = 0x46503843;
+/// the version of the layout.
+static const uint32_t PROFILE_VERSION = 1;
+
+/// @brief the start of a profile, followed by `event_count` `ProfileEvent`s, then the names of the zones and then the
+/// @brief names of the threads, every name being a `uint16_t` length followed by its bytes.
+struct ProfileHeader {
+    /// `PROFILE_MAGIC`.
+    uint32_t magic;
+    /// `PROFILE_VERSION`.
+    uint32_t version;
+    /// the amount of events.
+    uint64_t event_count;
+    /// the amount of zone names.
+    uint32_t zone_count;
+    /// the amount of thread names.
+    uint32_t thread_count;
+    /// the ticks of the timestamps in a microsecond, measured over the whole profile.
+    double ticks_per_microsecond;
+    /// the timestamp the profile started at.
+    uint64_t start;
+};
+
+/// a zone that ran, 16 bytes.
+struct ProfileEvent {
+    /// the timestamp the zone started at.
+    uint64_t start;
+    /// the ticks the zone took, longer zones are cut off at the most this can hold.
+    uint32_t duration;
+    /// the zone, an index into the zone names.
+    uint16_t zone;
+    /// the thread the zone ran on, an index into the thread names.
+    uint16_t thread;
+};
+
+/// @brief the timestamp of now, in ticks of the time stamp counter.
+inline uint64_t profiler_ticks() {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86)) || defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+/// whether the profiler is recording, zones started while it isn't are left out.
+extern std::atomic<bool> profiler_recording;
+
+/// @brief starts recording into a new profile at `path`.
+/// @return `false` if the file couldn't be created or the profiler is already recording
+bool profiler_start(const char* path);
+
+/// @brief stops recording and completes the profile. Other threads should be done with their zones by then, a zone
+/// @brief ending while this runs can be left out.
+/// @return the amount of events written
+uint64_t profiler_stop();
+
+/// @brief adds a zone name, called once for every `CHIP8_ZONE`.
+/// @return the id of the zone, the same for every `CHIP8_ZONE` with this name
+uint16_t profiler_zone(const char* name);
+
+/// @brief names the calling thread in the profile, only the first name given counts.
+void profiler_name_thread(const char* name);
+
+/// @brief records a finished zone into the calling thread's buffer.
+void profiler_record(uint16_t zone, uint64_t start, uint64_t end);
+
+/// records the time from its creation to the end of its scope.
+struct ProfileZone {
+    ProfileZone(uint16_t zone) : zone(zone), active(profiler_recording.load(std::memory_order_relaxed)) {
+        if (this->active) this->start = profiler_ticks();
+    }
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+    ~ProfileZone() {
+        if (this->active) profiler_record(this->zone, this->start, profiler_ticks());
+    }
+
+    uint16_t zone;
+    bool active;
+    uint64_t start = 0;
+};
+
+#define CHIP8_ZONE_JOIN_(a, b) a##b
+#define CHIP8_ZONE_JOIN(a, b) CHIP8_ZONE_JOIN_(a, b)
+/// records the rest of the enclosing scope as the zone `name`, a string literal.
+#define CHIP8_ZONE(name) \
+    static const uint16_t CHIP8_ZONE_JOIN(chip8_zone_id_, __LINE__) = profiler_zone(name); \
+    ProfileZone CHIP8_ZONE_JOIN(chip8_zone_, __LINE__)(CHIP8_ZONE_JOIN(chip8_zone_id_, __LINE__))
+/// names the calling thread in the profile.
+#define CHIP8_PROFILE_THREAD(name) profiler_name_thread(name)
+
+#else
+
+#define CHIP8_ZONE(name)
+#define CHIP8_PROFILE_THREAD(name)
+
+#endif
@@ -0,0 +1,230 @@
+// the generator declarations implemented in this file.
+#include<proggen.hpp>
+
+// gives the string streams used to parse mixes.
+#include<sstream>
+
+// gives the std::max function.
+#include<algorithm>
+
+/// the amount of data bytes after the program, for sprites and memory accesses.
+static const size_t DATA_BYTES = 64;
+
+/// the names of the opcode classes, indexed by `OpcodeClass`.
+static const char* OPCODE_CLASS_NAMES[OPCODE_CLASSES] = {
+    "alu", "random", "draw", "memory", "control", "timer", "input", "self-modifying",
+};
+
+const char* opcode_class_name(OpcodeClass opcode_class) {
+    return OPCODE_CLASS_NAMES[static_cast<size_t>(opcode_class)];
+}
+
+bool OpcodeMix::parse(const std::string& list) {
+    std::array<uint32_t, OPCODE_CLASSES> parsed = this->weights;
+    std::istringstream entries(list);
+    std::string entry;
+    while (std::getline(entries, entry, ',')) {
+        const size_t equals = entry.find('=');
+        if (equals == std::string::npos) return false;
+        const std::string name = entry.substr(0, equals);
+        size_t index = 0;
+        while (index < OPCODE_CLASSES && name != OPCODE_CLASS_NAMES[index]) ++index;
+        if (index == OPCODE_CLASSES) return false;
+        try {
+            parsed[index] = std::stoul(entry.substr(equals + 1));
+        } catch (...) {
+            return false;
+        }
+    }
+    uint32_t total = 0;
+    for (uint32_t weight : parsed) total += weight;
+    if (total == 0) return false;
+    this->weights = parsed;
+    return true;
+}
+
+/// the random numbers of the generator, splitmix64, which is fast and good enough for picking instructions.
+struct GeneratorRandom {
+    uint64_t state;
+
+    /// @brief the next random number.
+    uint32_t next() {
+        uint64_t z = (this->state += 0x9e3779b97f4a7c15);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+        return (z ^ (z >> 31)) >> 32;
+    }
+
+    /// @brief a random number in `[0, bound)`.
+    uint32_t below(uint32_t bound) {
+        return this->next() % bound;
+    }
+};
+
+/// @brief picks an opcode class by its weight in the mix.
+static OpcodeClass pick_class(GeneratorRandom& random, const OpcodeMix& mix) {
+    uint32_t total = 0;
+    for (uint32_t weight : mix.weights) total += weight;
+    uint32_t pick = random.below(total);
+    for (size_t index = 0; index < OPCODE_CLASSES; ++index) {
+        if (pick < mix.weights[index]) return static_cast<OpcodeClass>(index);
+        pick -= mix.weights[index];
+    }
+    return OpcodeClass::Alu;
+}
+
+BatchJob generate_job(uint64_t seed, const ProgramSettings& settings) {
+    GeneratorRandom random = { seed };
+    // at least a few instructions, so every group of instructions below fits.
+    const size_t instructions = std::max<size_t>(settings.instructions, 8);
+    const uint16_t data_start = 0x200 + instructions * 2;
+    assert(data_start + DATA_BYTES <= 0x1000);
+
+    auto slot_address = [&](size_t slot) { return uint16_t(0x200 + slot * 2); };
+    auto any_slot = [&]() { return slot_address(random.below(instructions)); };
+    auto reg = [&]() { return uint16_t(random.below(16)); };
+    auto byte = [&]() { return uint16_t(random.below(256)); };
+    // leaves room for the longest sprite, so sprites never read past the data.
+    auto data_address = [&]() { return uint16_t(data_start + random.below(DATA_BYTES - 15)); };
+
+    std::vector<uint16_t> code;
+    // the last instruction jumps back to the start, so the program never runs into its data.
+    while (code.size() < instructions - 1) {
+        std::vector<uint16_t> group;
+        const uint16_t x = reg(), y = reg();
+        switch (pick_class(random, settings.mix)) {
+        case OpcodeClass::Alu: {
+            const uint16_t op = random.below(11);
+            if (op == 0) group = { uint16_t(0x6000 | x << 8 | byte()) };
+            else if (op == 1) group = { uint16_t(0x7000 | x << 8 | byte()) };
+            else group = { uint16_t(0x8000 | x << 8 | y << 4 | (op == 10 ? 0xe : op - 2)) };
+            break;
+        }
+        case OpcodeClass::Random:
+            group = { uint16_t(0xc000 | x << 8 | byte()) };
+            break;
+        case OpcodeClass::Draw: {
+            const uint32_t op = random.below(8);
+            if (op == 0) group = { 0x00e0 };
+            else if (op <= 2) group = { uint16_t(0xa000 | data_address()) };
+            else if (op == 3) group = { uint16_t(0xf029 | x << 8) };
+            else group = { uint16_t(0xd000 | x << 8 | y << 4 | (1 + random.below(15))) };
+            break;
+        }
+        case OpcodeClass::Memory: {
+            const uint32_t op = random.below(6);
+            if (op <= 1) group = { uint16_t(0xa000 | data_address()) };
+            else if (op == 2) group = { uint16_t(0xf01e | x << 8) };
+            else if (op == 3) group = { uint16_t(0xf033 | x << 8) };
+            else if (op == 4) group = { uint16_t(0xf055 | random.below(8) << 8) };
+            else group = { uint16_t(0xf065 | random.below(8) << 8) };
+            break;
+        }
+        case OpcodeClass::Control: {
+            // calls and returns are rare, as a call without a return soon overflows the stack and the other way around.
+            const uint32_t op = random.below(16);
+            if (op <= 2) group = { uint16_t(0x3000 | x << 8 | byte()) };
+            else if (op <= 5) group = { uint16_t(0x4000 | x << 8 | byte()) };
+            else if (op == 6) group = { uint16_t(0x5000 | x << 8 | y << 4) };
+            else if (op == 7) group = { uint16_t(0x9000 | x << 8 | y << 4) };
+            else if (op <= 11) group = { uint16_t(0x1000 | any_slot()) };
+            else if (op == 12) group = { uint16_t(0x2000 | any_slot()) };
+            else if (op == 13) group = { 0x00ee };
+            else {
+                // BNNN jumps to NNN + v0, so v0 is set first to keep the target inside the program. 6XNN only holds a
+                // byte, which caps the offset at 127 instructions in long programs.
+                const uint32_t offset = random.below(std::min<size_t>(instructions / 2, 128));
+                const uint32_t target = random.below(instructions - offset);
+                group = { uint16_t(0x6000 | offset * 2), uint16_t(0xb000 | slot_address(target)) };
+            }
+            break;
+        }
+        case OpcodeClass::Timer: {
+            const uint32_t op = random.below(5);
+            if (op == 0) group = { uint16_t(0xf015 | x << 8) };
+            else if (op == 1) group = { uint16_t(0xf018 | x << 8) };
+            else if (op == 2) group = { uint16_t(0xf007 | x << 8) };
+            else {
+                // a loop waiting for the delay timer, which cores sleep through, see `Core::sleeping`.
+                const uint16_t loop = slot_address(code.size() + 2);
+                group = { uint16_t(0x6000 | x << 8 | random.below(16)), uint16_t(0xf015 | x << 8),
+                    uint16_t(0xf007 | x << 8), uint16_t(0x3000 | x << 8), uint16_t(0x1000 | loop) };
+            }
+            break;
+        }
+        case OpcodeClass::Input: {
+            const uint32_t op = random.below(3);
+            if (op == 0) group = { uint16_t(0xe09e | x << 8) };
+            else if (op == 1) group = { uint16_t(0xe0a1 | x << 8) };
+            else group = { uint16_t(0xf00a | x << 8) };
+            break;
+        }
+        case OpcodeClass::SelfModifying:
+            group = { uint16_t(0xa000 | any_slot()), uint16_t(random.below(2) == 0 ? 0xf033 | x << 8 : 0xf055 | random.below(3) << 8) };
+            break;
+        }
+        if (code.size() + group.size() > instructions - 1) continue;
+        code.insert(code.end(), group.begin(), group.end());
+    }
+    code.push_back(0x1200);
+
+    BatchJob job;
+    job.name = "generated-" + std::to_string(seed);
+    for (uint16_t instruction : code) {
+        job.rom.push_back(instruction >> 8);
+        job.rom.push_back(instruction & 0xff);
+    }
+    for (size_t index = 0; index < DATA_BYTES; ++index) {
+        job.rom.push_back(random.below(256));
+    }
+    job.frames = settings.frames;
+    job.checkpoint_interval = settings.frames;
+    job.seed = random.next() | 1;
+    job.instructions_per_frame = 1 + random.below(30);
+    // presses and lets go of keys every few frames, so programs waiting for keys get them.
+    for (uint32_t frame = random.below(8); frame < job.frames; frame += 1 + random.below(20)) {
+        const uint16_t bitmap = random.below(3) == 0 ? 0 : uint16_t(1 << random.below(16) | 1 << random.below(16));
+        job.inputs.push_back({ frame, bitmap });
+    }
+    return job;
+}
+
+BatchJob minimize_job(const BatchJob& job, const std::function<bool(const BatchJob&)>& fails) {
+    BatchJob best = job;
+    bool shrunk = true;
+    while (shrunk) {
+        shrunk = false;
+        // fewer frames first, every check after that gets faster.
+        for (uint32_t step = best.frames / 2; step > 0; step /= 2) {
+            while (best.frames > step) {
+                BatchJob candidate = best;
+                candidate.frames -= step;
+                candidate.checkpoint_interval = candidate.frames;
+                if (!fails(candidate)) break;
+                best = std::move(candidate);
+                shrunk = true;
+            }
+        }
+        for (size_t event = best.inputs.size(); event-- > 0;) {
+            BatchJob candidate = best;
+            candidate.inputs.erase(candidate.inputs.begin() + event);
+            if (fails(candidate)) {
+                best = std::move(candidate);
+                shrunk = true;
+            }
+        }
+        for (size_t word = best.rom.size() / 2; word-- > 0;) {
+            if (uint8_t(best.rom[word * 2]) == NOP_INSTRUCTION >> 8 && uint8_t(best.rom[word * 2 + 1]) == (NOP_INSTRUCTION & 0xff)) {
+                continue;
+            }
+            BatchJob candidate = best;
+            candidate.rom[word * 2] = char(NOP_INSTRUCTION >> 8);
+            candidate.rom[word * 2 + 1] = char(NOP_INSTRUCTION & 0xff);
+            if (fails(candidate)) {
+                best = std::move(candidate);
+                shrunk = true;
+            }
+        }
+    }
+    return best;
+}
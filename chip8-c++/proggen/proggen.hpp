@@ -0,0 +1,80 @@
+// no duplicate includes.
+#pragma once
+
+// the jobs the generated programs are run as.
+#include<batch.hpp>
+
+// gives the std::array type of the mix.
+#include<array>
+
+// gives the std::function type of the minimizer's check.
+#include<functional>
+
+// gives the std::string type.
+#include<string>
+
+/// the kinds of instructions the generator picks from.
+enum class OpcodeClass : uint8_t {
+    /// arithmetic and logic on the registers, 6XNN, 7XNN and 8XYN.
+    Alu,
+    /// random numbers, CXNN.
+    Random,
+    /// clearing the screen and drawing sprites, 00E0, ANNN and FX29 pointing at sprites, and DXYN.
+    Draw,
+    /// memory through the i register, ANNN, FX1E, FX33, FX55 and FX65.
+    Memory,
+    /// skips, jumps, calls and returns.
+    Control,
+    /// the timers, FX15, FX18, FX07 and loops waiting for the delay timer.
+    Timer,
+    /// the hexpad, EX9E, EXA1 and FX0A.
+    Input,
+    /// writes into the program itself, ANNN pointing at code followed by FX33 or FX55.
+    SelfModifying,
+};
+
+/// the amount of opcode classes.
+static const size_t OPCODE_CLASSES = 8;
+
+/// @brief the name of an opcode class, as used by `OpcodeMix::parse`.
+const char* opcode_class_name(OpcodeClass opcode_class);
+
+/// how often the generator picks every class of instruction, relative to the others.
+struct OpcodeMix {
+    /// the weight of every class, indexed by `OpcodeClass`. A class with weight 0 is never picked.
+    std::array<uint32_t, OPCODE_CLASSES> weights = { 8, 1, 2, 2, 3, 1, 1, 1 };
+
+    /// @brief changes weights from a list like `alu=4,draw=0`, leaving the classes that aren't listed as they are.
+    /// @return `false` if the list couldn't be parsed or every weight ended up 0
+    bool parse(const std::string& list);
+};
+
+/// what the generated programs look like.
+struct ProgramSettings {
+    /// the amount of instructions in the program, not counting its data.
+    size_t instructions = 128;
+    /// how often every class of instruction is picked.
+    OpcodeMix mix;
+    /// the amount of frames the generated job runs.
+    uint32_t frames = 120;
+};
+
+/// the instruction the minimizer replaces instructions with, 8000 (v0 = v0) doesn't do anything.
+static const uint16_t NOP_INSTRUCTION = 0x8000;
+
+/// @brief generates a random program and the job running it, with random input and instructions per frame.
+///
+/// The programs are valid in the sense that every jump and call goes to an instruction of the program and every sprite
+/// and memory access goes to the font, the program's data or the program itself. They can still trap, a call can
+/// overflow the stack and a self modifying write can turn an instruction into an invalid one, and some of them do
+/// as traps have to behave the same everywhere as well. The same seed and settings always give the same job.
+/// @param seed picks the program
+/// @param settings what the program looks like
+BatchJob generate_job(uint64_t seed, const ProgramSettings& settings);
+
+/// @brief shrinks a failing job while it keeps failing: replaces instructions with `NOP_INSTRUCTION`, drops input
+/// events and runs fewer frames, as long as `fails` still returns `true` for the smaller job.
+/// @param job the failing job, `fails(job)` must be `true`
+/// @param fails checks whether a job still fails
+/// @return the smallest failing job found
+BatchJob minimize_job(const BatchJob& job, const std::function<bool(const BatchJob&)>& fails);
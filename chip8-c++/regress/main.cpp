@@ -0,0 +1,330 @@
+// gives the io streams, which has the ability to write to the terminal.
+#include<iostream>
+
+// the batch runner which runs the corpus.
+#include<batch.hpp>
+
+// writes the framebuffers of mismatching checkpoints.
+#include<png.hpp>
+
+// gives the functions to walk the corpus directory.
+#include<filesystem>
+
+// gives the filestreams to read ROMs, scripts and golden files.
+#include<fstream>
+#include<sstream>
+
+// gives the std::map type used to look up golden hashes by ROM.
+#include<map>
+
+// gives the clocks used to time the run.
+#include<chrono>
+
+// gives the std::sort function.
+#include<algorithm>
+
+#ifdef CHIP8_BATCH_CHECKPOINT
+// saves the progress of the run, to continue it if the runner dies.
+#include<batch_checkpoint.hpp>
+#endif
+
+#ifdef CHIP8_FARM
+// runs the corpus on the workers of a batch farm instead of on this machine.
+#include<farm.hpp>
+#endif
+
+/// the extensions of the files in the corpus that are treated as ROMs.
+static const char* ROM_EXTENSIONS[] = { ".ch8", ".c8", ".rom" };
+
+/// @brief reads a whole file into a container of chars.
+/// @return `false` if the file couldn't be opened
+template<typename T>
+static bool read_file(const std::filesystem::path& path, T& out) {
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream) return false;
+    out.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+    return true;
+}
+
+/// @brief escapes a string for use inside a JSON string literal.
+static std::string json_escape(const std::string& text) {
+    std::string out;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+/// @brief formats a hash as 16 hexadecimal digits.
+static std::string hash_hex(uint64_t hash) {
+    char text[17];
+    std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(hash));
+    return text;
+}
+
+/// @brief reads a golden file. Every line is a ROM path relative to the corpus, a tab, then its checkpoints as
+/// @brief `<frame>:<hash>` separated by commas. A missing file reads as no checkpoints at all.
+/// @param line_number the line that couldn't be read, when reading fails
+/// @return `false` if a checkpoint isn't made of two numbers
+static bool read_golden(const std::filesystem::path& path, std::map<std::string, std::vector<BatchCheckpoint>>& golden, size_t& line_number) {
+    std::ifstream stream(path);
+    std::string line;
+    line_number = 0;
+    while (std::getline(stream, line)) {
+        ++line_number;
+        const size_t tab = line.find('\t');
+        if (tab == std::string::npos) continue;
+        std::vector<BatchCheckpoint>& checkpoints = golden[line.substr(0, tab)];
+        std::istringstream entries(line.substr(tab + 1));
+        std::string entry;
+        while (std::getline(entries, entry, ',')) {
+            const size_t colon = entry.find(':');
+            if (colon == std::string::npos) continue;
+            try {
+                checkpoints.push_back({ uint32_t(std::stoul(entry.substr(0, colon))), std::stoull(entry.substr(colon + 1), nullptr, 16) });
+            } catch (...) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/// the outcome of comparing a job against its golden checkpoints.
+enum class Status { Pass, Fail, New, Error };
+
+/// @brief the name of a status in the report.
+static const char* status_name(Status status) {
+    switch (status) {
+    case Status::Pass: return "pass";
+    case Status::Fail: return "fail";
+    case Status::New: return "new";
+    case Status::Error: return "error";
+    }
+    return "unknown";
+}
+
+/// the entry point of the regression runner.
+int main(int argc, char* argv[]) {
+    std::filesystem::path corpus, golden_path, report_path, png_dir, script_path;
+    bool update = false;
+    size_t threads = 0;
+    BatchJob defaults;
+#ifdef CHIP8_BATCH_CHECKPOINT
+    std::string resume_path;
+    uint32_t save_interval_ms = 1000;
+#endif
+#ifdef CHIP8_FARM
+    // the port to coordinate a farm on, -1 runs the corpus on this machine.
+    int32_t coordinator_port = -1;
+    FarmSettings farm_settings;
+    // a worker only needs the coordinator's address, the jobs come from the coordinator.
+    if (argc > 2 && std::string(argv[1]) == "--worker") {
+        const std::string address = argv[2];
+        const size_t colon = address.rfind(':');
+        if (argc > 4 && std::string(argv[3]) == "--jobs") threads = std::stoul(argv[4]);
+        if (colon == std::string::npos) {
+            std::cerr << "the coordinator's address is <host>:<port>" << std::endl;
+            return 2;
+        }
+        if (!run_farm_worker(address.substr(0, colon), std::stoul(address.substr(colon + 1)), threads)) {
+            std::cerr << "could not reach the coordinator: " << address << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+#endif
+    for (int arg = 1; arg < argc; ++arg) {
+        std::string flag = argv[arg];
+        const bool has_value = arg + 1 < argc;
+        if (flag == "--golden" && has_value) golden_path = argv[++arg];
+        else if (flag == "--report" && has_value) report_path = argv[++arg];
+        else if (flag == "--png-dir" && has_value) png_dir = argv[++arg];
+        else if (flag == "--script" && has_value) script_path = argv[++arg];
+        else if (flag == "--frames" && has_value) defaults.frames = std::stoul(argv[++arg]);
+        else if (flag == "--checkpoint" && has_value) defaults.checkpoint_interval = std::stoul(argv[++arg]);
+        else if (flag == "--jobs" && has_value) threads = std::stoul(argv[++arg]);
+        else if (flag == "--update") update = true;
+#ifdef CHIP8_BATCH_CHECKPOINT
+        else if (flag == "--resume-file" && has_value) resume_path = argv[++arg];
+        else if (flag == "--save-interval" && has_value) save_interval_ms = std::max(1ul, std::stoul(argv[++arg]));
+#endif
+#ifdef CHIP8_FARM
+        else if (flag == "--coordinator" && has_value) coordinator_port = std::stoul(argv[++arg]);
+        else if (flag == "--unit" && has_value) farm_settings.unit_size = std::max(1ul, std::stoul(argv[++arg]));
+        else if (flag == "--lease" && has_value) farm_settings.lease_seconds = std::stoul(argv[++arg]);
+#endif
+        else if (corpus.empty()) corpus = flag;
+        else {
+            std::cerr << "unexpected argument: " << flag << std::endl;
+            return 2;
+        }
+    }
+    if (corpus.empty() || defaults.checkpoint_interval == 0) {
+        std::cerr << "usage: chip8-c++-regress <corpus dir> [--golden <file>] [--update] [--report <file.json>] [--png-dir <dir>]\n"
+                     "                         [--script <inputs>] [--frames <n>] [--checkpoint <n>] [--jobs <n>]\n"
+#ifdef CHIP8_BATCH_CHECKPOINT
+                     "                         [--resume-file <file>] [--save-interval <ms>]\n"
+#endif
+#ifdef CHIP8_FARM
+                     "                         [--coordinator <port>] [--unit <jobs>] [--lease <seconds>]\n"
+                     "       chip8-c++-regress --worker <host>:<port> [--jobs <n>]\n"
+#endif
+                     "a ROM's input script is <rom>.inputs next to it, falling back to --script." << std::endl;
+        return 2;
+    }
+    if (!script_path.empty()) {
+        std::string script;
+        if (!read_file(script_path, script) || !parse_input_script(script, defaults)) {
+            std::cerr << "could not read input script: " << script_path << std::endl;
+            return 2;
+        }
+    }
+
+    // the golden file is read before running anything, so a broken one doesn't waste a whole run.
+    std::map<std::string, std::vector<BatchCheckpoint>> golden;
+    size_t golden_line = 0;
+    if (!read_golden(golden_path, golden, golden_line)) {
+        std::cerr << "could not parse golden file " << golden_path.string() << " at line " << golden_line << std::endl;
+        return 2;
+    }
+
+    // collects every ROM in the corpus, sorted so reports are stable.
+    std::vector<std::filesystem::path> rom_paths;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(corpus)) {
+        const std::string extension = entry.path().extension().string();
+        for (const char* rom_extension : ROM_EXTENSIONS) {
+            if (entry.is_regular_file() && extension == rom_extension) rom_paths.push_back(entry.path());
+        }
+    }
+    std::sort(rom_paths.begin(), rom_paths.end());
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<BatchJob> jobs;
+    std::vector<std::string> load_errors;
+    for (const auto& path : rom_paths) {
+        BatchJob job = defaults;
+        job.name = path.lexically_relative(corpus).generic_string();
+        std::string error;
+        std::string script;
+        if (!read_file(path, job.rom)) {
+            error = "could not read ROM";
+        } else if (read_file(path.string() + ".inputs", script) && !parse_input_script(script, job)) {
+            error = "could not parse input script";
+        }
+        jobs.push_back(std::move(job));
+        load_errors.push_back(error);
+    }
+    std::vector<BatchResult> results;
+#ifdef CHIP8_FARM
+    if (coordinator_port >= 0) {
+        FarmStats stats;
+        if (!run_coordinator(jobs, coordinator_port, farm_settings, results, stats)) {
+            std::cerr << "could not listen on port " << coordinator_port << std::endl;
+            return 1;
+        }
+        std::cout << "farm: " << stats.workers << " workers, " << stats.leases << " units handed out, " << stats.retries
+            << " handed out again, " << stats.duplicates << " duplicate results" << std::endl;
+    } else
+#endif
+#ifdef CHIP8_BATCH_CHECKPOINT
+    if (!resume_path.empty()) {
+        BatchCheckpointStats stats;
+        if (!run_batch_checkpointed(jobs, threads, resume_path, save_interval_ms, results, stats)) {
+            std::cerr << "could not use the resume file, it may belong to another corpus or settings: " << resume_path << std::endl;
+            return 1;
+        }
+        std::cout << "resume file: " << stats.finished << " jobs already finished, " << stats.resumed << " continued, "
+            << stats.saves << " saves" << std::endl;
+    } else
+#endif
+    results = run_batch(jobs, threads);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (!png_dir.empty()) {
+        std::filesystem::create_directories(png_dir);
+    }
+    size_t counts[4] = { 0, 0, 0, 0 };
+    std::ostringstream report;
+    report << "{\n  \"corpus\": \"" << json_escape(corpus.generic_string()) << "\",\n  \"seconds\": " << seconds << ",\n  \"results\": [";
+    for (size_t index = 0; index < jobs.size(); ++index) {
+        const BatchJob& job = jobs[index];
+        BatchResult& result = results[index];
+        if (!load_errors[index].empty()) result.error = load_errors[index];
+
+        // compares against the golden checkpoints, the first mismatch is written out as a PNG.
+        Status status = Status::Error;
+        const BatchCheckpoint* mismatch = nullptr;
+        auto expected = golden.find(job.name);
+        if (result.error.empty()) {
+            status = expected == golden.end() ? Status::New : Status::Pass;
+            if (expected != golden.end()) {
+                const auto& checkpoints = expected->second;
+                for (size_t c = 0; c < std::max(checkpoints.size(), result.checkpoints.size()); ++c) {
+                    const bool same = c < checkpoints.size() && c < result.checkpoints.size()
+                        && checkpoints[c].frame == result.checkpoints[c].frame && checkpoints[c].hash == result.checkpoints[c].hash;
+                    if (!same) {
+                        status = Status::Fail;
+                        if (c < result.checkpoints.size()) mismatch = &result.checkpoints[c];
+                        break;
+                    }
+                }
+            }
+        }
+        counts[static_cast<size_t>(status)] += 1;
+
+        std::string png_path;
+        if (mismatch != nullptr && !png_dir.empty()) {
+            std::string flat = job.name;
+            std::replace(flat.begin(), flat.end(), '/', '_');
+            png_path = (png_dir / (flat + "@" + std::to_string(mismatch->frame) + ".png")).string();
+            write_png(png_path.c_str(), replay_job(job, mismatch->frame).framebuffer(), 4);
+        }
+
+        report << (index == 0 ? "\n" : ",\n") << "    { \"rom\": \"" << json_escape(job.name) << "\", \"status\": \"" << status_name(status) << "\"";
+        if (!result.error.empty()) report << ", \"error\": \"" << json_escape(result.error) << "\"";
+        if (result.trap != CoreTrap::None) report << ", \"trap\": \"" << trap_name(result.trap) << "\", \"trap_pc\": " << result.trap_pc;
+        if (result.halted) report << ", \"halted_frame\": " << result.halted_frame;
+        if (mismatch != nullptr) report << ", \"first_mismatch_frame\": " << mismatch->frame;
+        if (!png_path.empty()) report << ", \"png\": \"" << json_escape(png_path) << "\"";
+        report << ", \"checkpoints\": [";
+        for (size_t c = 0; c < result.checkpoints.size(); ++c) {
+            report << (c == 0 ? "" : ", ") << "[" << result.checkpoints[c].frame << ", \"" << hash_hex(result.checkpoints[c].hash) << "\"]";
+        }
+        report << "] }";
+    }
+    report << "\n  ],\n  \"summary\": { \"roms\": " << jobs.size() << ", \"pass\": " << counts[0] << ", \"fail\": " << counts[1]
+        << ", \"new\": " << counts[2] << ", \"error\": " << counts[3] << " }\n}\n";
+
+    if (report_path.empty()) {
+        std::cout << report.str();
+    } else {
+        std::ofstream(report_path) << report.str();
+    }
+
+    // rewrites the golden file from this run.
+    if (update && !golden_path.empty()) {
+        std::ofstream out(golden_path, std::ios::trunc);
+        for (size_t index = 0; index < jobs.size(); ++index) {
+            if (!results[index].error.empty()) continue;
+            out << jobs[index].name << '\t';
+            for (size_t c = 0; c < results[index].checkpoints.size(); ++c) {
+                out << (c == 0 ? "" : ",") << results[index].checkpoints[c].frame << ':' << hash_hex(results[index].checkpoints[c].hash);
+            }
+            out << '\n';
+        }
+    }
+
+    std::cerr << jobs.size() << " ROMs in " << seconds << "s: " << counts[0] << " passed, " << counts[1] << " failed, "
+        << counts[2] << " new, " << counts[3] << " errors" << std::endl;
+    return (counts[1] > 0 || counts[3] > 0) && !update ? 1 : 0;
+}
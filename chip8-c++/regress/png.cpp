@@ -0,0 +1,89 @@
+// the png declarations implemented in this file.
+#include<png.hpp>
+
+// gives the filestreams to write the PNG file.
+#include<fstream>
+
+// gives access to the std::vector type.
+#include<vector>
+
+// gives the std::min function.
+#include<algorithm>
+
+/// @brief the CRC-32 used by PNG chunks, computed bitwise as only a handful of small files are written.
+static uint32_t crc32(const uint8_t* data, size_t length, uint32_t crc = 0) {
+    crc = ~crc;
+    for (size_t i = 0; i < length; ++i) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ (0xedb88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+/// @brief appends `value` to `out` as 4 big endian bytes, the byte order used throughout PNG.
+static void put_be32(std::vector<uint8_t>& out, uint32_t value) {
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        out.push_back((value >> shift) & 0xff);
+    }
+}
+
+/// @brief writes a PNG chunk, which is its length, type, data and a CRC of the type and data.
+static void write_chunk(std::ofstream& stream, const char type[4], const std::vector<uint8_t>& data) {
+    std::vector<uint8_t> chunk;
+    put_be32(chunk, data.size());
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+    put_be32(chunk, crc32(chunk.data() + 4, chunk.size() - 4));
+    stream.write(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+}
+
+bool write_png(const char* path, const Framebuffer& fb, size_t scale) {
+    const uint32_t width = fb.width() * scale;
+    const uint32_t height = fb.height() * scale;
+
+    // the raw image is every row prefixed with its filter type, which is always 0 (none).
+    std::vector<uint8_t> raw;
+    raw.reserve((width + 1) * height);
+    for (uint32_t y = 0; y < height; ++y) {
+        raw.push_back(0);
+        for (uint32_t x = 0; x < width; ++x) {
+            raw.push_back(fb.pixel_status(x / scale, y / scale) ? 0xff : 0x00);
+        }
+    }
+
+    // wraps the raw image in a zlib stream made of uncompressed ("stored") deflate blocks, which hold at most 65535 bytes each.
+    std::vector<uint8_t> zlib = { 0x78, 0x01 };
+    for (size_t at = 0; at < raw.size(); ) {
+        const size_t length = std::min<size_t>(raw.size() - at, 65535);
+        const bool last = at + length == raw.size();
+        zlib.push_back(last ? 1 : 0);
+        zlib.push_back(length & 0xff);
+        zlib.push_back(length >> 8);
+        zlib.push_back(~length & 0xff);
+        zlib.push_back((~length >> 8) & 0xff);
+        zlib.insert(zlib.end(), raw.begin() + at, raw.begin() + at + length);
+        at += length;
+    }
+    // the zlib stream ends with an Adler-32 checksum of the uncompressed data.
+    uint32_t a = 1, b = 0;
+    for (uint8_t byte : raw) {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+    put_be32(zlib, (b << 16) | a);
+
+    std::vector<uint8_t> header;
+    put_be32(header, width);
+    put_be32(header, height);
+    header.insert(header.end(), { 8 /* bit depth */, 0 /* grayscale */, 0 /* deflate */, 0 /* filtering */, 0 /* no interlace */ });
+
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    stream.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+    write_chunk(stream, "IHDR", header);
+    write_chunk(stream, "IDAT", zlib);
+    write_chunk(stream, "IEND", {});
+    return stream.good();
+}
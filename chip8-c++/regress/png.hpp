@@ -0,0 +1,13 @@
+// no duplicate includes.
+#pragma once
+
+// the framebuffer which is written out.
+#include<core.hpp>
+
+/// @brief writes a framebuffer as a grayscale PNG, scaled up by an integer factor. The image data is stored
+/// @brief uncompressed, so no compression library is needed; CHIP-8 frames are small enough for that not to matter.
+/// @param path the path of the PNG file, which is overwritten
+/// @param fb the framebuffer to write
+/// @param scale the factor every pixel is scaled up by
+/// @return whether the file was written successfully
+bool write_png(const char* path, const Framebuffer& fb, size_t scale);
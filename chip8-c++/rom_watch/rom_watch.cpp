@@ -0,0 +1,49 @@
+// the ROM watcher declarations implemented in this file.
+#include<rom_watch.hpp>
+
+// gives the inotify functions.
+#include<sys/inotify.h>
+#include<unistd.h>
+#include<climits>
+
+bool RomWatcher::create(const char* path, RomWatcher& watcher) {
+    const std::string file = path;
+    const size_t slash = file.rfind('/');
+    const std::string directory = slash == std::string::npos ? "." : slash == 0 ? "/" : file.substr(0, slash);
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    // a finished write, or a file moved over the watched one. Plain writes are left out, a file is only
+    // reloaded once whatever is writing it closes it.
+    if (inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        close(fd);
+        return false;
+    }
+    watcher.fd = fd;
+    watcher.name = slash == std::string::npos ? file : file.substr(slash + 1);
+    return true;
+}
+
+RomWatcher::~RomWatcher() {
+    if (this->fd >= 0) {
+        close(this->fd);
+    }
+}
+
+bool RomWatcher::changed() {
+    bool changed = false;
+    // room for at least one event with the longest name, the events are aligned like inotify_event.
+    alignas(inotify_event) char buffer[sizeof(inotify_event) + NAME_MAX + 1];
+    ssize_t length;
+    while ((length = read(this->fd, buffer, sizeof(buffer))) > 0) {
+        for (ssize_t at = 0; at < length;) {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + at);
+            if (event->len != 0 && this->name == event->name) {
+                changed = true;
+            }
+            at += sizeof(inotify_event) + event->len;
+        }
+    }
+    return changed;
+}
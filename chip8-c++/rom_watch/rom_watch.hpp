@@ -0,0 +1,30 @@
+// no duplicate includes.
+#pragma once
+
+// gives the std::string type used to keep the file name.
+#include<string>
+
+/// @brief watches a ROM file for changes with inotify, for reloading it while it's being worked on. The directory is
+/// @brief watched instead of the file itself, since many editors and assemblers save by writing a new file and renaming
+/// @brief it over the old one, which a watch on the old file would never see.
+struct RomWatcher {
+    /// @brief starts watching the file at `path`.
+    /// @param path the path of the ROM
+    /// @param watcher the created watcher, only valid if creating succeeds
+    /// @return whether the directory of the file could be watched
+    static bool create(const char* path, RomWatcher& watcher);
+
+    RomWatcher() = default;
+    RomWatcher(const RomWatcher&) = delete;
+    RomWatcher& operator=(const RomWatcher&) = delete;
+    /// stops watching.
+    ~RomWatcher();
+
+    /// @brief whether the file was written or replaced since the last call. Never blocks, so it can be called every frame.
+    bool changed();
+private:
+    /// the inotify descriptor, -1 if not watching.
+    int fd = -1;
+    /// the name of the file inside the watched directory.
+    std::string name;
+};
@@ -0,0 +1,292 @@
+// the scaling declarations implemented in this file.
+#include<scale.hpp>
+
+// gives the std::memcpy and std::strcmp functions.
+#include<cstring>
+
+// gives the std::min function.
+#include<algorithm>
+
+// the zone profiler, its zones compile to nothing unless it's built.
+#include<profiler.hpp>
+
+// gives the SSE2 intrinsics, which every x86-64 CPU has. Other CPUs use the plain loops.
+#ifdef __SSE2__
+#include<emmintrin.h>
+#endif
+
+bool parse_scale_filter(const char* name, ScaleFilter& filter) {
+    static const struct { const char* name; ScaleFilter filter; } FILTERS[] = {
+        { "nearest", ScaleFilter::Nearest },
+        { "scale2x", ScaleFilter::Scale2x },
+        { "scale3x", ScaleFilter::Scale3x },
+        { "scale4x", ScaleFilter::Scale4x },
+        { "scanlines", ScaleFilter::Scanlines },
+        { "phosphor", ScaleFilter::Phosphor },
+    };
+    for (const auto& entry : FILTERS) {
+        if (std::strcmp(entry.name, name) == 0) {
+            filter = entry.filter;
+            return true;
+        }
+    }
+    return false;
+}
+
+Upscaler::Upscaler(ScaleFilter filter, size_t scale, size_t threads) : filter(filter), scale(scale) {
+    switch (filter) {
+    case ScaleFilter::Scale2x: this->scale = 2; break;
+    case ScaleFilter::Scale3x: this->scale = 3; break;
+    case ScaleFilter::Scale4x: this->scale = 4; break;
+    default: assert(scale > 0);
+    }
+    if (threads > 1) {
+        this->pool.reset(new WorkerPool(threads));
+    }
+}
+
+void Upscaler::for_each_band(size_t height, const std::function<void(size_t, size_t)>& rows) {
+    if (!this->pool) {
+        CHIP8_ZONE("scale band");
+        rows(0, height);
+        return;
+    }
+    const size_t bands = this->pool->threads();
+    const size_t band_height = (height + bands - 1) / bands;
+    this->pool->run(bands, [&](size_t band) {
+        CHIP8_PROFILE_THREAD("scale");
+        CHIP8_ZONE("scale band");
+        const size_t first = band * band_height;
+        const size_t last = std::min(height, first + band_height);
+        if (first < last) rows(first, last);
+    });
+}
+
+void Upscaler::scale_frame(const Framebuffer& fb, void* destination, size_t pitch) {
+    const uint32_t* source = fb.ptr_begin();
+    const size_t width = fb.width();
+    const size_t height = fb.height();
+    uint8_t* out = static_cast<uint8_t*>(destination);
+    switch (this->filter) {
+    case ScaleFilter::Nearest:
+    case ScaleFilter::Scanlines: {
+        const bool scanlines = this->filter == ScaleFilter::Scanlines;
+        this->for_each_band(height, [&](size_t first, size_t last) {
+            this->nearest_rows(source, width, first, last, out, pitch, scanlines);
+        });
+    } break;
+    case ScaleFilter::Phosphor: {
+        if (this->phosphor.size() != fb.len()) {
+            this->phosphor.assign(fb.len(), Framebuffer::PIXEL_OFF);
+        }
+        this->for_each_band(height, [&](size_t first, size_t last) {
+            this->phosphor_rows(source, width, first, last);
+            this->nearest_rows(this->phosphor.data(), width, first, last, out, pitch, false);
+        });
+    } break;
+    case ScaleFilter::Scale2x: {
+        this->for_each_band(height, [&](size_t first, size_t last) {
+            scale2x_rows(source, width, height, first, last, out, pitch);
+        });
+    } break;
+    case ScaleFilter::Scale3x: {
+        this->for_each_band(height, [&](size_t first, size_t last) {
+            scale3x_rows(source, width, height, first, last, out, pitch);
+        });
+    } break;
+    case ScaleFilter::Scale4x: {
+        // the second pass reads neighbouring rows of the first, so the first has to finish completely before it starts.
+        this->intermediate.resize(fb.len() * 4);
+        uint8_t* intermediate = reinterpret_cast<uint8_t*>(this->intermediate.data());
+        const size_t intermediate_pitch = width * 2 * sizeof(uint32_t);
+        this->for_each_band(height, [&](size_t first, size_t last) {
+            scale2x_rows(source, width, height, first, last, intermediate, intermediate_pitch);
+        });
+        this->for_each_band(height * 2, [&](size_t first, size_t last) {
+            scale2x_rows(this->intermediate.data(), width * 2, height * 2, first, last, out, pitch);
+        });
+    } break;
+    }
+}
+
+void Upscaler::nearest_rows(const uint32_t* source, size_t width, size_t first_row, size_t last_row, uint8_t* destination, size_t pitch, bool scanlines) const {
+    const size_t scale = this->scale;
+    const size_t out_width = width * scale;
+    for (size_t y = first_row; y < last_row; ++y) {
+        const uint32_t* in = source + y * width;
+        uint32_t* row = reinterpret_cast<uint32_t*>(destination + y * scale * pitch);
+        size_t x = 0;
+#ifdef __SSE2__
+        // widens 4 source pixels at a time. Scales of 2 interleave the pixels with themselves,
+        // multiples of 4 broadcast every pixel into whole vectors.
+        if (scale == 2) {
+            for (; x + 4 <= width; x += 4) {
+                const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + x));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(row + x * 2), _mm_unpacklo_epi32(pixels, pixels));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(row + x * 2 + 4), _mm_unpackhi_epi32(pixels, pixels));
+            }
+        } else if (scale % 4 == 0) {
+            for (; x + 4 <= width; x += 4) {
+                const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + x));
+                const __m128i lanes[4] = {
+                    _mm_shuffle_epi32(pixels, 0x00), _mm_shuffle_epi32(pixels, 0x55),
+                    _mm_shuffle_epi32(pixels, 0xaa), _mm_shuffle_epi32(pixels, 0xff),
+                };
+                __m128i* out = reinterpret_cast<__m128i*>(row + x * scale);
+                for (size_t lane = 0; lane < 4; ++lane) {
+                    for (size_t repeat = 0; repeat < scale / 4; ++repeat) {
+                        _mm_storeu_si128(out++, lanes[lane]);
+                    }
+                }
+            }
+        }
+#endif
+        for (; x < width; ++x) {
+            std::fill_n(row + x * scale, scale, in[x]);
+        }
+        // every other row of the pixel is a copy of the first.
+        for (size_t repeat = 1; repeat < scale; ++repeat) {
+            std::memcpy(destination + (y * scale + repeat) * pitch, row, out_width * sizeof(uint32_t));
+        }
+        if (scanlines && scale > 1) {
+            // halves the color channels of the last row, keeping the alpha (the lowest byte of RGBA8888) as is.
+            uint32_t* last = reinterpret_cast<uint32_t*>(destination + (y * scale + scale - 1) * pitch);
+            size_t column = 0;
+#ifdef __SSE2__
+            const __m128i color_mask = _mm_set1_epi32(0x7f7f7f00);
+            const __m128i alpha_mask = _mm_set1_epi32(0x000000ff);
+            for (; column + 4 <= out_width; column += 4) {
+                const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(last + column));
+                const __m128i halved = _mm_and_si128(_mm_srli_epi32(pixels, 1), color_mask);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(last + column), _mm_or_si128(halved, _mm_and_si128(pixels, alpha_mask)));
+            }
+#endif
+            for (; column < out_width; ++column) {
+                last[column] = ((last[column] >> 1) & 0x7f7f7f00) | (last[column] & 0xff);
+            }
+        }
+    }
+}
+
+void Upscaler::phosphor_rows(const uint32_t* source, size_t width, size_t first_row, size_t last_row) {
+    // every byte fades to half its brightness each frame, and pixels that are on light up fully again.
+    size_t index = first_row * width;
+    const size_t end = last_row * width;
+#ifdef __SSE2__
+    const __m128i half_mask = _mm_set1_epi8(0x7f);
+    for (; index + 4 <= end; index += 4) {
+        __m128i* glow = reinterpret_cast<__m128i*>(&this->phosphor[index]);
+        const __m128i old = _mm_loadu_si128(glow);
+        const __m128i faded = _mm_subs_epu8(old, _mm_and_si128(_mm_srli_epi16(old, 1), half_mask));
+        const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + index));
+        _mm_storeu_si128(glow, _mm_max_epu8(faded, pixels));
+    }
+#endif
+    for (; index < end; ++index) {
+        uint32_t faded = 0;
+        for (int shift = 0; shift < 32; shift += 8) {
+            const uint32_t byte = (this->phosphor[index] >> shift) & 0xff;
+            const uint32_t lit = (source[index] >> shift) & 0xff;
+            faded |= std::max(byte - byte / 2, lit) << shift;
+        }
+        this->phosphor[index] = faded;
+    }
+}
+
+/// @brief the Scale2x rules for a single pixel `p` with the neighbours above `a`, right `b`, left `c` and below `d`,
+/// @brief giving the top left, top right, bottom left and bottom right output pixels.
+static inline void scale2x_pixel(uint32_t a, uint32_t b, uint32_t c, uint32_t d, uint32_t p, uint32_t out[4]) {
+    out[0] = (c == a && c != d && a != b) ? a : p;
+    out[1] = (a == b && a != c && b != d) ? b : p;
+    out[2] = (d == c && d != b && c != a) ? c : p;
+    out[3] = (b == d && b != a && d != c) ? d : p;
+}
+
+void Upscaler::scale2x_rows(const uint32_t* source, size_t width, size_t height, size_t first_row, size_t last_row, uint8_t* destination, size_t pitch) {
+    for (size_t y = first_row; y < last_row; ++y) {
+        // pixels past the edges repeat the edge pixels.
+        const uint32_t* up = source + (y > 0 ? y - 1 : y) * width;
+        const uint32_t* mid = source + y * width;
+        const uint32_t* down = source + (y + 1 < height ? y + 1 : y) * width;
+        uint32_t* top = reinterpret_cast<uint32_t*>(destination + y * 2 * pitch);
+        uint32_t* bottom = reinterpret_cast<uint32_t*>(destination + (y * 2 + 1) * pitch);
+        auto scalar = [&](size_t x) {
+            uint32_t out[4];
+            scale2x_pixel(up[x], mid[x + 1 < width ? x + 1 : x], mid[x > 0 ? x - 1 : x], down[x], mid[x], out);
+            top[x * 2] = out[0];
+            top[x * 2 + 1] = out[1];
+            bottom[x * 2] = out[2];
+            bottom[x * 2 + 1] = out[3];
+        };
+        size_t x = 0;
+        scalar(x++);
+#ifdef __SSE2__
+        // applies the rules to 4 pixels at once, building a mask for each rule from the neighbour comparisons.
+        for (; x + 5 <= width; x += 4) {
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(up + x));
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mid + x + 1));
+            const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mid + x - 1));
+            const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(down + x));
+            const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mid + x));
+            const __m128i ca = _mm_cmpeq_epi32(c, a), cd = _mm_cmpeq_epi32(c, d);
+            const __m128i ab = _mm_cmpeq_epi32(a, b), bd = _mm_cmpeq_epi32(b, d);
+            // `_mm_andnot_si128(x, y)` is `!x && y`.
+            const __m128i rule0 = _mm_andnot_si128(ab, _mm_andnot_si128(cd, ca));
+            const __m128i rule1 = _mm_andnot_si128(bd, _mm_andnot_si128(ca, ab));
+            const __m128i rule2 = _mm_andnot_si128(ca, _mm_andnot_si128(bd, cd));
+            const __m128i rule3 = _mm_andnot_si128(cd, _mm_andnot_si128(ab, bd));
+            auto select = [&](__m128i rule, __m128i neighbour) {
+                return _mm_or_si128(_mm_and_si128(rule, neighbour), _mm_andnot_si128(rule, p));
+            };
+            const __m128i e0 = select(rule0, a), e1 = select(rule1, b), e2 = select(rule2, c), e3 = select(rule3, d);
+            // interleaves the left and right output pixels into the two output rows.
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(top + x * 2), _mm_unpacklo_epi32(e0, e1));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(top + x * 2 + 4), _mm_unpackhi_epi32(e0, e1));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(bottom + x * 2), _mm_unpacklo_epi32(e2, e3));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(bottom + x * 2 + 4), _mm_unpackhi_epi32(e2, e3));
+        }
+#endif
+        for (; x < width; ++x) {
+            scalar(x);
+        }
+    }
+}
+
+void Upscaler::scale3x_rows(const uint32_t* source, size_t width, size_t height, size_t first_row, size_t last_row, uint8_t* destination, size_t pitch) {
+    // the 3x rules interleave outputs in threes, which doesn't map onto 4 wide vectors, so this filter stays scalar.
+    for (size_t y = first_row; y < last_row; ++y) {
+        const uint32_t* up = source + (y > 0 ? y - 1 : y) * width;
+        const uint32_t* mid = source + y * width;
+        const uint32_t* down = source + (y + 1 < height ? y + 1 : y) * width;
+        uint32_t* rows[3];
+        for (size_t r = 0; r < 3; ++r) {
+            rows[r] = reinterpret_cast<uint32_t*>(destination + (y * 3 + r) * pitch);
+        }
+        for (size_t x = 0; x < width; ++x) {
+            const size_t l = x > 0 ? x - 1 : x, r = x + 1 < width ? x + 1 : x;
+            // the neighbourhood, with `e` in the middle:
+            // a b c
+            // d e f
+            // g h i
+            const uint32_t a = up[l], b = up[x], c = up[r];
+            const uint32_t d = mid[l], e = mid[x], f = mid[r];
+            const uint32_t g = down[l], h = down[x], i = down[r];
+            const bool db = d == b && b != f && d != h;
+            const bool bf = b == f && b != d && f != h;
+            const bool dh = d == h && d != b && h != f;
+            const bool hf = h == f && d != h && b != f;
+            uint32_t* out0 = rows[0] + x * 3;
+            uint32_t* out1 = rows[1] + x * 3;
+            uint32_t* out2 = rows[2] + x * 3;
+            out0[0] = db ? d : e;
+            out0[1] = (db && e != c) || (bf && e != a) ? b : e;
+            out0[2] = bf ? f : e;
+            out1[0] = (db && e != g) || (dh && e != a) ? d : e;
+            out1[1] = e;
+            out1[2] = (bf && e != i) || (hf && e != c) ? f : e;
+            out2[0] = dh ? d : e;
+            out2[1] = (dh && e != i) || (hf && e != g) ? h : e;
+            out2[2] = hf ? f : e;
+        }
+    }
+}
@@ -0,0 +1,85 @@
+// no duplicate includes.
+#pragma once
+
+// the framebuffer which is scaled.
+#include<core.hpp>
+
+// the pool used to scale bands of rows in parallel.
+#include<worker_pool.hpp>
+
+// gives the std::vector type used for intermediate buffers.
+#include<vector>
+
+// gives the std::unique_ptr type owning the worker pool.
+#include<memory>
+
+/// the filters the framebuffer can be scaled up with.
+enum class ScaleFilter {
+    /// every pixel becomes a square of `scale` by `scale` pixels.
+    Nearest,
+    /// the Scale2x (AdvMAME2x) pixel art scaler, which rounds off diagonal edges. Always scales by 2.
+    Scale2x,
+    /// the Scale3x (AdvMAME3x) pixel art scaler. Always scales by 3.
+    Scale3x,
+    /// Scale2x applied twice. Always scales by 4.
+    Scale4x,
+    /// nearest scaling with the last row of every pixel darkened, like the gaps between the scanlines of a CRT.
+    Scanlines,
+    /// nearest scaling where pixels fade out over a few frames instead of turning off at once, like the phosphor of a CRT.
+    /// CHIP-8 games redraw sprites by erasing and drawing them again, and this hides the flicker that causes.
+    Phosphor,
+};
+
+/// @brief parses the name of a filter, as used on the command line (`nearest`, `scale2x`, `scale3x`, `scale4x`, `scanlines`, `phosphor`).
+/// @param name the name of the filter
+/// @param filter the parsed filter, only modified if the name is known
+/// @return whether the name is known
+bool parse_scale_filter(const char* name, ScaleFilter& filter);
+
+/// scales framebuffers up on the CPU into caller provided memory, for example a locked SDL texture. The inner loops use
+/// SSE2 when it's available, and the rows can be split into bands that are scaled on several threads.
+struct Upscaler {
+    /// @brief creates an upscaler.
+    /// @param filter the filter to scale with
+    /// @param scale the scale of the `Nearest`, `Scanlines` and `Phosphor` filters, the other filters have a fixed scale
+    /// @param threads the amount of threads to scale with, 1 scales on the calling thread only
+    Upscaler(ScaleFilter filter, size_t scale, size_t threads = 1);
+
+    /// the factor the width and height are scaled by.
+    size_t factor() const {
+        return this->scale;
+    }
+
+    /// @brief scales a framebuffer into `destination`, which must hold `fb.height() * factor()` rows of
+    /// @brief `fb.width() * factor()` pixels in the framebuffer's pixel format.
+    /// @param fb the framebuffer to scale
+    /// @param destination the first row of the destination
+    /// @param pitch the distance between two rows of the destination, in bytes
+    void scale_frame(const Framebuffer& fb, void* destination, size_t pitch);
+private:
+    /// @brief scales source rows `[first_row, last_row)` of `source` (`width` pixels wide) with Scale2x.
+    static void scale2x_rows(const uint32_t* source, size_t width, size_t height, size_t first_row, size_t last_row, uint8_t* destination, size_t pitch);
+
+    /// @brief scales source rows `[first_row, last_row)` with Scale3x.
+    static void scale3x_rows(const uint32_t* source, size_t width, size_t height, size_t first_row, size_t last_row, uint8_t* destination, size_t pitch);
+
+    /// @brief scales source rows `[first_row, last_row)` with nearest scaling, darkening the last row of every pixel if `scanlines` is set.
+    void nearest_rows(const uint32_t* source, size_t width, size_t first_row, size_t last_row, uint8_t* destination, size_t pitch, bool scanlines) const;
+
+    /// @brief fades the phosphor buffer for rows `[first_row, last_row)` and lights up the pixels that are on in `source`.
+    void phosphor_rows(const uint32_t* source, size_t width, size_t first_row, size_t last_row);
+
+    /// @brief calls `rows` with bands of `[0, height)`, on the pool if there is one.
+    void for_each_band(size_t height, const std::function<void(size_t, size_t)>& rows);
+
+    /// the filter.
+    ScaleFilter filter;
+    /// the scale factor.
+    size_t scale;
+    /// the threads scaling bands, null if scaling happens on the calling thread only.
+    std::unique_ptr<WorkerPool> pool;
+    /// the intermediate image between the two Scale2x passes of Scale4x.
+    std::vector<uint32_t> intermediate;
+    /// the brightness of every pixel for the phosphor filter, fading a little every frame.
+    std::vector<uint32_t> phosphor;
+};
@@ -0,0 +1,73 @@
+// the scheduler declarations implemented in this file.
+#include<scheduler.hpp>
+
+CoreScheduler::CoreScheduler(size_t cores, size_t instructions_per_frame)
+    : core_count(cores), instructions_per_frame(instructions_per_frame), wheel(WHEEL_SLOTS), parked_since(cores, 0), is_parked(cores, false) {
+    for (uint32_t index = 0; index < cores; ++index) {
+        this->active.push_back(index);
+    }
+}
+
+const std::vector<uint32_t>& CoreScheduler::begin_frame(std::vector<Core>& cores, const std::function<uint16_t(size_t)>& input) {
+    assert(cores.size() == this->core_count);
+    // the cores whose timer runs out this frame.
+    std::vector<uint32_t>& slot = this->wheel[this->frame_index % WHEEL_SLOTS];
+    for (uint32_t index : slot) {
+        this->wake(cores, index);
+    }
+    slot.clear();
+
+    // the cores getting a newly pressed key. The others still get the input, so a key let go and pressed again is seen.
+    for (size_t waiter = 0; waiter < this->keypress_waiters.size();) {
+        const uint32_t index = this->keypress_waiters[waiter];
+        const uint16_t bitmap = input(index);
+        if ((bitmap & ~cores[index].hexpad_bitmap()) != 0) {
+            this->keypress_waiters[waiter] = this->keypress_waiters.back();
+            this->keypress_waiters.pop_back();
+            this->wake(cores, index);
+        } else {
+            cores[index].update_hexpad_bitmap(bitmap);
+            ++waiter;
+        }
+    }
+    return this->active;
+}
+
+void CoreScheduler::end_frame(std::vector<Core>& cores) {
+    ++this->frame_index;
+    size_t kept = 0;
+    for (uint32_t index : this->active) {
+        if (core_wait(cores[index]) == CoreWait::None) {
+            this->active[kept++] = index;
+        } else {
+            this->park(cores, index);
+        }
+    }
+    this->active.resize(kept);
+}
+
+void CoreScheduler::sync(std::vector<Core>& cores, const std::function<uint16_t(size_t)>& input) {
+    for (uint32_t index = 0; index < this->core_count; ++index) {
+        if (!this->is_parked[index]) continue;
+        cores[index].idle_frames(this->frame_index - this->parked_since[index], this->instructions_per_frame);
+        this->parked_since[index] = this->frame_index;
+        // a keypress waiter already has it, and for the others it's only kept, as they don't read the hexpad.
+        if (!cores[index].waiting_for_keypress()) cores[index].update_hexpad_bitmap(input(index));
+    }
+}
+
+void CoreScheduler::park(std::vector<Core>& cores, uint32_t index) {
+    this->is_parked[index] = true;
+    this->parked_since[index] = this->frame_index;
+    switch (core_wait(cores[index])) {
+    case CoreWait::Keypress: this->keypress_waiters.push_back(index); break;
+    case CoreWait::Timer: this->wheel[(this->frame_index + cores[index].sleep_frames()) % WHEEL_SLOTS].push_back(index); break;
+    default:; // never runs again, `sync` still catches up its timers.
+    }
+}
+
+void CoreScheduler::wake(std::vector<Core>& cores, uint32_t index) {
+    cores[index].idle_frames(this->frame_index - this->parked_since[index], this->instructions_per_frame);
+    this->is_parked[index] = false;
+    this->active.push_back(index);
+}
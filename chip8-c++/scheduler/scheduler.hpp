@@ -0,0 +1,101 @@
+// no duplicate includes.
+#pragma once
+
+// the cores being scheduled.
+#include<core.hpp>
+
+// gives the std::vector type used for the run lists and the wheel.
+#include<vector>
+
+// gives the std::function type used for the input of waiting cores.
+#include<functional>
+
+/// what a core needs before it can run again.
+enum class CoreWait : uint8_t {
+    /// nothing, the core can run.
+    None,
+    /// a key to be pressed, the core is waiting on FX0A.
+    Keypress,
+    /// its delay timer to tick, the core is sleeping, see `Core::sleeping`.
+    Timer,
+    /// nothing will ever make it run again, the core trapped or halted.
+    Forever,
+};
+
+/// @brief works out what a core needs before it can run again.
+inline CoreWait core_wait(const Core& core) {
+    if (core.trap() != CoreTrap::None || core.halted()) return CoreWait::Forever;
+    if (core.waiting_for_keypress()) return CoreWait::Keypress;
+    if (core.sleeping()) return CoreWait::Timer;
+    return CoreWait::None;
+}
+
+/// runs many cores frame by frame together, only visiting the cores that can run.
+///
+/// Cores that can't run are parked until what they wait for happens, so the cost of a frame grows with the
+/// cores doing something instead of with every core. Cores waiting on their delay timer go into a timer wheel,
+/// a ring of slots with one slot per frame, and are only looked at again in the frame they wake up in. The delay
+/// timer is 8 bits wide, so no core sleeps for more than 255 frames, and a single lap of 256 slots always
+/// suffices. Cores waiting for a keypress are woken when their input gets a newly pressed key, and trapped or
+/// halted cores are never visited again. A parked core catches up on the timer ticks it missed when it wakes,
+/// see `Core::idle_frames`, so every core ends up exactly as if it had been run every frame.
+struct CoreScheduler {
+    /// @brief creates a scheduler for `cores` cores, which all start out runnable.
+    /// @param instructions_per_frame the amount of instructions the cores are run for every frame
+    CoreScheduler(size_t cores, size_t instructions_per_frame);
+
+    /// @brief starts a frame, waking the parked cores that can run again.
+    /// @param cores the cores, always the same ones in the same order
+    /// @param input gives the hexpad bitmap of a core for this frame, only called for cores waiting for a keypress
+    /// @return the indices of the cores to run this frame with `Core::run_frame`, valid until `end_frame`
+    const std::vector<uint32_t>& begin_frame(std::vector<Core>& cores, const std::function<uint16_t(size_t)>& input);
+
+    /// @brief ends the frame started by `begin_frame`, once its cores have run, parking the cores that can't run anymore.
+    void end_frame(std::vector<Core>& cores);
+
+    /// @brief catches every parked core up on the frames it missed, so their timers and hexpad are correct. Needed
+    /// @brief before looking at their timers or taking savestates, the framebuffer of a parked core is always up to date.
+    /// @param input gives the hexpad bitmap of a core in the last frame, as only cores waiting for a keypress get it
+    /// while parked
+    void sync(std::vector<Core>& cores, const std::function<uint16_t(size_t)>& input);
+
+    /// the amount of cores that ran in the last frame.
+    size_t running() const {
+        return this->active.size();
+    }
+
+    /// the amount of parked cores.
+    size_t parked() const {
+        return this->core_count - this->active.size();
+    }
+
+    /// the amount of frames run.
+    uint64_t frame() const {
+        return this->frame_index;
+    }
+private:
+    /// @brief parks a core that can't run, from the next frame on.
+    void park(std::vector<Core>& cores, uint32_t index);
+    /// @brief wakes a parked core, catching it up on the frames it missed.
+    void wake(std::vector<Core>& cores, uint32_t index);
+
+    /// the amount of slots in the timer wheel, one more than the longest a core can sleep.
+    static const size_t WHEEL_SLOTS = 256;
+
+    /// the amount of cores.
+    size_t core_count;
+    /// the amount of instructions every frame runs.
+    size_t instructions_per_frame;
+    /// the index of the current frame.
+    uint64_t frame_index = 0;
+    /// the cores that can run.
+    std::vector<uint32_t> active;
+    /// the cores waiting for a keypress.
+    std::vector<uint32_t> keypress_waiters;
+    /// the sleeping cores, in the slot of the frame they wake up in.
+    std::vector<std::vector<uint32_t>> wheel;
+    /// the first frame every parked core missed.
+    std::vector<uint64_t> parked_since;
+    /// whether every core is parked.
+    std::vector<bool> is_parked;
+};
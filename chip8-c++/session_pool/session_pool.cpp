@@ -0,0 +1,150 @@
+// the session declarations implemented in this file.
+#include<session_pool.hpp>
+
+// gives the threads, locks and atomics the pool is built on.
+#include<thread>
+#include<mutex>
+#include<atomic>
+
+// gives the std::deque type of the queues.
+#include<deque>
+
+// gives the std::unique_ptr type, as the queues can't be moved.
+#include<memory>
+
+// gives the std::min and std::max functions.
+#include<algorithm>
+
+Session::Session(const Core& core, size_t instructions_per_frame)
+    : session_core(core), instructions_per_frame(instructions_per_frame) {}
+
+SessionYield Session::resume(size_t budget) {
+    assert(budget != 0);
+    if (this->is_done) return SessionYield::Done;
+    if (this->frame_left == 0) {
+        uint16_t hexpad_bitmap = 0;
+        if (!this->frame_begin(this->frame_index, hexpad_bitmap)) {
+            this->is_done = true;
+            return SessionYield::Done;
+        }
+        this->session_core.begin_frame(hexpad_bitmap);
+        this->frame_left = this->instructions_per_frame;
+    }
+
+    // a core that can't run only counts the rest of its frame, so it finishes the frame whatever the budget.
+    const size_t slice = this->session_core.can_run() ? std::min(budget, this->frame_left) : this->frame_left;
+    this->session_core.run_for_instructions(slice);
+    this->frame_left -= slice;
+    if (this->frame_left != 0) {
+        if (this->session_core.can_run()) return SessionYield::Budget;
+        this->session_core.run_for_instructions(this->frame_left);
+        this->frame_left = 0;
+    }
+
+    this->session_core.tick_timers();
+    this->frame_end(this->frame_index);
+    ++this->frame_index;
+    return this->session_core.waiting_for_keypress() ? SessionYield::Keypress : SessionYield::Frame;
+}
+
+SessionPool::SessionPool(size_t threads) : threads(threads) {
+    if (this->threads == 0) {
+        this->threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+void SessionPool::add(Session& session) {
+    this->sessions.push_back(&session);
+}
+
+/// the sessions waiting for their turn on a thread.
+struct SessionQueue {
+    /// guards `sessions`, held only long enough to take or put back a session.
+    std::mutex mutex;
+    /// the sessions, the owning thread takes from the front and other threads steal from the back.
+    std::deque<Session*> sessions;
+};
+
+SessionPoolStats SessionPool::run(size_t budget) {
+    const size_t threads = std::max<size_t>(1, std::min(this->threads, this->sessions.size()));
+    std::vector<std::unique_ptr<SessionQueue>> queues;
+    for (size_t thread = 0; thread < threads; ++thread) {
+        queues.emplace_back(new SessionQueue());
+    }
+    // the sessions are dealt out like cards, so every thread starts with a share.
+    for (size_t index = 0; index < this->sessions.size(); ++index) {
+        queues[index % threads]->sessions.push_back(this->sessions[index]);
+    }
+
+    std::atomic<size_t> remaining { this->sessions.size() };
+    std::mutex stats_mutex;
+    SessionPoolStats stats;
+
+    auto worker = [&](size_t thread) {
+        SessionPoolStats local;
+        SessionQueue& own = *queues[thread];
+        while (remaining.load() != 0) {
+            Session* session = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(own.mutex);
+                if (!own.sessions.empty()) {
+                    session = own.sessions.front();
+                    own.sessions.pop_front();
+                }
+            }
+            // its own queue ran empty, so it looks through the other queues, starting with the next thread's.
+            for (size_t offset = 1; session == nullptr && offset < threads; ++offset) {
+                SessionQueue& victim = *queues[(thread + offset) % threads];
+                std::lock_guard<std::mutex> lock(victim.mutex);
+                if (!victim.sessions.empty()) {
+                    session = victim.sessions.back();
+                    victim.sessions.pop_back();
+                    ++local.steals;
+                }
+            }
+            // every session left is being resumed by another thread, one of them will be put back soon.
+            if (session == nullptr) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            ++local.resumes;
+            const SessionYield yield = session->resume(budget);
+            switch (yield) {
+                case SessionYield::Done:
+                    remaining.fetch_sub(1);
+                    continue;
+                case SessionYield::Budget:
+                    ++local.budget_yields;
+                    break;
+                case SessionYield::Keypress:
+                    ++local.keypress_yields;
+                    ++local.frames;
+                    break;
+                case SessionYield::Frame:
+                    ++local.frames;
+                    break;
+            }
+            std::lock_guard<std::mutex> lock(own.mutex);
+            own.sessions.push_back(session);
+        }
+
+        std::lock_guard<std::mutex> lock(stats_mutex);
+        stats.frames += local.frames;
+        stats.resumes += local.resumes;
+        stats.keypress_yields += local.keypress_yields;
+        stats.budget_yields += local.budget_yields;
+        stats.steals += local.steals;
+    };
+
+    std::vector<std::thread> pool;
+    for (size_t thread = 1; thread < threads; ++thread) {
+        pool.emplace_back(worker, thread);
+    }
+    worker(0); // the calling thread works too.
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+    this->sessions.clear();
+    return stats;
+}
@@ -0,0 +1,122 @@
+// no duplicate includes.
+#pragma once
+
+// the cores the sessions run.
+#include<core.hpp>
+
+// gives the std::vector type used for the sessions.
+#include<vector>
+
+/// why a session gave its thread back, see `Session::resume`.
+enum class SessionYield : uint8_t {
+    /// it finished a frame.
+    Frame,
+    /// it finished a frame and its core is waiting for a keypress (FX0A).
+    Keypress,
+    /// it ran out of instructions in the middle of a frame.
+    Budget,
+    /// it ended, `Session::frame_begin` returned `false`.
+    Done,
+};
+
+/// a long running emulated session: a core, plus whatever the session does with it between frames, like recording
+/// the frames or scoring them.
+///
+/// A session is a run loop that can stop and continue where it left off, the way a coroutine would, but written once
+/// here instead of around every use of `Core::run_for_instructions_then_tick_timers`. `resume` runs the session
+/// until it finishes a frame or has run the instructions it was given, and remembers how far into the frame it got,
+/// so thousands of sessions can take turns on a few threads. Sessions only say what they do at the edges of frames, by
+/// overriding `frame_begin` and `frame_end`. However a frame is split up, it ends with the core in exactly the same
+/// state as `Core::run_frame` would leave it in.
+struct Session {
+    /// @brief creates a session around a core.
+    /// @param instructions_per_frame the amount of instructions every frame runs
+    Session(const Core& core, size_t instructions_per_frame);
+
+    virtual ~Session() = default;
+
+    /// @brief called before every frame, to give its input or end the session.
+    /// @param frame the index of the frame, starting at 0
+    /// @param hexpad_bitmap the hexpad state for the frame, 0 unless set
+    /// @return `false` to end the session instead of running the frame
+    virtual bool frame_begin(uint64_t frame, uint16_t& hexpad_bitmap) = 0;
+
+    /// @brief called after every frame, the core's framebuffer and dirty rows are those of the frame.
+    /// @param frame the index of the frame
+    virtual void frame_end(uint64_t frame) {
+        (void) frame;
+    }
+
+    /// @brief runs the session until it finishes a frame or has run `budget` instructions.
+    /// @param budget the most instructions to run, at least 1
+    /// @return why the session stopped, once `Done` it stays `Done`
+    SessionYield resume(size_t budget);
+
+    /// the core of the session.
+    Core& core() {
+        return this->session_core;
+    }
+
+    /// the amount of frames the session finished.
+    uint64_t frame() const {
+        return this->frame_index;
+    }
+
+    /// whether the session ended.
+    bool done() const {
+        return this->is_done;
+    }
+private:
+    /// the core of the session.
+    Core session_core;
+    /// the amount of instructions every frame runs.
+    size_t instructions_per_frame;
+    /// the instructions left in the current frame, 0 between frames.
+    size_t frame_left = 0;
+    /// the amount of frames finished.
+    uint64_t frame_index = 0;
+    /// whether the session ended.
+    bool is_done = false;
+};
+
+/// what a `SessionPool::run` did.
+struct SessionPoolStats {
+    /// the amount of frames the sessions finished.
+    uint64_t frames = 0;
+    /// the amount of times a session was resumed.
+    uint64_t resumes = 0;
+    /// the amount of times a session was resumed while its core waited for a keypress.
+    uint64_t keypress_yields = 0;
+    /// the amount of times a session ran out of its budget in the middle of a frame.
+    uint64_t budget_yields = 0;
+    /// the amount of sessions a thread took from another thread's queue.
+    uint64_t steals = 0;
+};
+
+/// runs many sessions on a few threads, until every session ended.
+///
+/// Every thread has its own queue of sessions. It resumes the session at the front, and puts it back at the end unless
+/// the session ended, so the sessions of a queue take turns. A thread whose queue ran empty takes a session from the
+/// back of another thread's queue, so threads whose sessions end early help the others instead of waiting for them.
+/// Sessions only ever run on one thread at a time, but can move between threads from one resume to the next.
+struct SessionPool {
+    /// @brief creates a pool.
+    /// @param threads the amount of threads, 0 uses one per hardware thread
+    SessionPool(size_t threads = 0);
+
+    /// @brief adds a session, which must stay alive until `run` returns.
+    void add(Session& session);
+
+    /// @brief runs every added session until they all ended, then forgets them.
+    /// @param budget the most instructions a session runs before the next one gets its turn
+    /// @return what the run did
+    SessionPoolStats run(size_t budget = DEFAULT_BUDGET);
+
+    /// the budget `run` uses by default, more than a frame of most ROMs.
+    static const size_t DEFAULT_BUDGET = 1000;
+private:
+    /// the amount of threads.
+    size_t threads;
+    /// the sessions to run.
+    std::vector<Session*> sessions;
+};
@@ -0,0 +1,115 @@
+// the shared memory declarations implemented in this file.
+#include<shm_export.hpp>
+
+// gives the POSIX shared memory and memory mapping functions.
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include<fcntl.h>
+#include<unistd.h>
+
+// gives the std::memcpy function.
+#include<cstring>
+
+// the atomic has to be lock free, otherwise it wouldn't work across processes.
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "the sequence counter must be lock free to be shared");
+
+bool ShmExporter::create(const char* name, ShmExporter& exporter) {
+    shm_unlink(name); // removes a segment left behind by a crashed emulator.
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    if (ftruncate(fd, sizeof(ShmExportLayout)) != 0) {
+        close(fd);
+        shm_unlink(name);
+        return false;
+    }
+    void* mapping = mmap(nullptr, sizeof(ShmExportLayout), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd); // the mapping keeps the segment alive, the descriptor isn't needed anymore.
+    if (mapping == MAP_FAILED) {
+        shm_unlink(name);
+        return false;
+    }
+    // the segment starts out zeroed, which is a valid (even) sequence number.
+    ShmExportLayout* layout = static_cast<ShmExportLayout*>(mapping);
+    layout->width = 60;
+    layout->height = 60;
+    layout->version = SHM_EXPORT_VERSION;
+    layout->magic = SHM_EXPORT_MAGIC;
+    exporter.name = name;
+    exporter.layout = layout;
+    return true;
+}
+
+ShmExporter::~ShmExporter() {
+    if (this->layout != nullptr) {
+        munmap(this->layout, sizeof(ShmExportLayout));
+        shm_unlink(this->name.c_str());
+    }
+}
+
+void ShmExporter::publish(const Core& core, const ShmExportStats& stats) {
+    ShmExportLayout& layout = *this->layout;
+    // marks the segment as being written, the fence keeps the writes below from being moved above it.
+    const uint32_t sequence = layout.sequence.load(std::memory_order_relaxed);
+    layout.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    layout.frame += 1;
+    layout.instructions = stats.instructions;
+    layout.frame_time_us = stats.frame_time_us;
+    layout.hexpad_bitmap = core.hexpad_bitmap();
+    layout.registers = core.registers();
+    const Framebuffer& fb = core.framebuffer();
+    std::memcpy(layout.pixels, fb.ptr_begin(), fb.len() * sizeof(uint32_t));
+
+    // marks the segment as complete, the release store makes every write above visible to readers first.
+    layout.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+bool ShmReader::open(const char* name, ShmReader& reader) {
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    const bool large_enough = fstat(fd, &info) == 0 && size_t(info.st_size) >= sizeof(ShmExportLayout);
+    void* mapping = large_enough ? mmap(nullptr, sizeof(ShmExportLayout), PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    const ShmExportLayout* layout = static_cast<const ShmExportLayout*>(mapping);
+    if (layout->magic != SHM_EXPORT_MAGIC || layout->version != SHM_EXPORT_VERSION) {
+        munmap(mapping, sizeof(ShmExportLayout));
+        return false;
+    }
+    reader.layout = layout;
+    return true;
+}
+
+ShmReader::~ShmReader() {
+    if (this->layout != nullptr) {
+        munmap(const_cast<ShmExportLayout*>(this->layout), sizeof(ShmExportLayout));
+    }
+}
+
+void ShmReader::read(ShmExportLayout& snapshot) const {
+    while (true) {
+        const uint32_t before = this->layout->sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            continue; // the emulator is writing, try again.
+        }
+        // copies everything but the sequence counter, which can't be copied as a plain value.
+        const size_t data = offsetof(ShmExportLayout, width);
+        std::memcpy(reinterpret_cast<char*>(&snapshot) + data, reinterpret_cast<const char*>(this->layout) + data, sizeof(ShmExportLayout) - data);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const uint32_t after = this->layout->sequence.load(std::memory_order_relaxed);
+        if (before == after) {
+            snapshot.magic = this->layout->magic;
+            snapshot.version = this->layout->version;
+            snapshot.sequence.store(before, std::memory_order_relaxed);
+            return;
+        }
+    }
+}
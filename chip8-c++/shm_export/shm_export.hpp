@@ -0,0 +1,105 @@
+// no duplicate includes.
+#pragma once
+
+// the core which is exported.
+#include<core.hpp>
+
+// gives the std::atomic type used for the sequence counter.
+#include<atomic>
+
+// gives the std::string type used to keep the segment name.
+#include<string>
+
+/// the layout of the shared memory segment. External tools map the segment and read it directly, so the layout
+/// only uses fixed size types and never changes without bumping `SHM_EXPORT_VERSION`.
+struct ShmExportLayout {
+    /// always `SHM_EXPORT_MAGIC`, lets readers check they mapped the right segment.
+    uint32_t magic;
+    /// always `SHM_EXPORT_VERSION`.
+    uint32_t version;
+    /// the seqlock sequence counter. It's odd while the emulator is writing, and changes with every publish, so a reader
+    /// that sees the same even value before and after reading knows it read a complete, untorn frame.
+    std::atomic<uint32_t> sequence;
+    /// the framebuffer width in pixels.
+    uint32_t width;
+    /// the framebuffer height in pixels.
+    uint32_t height;
+    /// the amount of frames published so far.
+    uint64_t frame;
+    /// the amount of instructions the core has run so far.
+    uint64_t instructions;
+    /// how long the last host frame took, in microseconds.
+    uint32_t frame_time_us;
+    /// the hexpad bitmap of the last frame.
+    uint16_t hexpad_bitmap;
+    /// the registers of the core.
+    CoreRegisters registers;
+    /// the framebuffer, in the same format as `Framebuffer`.
+    uint32_t pixels[60 * 60];
+};
+
+/// the magic value at the start of the segment, "C8SH".
+static const uint32_t SHM_EXPORT_MAGIC = 0x48533843;
+/// the version of `ShmExportLayout`.
+static const uint32_t SHM_EXPORT_VERSION = 1;
+
+/// the emulator statistics published alongside the core.
+struct ShmExportStats {
+    /// the amount of instructions the core has run so far.
+    uint64_t instructions;
+    /// how long the last host frame took, in microseconds.
+    uint32_t frame_time_us;
+};
+
+/// publishes a core into a POSIX shared memory segment after every frame. Publishing never waits on readers.
+struct ShmExporter {
+    /// @brief creates the segment `name` (for example "/chip8"), replacing any previous segment with that name.
+    /// @param name the POSIX shared memory name, must start with a slash
+    /// @param exporter the created exporter, only valid if creating succeeds
+    /// @return whether the segment could be created and mapped
+    static bool create(const char* name, ShmExporter& exporter);
+
+    ShmExporter() = default;
+    ShmExporter(const ShmExporter&) = delete;
+    ShmExporter& operator=(const ShmExporter&) = delete;
+    /// unmaps and unlinks the segment, readers that still have it mapped keep their mapping.
+    ~ShmExporter();
+
+    /// @brief publishes the current state of a core.
+    /// @param core the core to publish
+    /// @param stats the emulator statistics to publish with it
+    void publish(const Core& core, const ShmExportStats& stats);
+private:
+    /// the segment name, needed to unlink the segment.
+    std::string name;
+    /// the mapped segment.
+    ShmExportLayout* layout = nullptr;
+};
+
+/// reads a segment published by `ShmExporter`, for consumers written in C++.
+struct ShmReader {
+    /// @brief maps the segment `name` read only.
+    /// @param name the POSIX shared memory name the exporter was created with
+    /// @param reader the opened reader, only valid if opening succeeds
+    /// @return whether the segment exists and has the expected layout
+    static bool open(const char* name, ShmReader& reader);
+
+    ShmReader() = default;
+    ShmReader(const ShmReader&) = delete;
+    ShmReader& operator=(const ShmReader&) = delete;
+    /// unmaps the segment.
+    ~ShmReader();
+
+    /// @brief copies a consistent snapshot of the segment, retrying while the emulator is in the middle of a publish.
+    /// @param snapshot the destination, its `sequence` holds the sequence number the snapshot was taken at
+    void read(ShmExportLayout& snapshot) const;
+
+    /// @brief the segment itself, for zero copy access. Reads from it must be validated by checking that
+    /// @brief `sequence` was even and unchanged before and after, which is what `read` does.
+    const ShmExportLayout& segment() const {
+        return *this->layout;
+    }
+private:
+    /// the mapped segment.
+    const ShmExportLayout* layout = nullptr;
+};
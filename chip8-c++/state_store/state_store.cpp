@@ -0,0 +1,265 @@
+// the state store declarations implemented in this file.
+#include<state_store.hpp>
+
+// gives the memory mapping functions.
+#include<sys/mman.h>
+#include<fcntl.h>
+#include<unistd.h>
+
+// gives the std::memcpy and std::memcmp functions.
+#include<cstring>
+
+// gives the std::min function.
+#include<algorithm>
+
+/// the ids that fit in a page of ids.
+static const size_t PAGE_FANOUT = StateStore::STATE_PAGE_SIZE / sizeof(uint32_t);
+
+/// @brief the amount of pages on every level of a state's tree, from the pages of state bytes up to the single top page.
+struct TreeShape {
+    TreeShape() {
+        size_t count = (Core::SAVESTATE_SIZE + StateStore::STATE_PAGE_SIZE - 1) / StateStore::STATE_PAGE_SIZE;
+        this->counts[0] = count;
+        while (count > 1) {
+            count = (count + PAGE_FANOUT - 1) / PAGE_FANOUT;
+            this->counts[++this->top] = count;
+        }
+        for (size_t level = 0; level <= this->top; ++level) {
+            this->offsets[level] = this->total;
+            this->total += this->counts[level];
+        }
+    }
+
+    /// the pages on every level.
+    size_t counts[8] = {};
+    /// where every level starts in a list of a whole tree's pages, level by level.
+    size_t offsets[8] = {};
+    /// the level of the single top page.
+    uint8_t top = 0;
+    /// the pages of a whole tree, the most a state can add to the store.
+    size_t total = 0;
+};
+
+static const TreeShape TREE;
+
+/// @brief hashes a page and its level, a word at a time.
+static uint64_t page_hash(const uint8_t bytes[], uint8_t level) {
+    uint64_t hash = 0x9e3779b97f4a7c15 ^ level;
+    for (size_t at = 0; at < StateStore::STATE_PAGE_SIZE; at += 8) {
+        uint64_t word;
+        std::memcpy(&word, bytes + at, sizeof(word));
+        hash = (hash ^ word) * 0xff51afd7ed558ccd;
+        hash ^= hash >> 32;
+    }
+    return hash;
+}
+
+bool StateStore::create(size_t max_pages, const char* spill_path, StateStore& store) {
+    // ids are 32 bits, and page 0 is never used.
+    if (max_pages < TREE.total + 1 || max_pages > UINT32_MAX) return false;
+    const size_t length = max_pages * STATE_PAGE_SIZE;
+    void* mapping = MAP_FAILED;
+    if (spill_path == nullptr) {
+        // only reserves the address space, memory is used as pages are written.
+        mapping = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    } else {
+        const int fd = open(spill_path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+        if (fd < 0) return false;
+        // a sparse file, disk space is used as pages are written out to it.
+        if (ftruncate(fd, length) == 0) {
+            mapping = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        close(fd);
+        unlink(spill_path);
+    }
+    if (mapping == MAP_FAILED) return false;
+    store.pages = static_cast<uint8_t*>(mapping);
+    store.max_pages = max_pages;
+    store.hashes.assign(1, 0);
+    store.references.assign(1, 0);
+    store.levels.assign(1, 0);
+    store.index.assign(1024, 0);
+    store.last.assign(TREE.total, 0);
+    return true;
+}
+
+StateStore::~StateStore() {
+    if (this->pages != nullptr) {
+        munmap(this->pages, this->max_pages * STATE_PAGE_SIZE);
+    }
+}
+
+size_t StateStore::find_slot(const uint8_t bytes[], uint8_t level, uint64_t hash) const {
+    const size_t mask = this->index.size() - 1;
+    for (size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+        const uint32_t id = this->index[slot];
+        if (id == 0) return slot;
+        if (this->hashes[id] == hash && this->levels[id] == level && std::memcmp(this->page(id), bytes, STATE_PAGE_SIZE) == 0) {
+            return slot;
+        }
+    }
+}
+
+void StateStore::grow_index() {
+    std::vector<uint32_t> old(this->index.size() * 2, 0);
+    old.swap(this->index);
+    const size_t mask = this->index.size() - 1;
+    for (uint32_t id : old) {
+        if (id == 0) continue;
+        size_t slot = this->hashes[id] & mask;
+        while (this->index[slot] != 0) slot = (slot + 1) & mask;
+        this->index[slot] = id;
+    }
+}
+
+uint32_t StateStore::intern(const uint8_t bytes[], uint8_t level, uint32_t guess) {
+    // a page that's still in use on the same level with the same bytes is the same page, no need to look it up.
+    if (guess != 0 && guess < this->used && this->references[guess] != 0 && this->levels[guess] == level
+        && std::memcmp(this->page(guess), bytes, STATE_PAGE_SIZE) == 0) {
+        this->references[guess] += 1;
+        return guess;
+    }
+    const uint64_t hash = page_hash(bytes, level);
+    const size_t slot = this->find_slot(bytes, level, hash);
+    uint32_t id = this->index[slot];
+    if (id != 0) {
+        this->references[id] += 1;
+        return id;
+    }
+    if (this->free_page != 0) {
+        id = this->free_page;
+        std::memcpy(&this->free_page, this->page(id), sizeof(this->free_page));
+    } else {
+        id = this->used++;
+        this->hashes.push_back(0);
+        this->references.push_back(0);
+        this->levels.push_back(0);
+    }
+    std::memcpy(this->page(id), bytes, STATE_PAGE_SIZE);
+    this->hashes[id] = hash;
+    this->references[id] = 1;
+    this->levels[id] = level;
+    this->index[slot] = id;
+    this->live += 1;
+    // keeps the index at most half full, so lookups stay short.
+    if (this->live * 2 > this->index.size()) this->grow_index();
+    return id;
+}
+
+void StateStore::release_page(uint32_t id, uint8_t level) {
+    if (--this->references[id] != 0) return;
+    if (level > 0) {
+        uint32_t children[PAGE_FANOUT];
+        std::memcpy(children, this->page(id), sizeof(children));
+        for (uint32_t child : children) {
+            if (child != 0) this->release_page(child, level - 1);
+        }
+    }
+    // removes the page from the index, moving the pages after it back into the gap so none of them gets lost behind it.
+    const size_t mask = this->index.size() - 1;
+    size_t slot = this->hashes[id] & mask;
+    while (this->index[slot] != id) slot = (slot + 1) & mask;
+    this->index[slot] = 0;
+    for (size_t next = (slot + 1) & mask; this->index[next] != 0; next = (next + 1) & mask) {
+        const size_t home = this->hashes[this->index[next]] & mask;
+        if (((next - home) & mask) >= ((next - slot) & mask)) {
+            this->index[slot] = this->index[next];
+            this->index[next] = 0;
+            slot = next;
+        }
+    }
+    std::memcpy(this->page(id), &this->free_page, sizeof(this->free_page));
+    this->free_page = id;
+    this->live -= 1;
+}
+
+StateId StateStore::put(const Core& core) {
+    uint8_t savestate[Core::SAVESTATE_SIZE];
+    core.save_state(savestate);
+    return this->put(savestate);
+}
+
+StateId StateStore::put(const uint8_t savestate[]) {
+    // a whole tree of new pages has to fit, so a put never fails halfway.
+    if (this->used + TREE.total > this->max_pages) {
+        size_t free = 0;
+        for (uint32_t id = this->free_page; id != 0 && free < TREE.total; ++free) {
+            std::memcpy(&id, this->page(id), sizeof(id));
+        }
+        if (this->max_pages - this->used + free < TREE.total) return 0;
+    }
+    uint32_t ids[(Core::SAVESTATE_SIZE + STATE_PAGE_SIZE - 1) / STATE_PAGE_SIZE];
+    uint8_t bytes[STATE_PAGE_SIZE];
+    for (size_t page = 0; page < TREE.counts[0]; ++page) {
+        const size_t at = page * STATE_PAGE_SIZE;
+        const size_t length = std::min(size_t(STATE_PAGE_SIZE), Core::SAVESTATE_SIZE - at);
+        std::memset(bytes, 0, sizeof(bytes));
+        std::memcpy(bytes, savestate + at, length);
+        ids[page] = this->intern(bytes, 0, this->last[page]);
+        this->last[page] = ids[page];
+    }
+    for (uint8_t level = 1; level <= TREE.top; ++level) {
+        const size_t children = TREE.counts[level - 1];
+        for (size_t page = 0; page < TREE.counts[level]; ++page) {
+            std::memset(bytes, 0, sizeof(bytes));
+            const size_t first = page * PAGE_FANOUT;
+            const size_t count = std::min(PAGE_FANOUT, children - first);
+            std::memcpy(bytes, ids + first, count * sizeof(uint32_t));
+            const uint32_t id = this->intern(bytes, level, this->last[TREE.offsets[level] + page]);
+            // a page of ids that was already stored already holds references to its pages, the new ones are dropped.
+            if (this->references[id] > 1) {
+                for (size_t child = first; child < first + count; ++child) this->references[ids[child]] -= 1;
+            }
+            ids[page] = id;
+            this->last[TREE.offsets[level] + page] = id;
+        }
+    }
+    this->states += 1;
+    return ids[0];
+}
+
+void StateStore::retain(StateId state) {
+    this->references[state] += 1;
+    this->states += 1;
+}
+
+void StateStore::release(StateId state) {
+    this->release_page(state, TREE.top);
+    this->states -= 1;
+}
+
+void StateStore::read(StateId state, uint8_t savestate[]) const {
+    uint32_t ids[(Core::SAVESTATE_SIZE + STATE_PAGE_SIZE - 1) / STATE_PAGE_SIZE];
+    uint32_t above[sizeof(ids) / sizeof(uint32_t)];
+    ids[0] = state;
+    // walks down the tree a level at a time, expanding every page of ids into the ids it holds.
+    for (uint8_t level = TREE.top; level > 0; --level) {
+        std::memcpy(above, ids, TREE.counts[level] * sizeof(uint32_t));
+        const size_t children = TREE.counts[level - 1];
+        for (size_t page = 0; page < TREE.counts[level]; ++page) {
+            const size_t first = page * PAGE_FANOUT;
+            const size_t count = std::min(PAGE_FANOUT, children - first);
+            std::memcpy(ids + first, this->page(above[page]), count * sizeof(uint32_t));
+        }
+    }
+    for (size_t page = 0; page < TREE.counts[0]; ++page) {
+        const size_t at = page * STATE_PAGE_SIZE;
+        std::memcpy(savestate + at, this->page(ids[page]), std::min(size_t(STATE_PAGE_SIZE), Core::SAVESTATE_SIZE - at));
+    }
+}
+
+bool StateStore::load(StateId state, Core& core) const {
+    uint8_t savestate[Core::SAVESTATE_SIZE];
+    this->read(state, savestate);
+    return core.load_state(savestate);
+}
+
+StateStoreStats StateStore::stats() const {
+    StateStoreStats stats;
+    stats.states = this->states;
+    stats.pages = this->live;
+    stats.bytes = this->live * STATE_PAGE_SIZE
+        + this->hashes.capacity() * sizeof(uint64_t) + this->references.capacity() * sizeof(uint32_t)
+        + this->levels.capacity() + this->index.capacity() * sizeof(uint32_t);
+    return stats;
+}
@@ -0,0 +1,120 @@
+// no duplicate includes.
+#pragma once
+
+// the cores whose states are stored.
+#include<core.hpp>
+
+// gives the std::vector type used for the page metadata and the index.
+#include<vector>
+
+/// a state in a `StateStore`, 0 is no state.
+using StateId = uint32_t;
+
+/// what a `StateStore` holds.
+struct StateStoreStats {
+    /// the amount of references to states, every `put` and `retain` that wasn't released yet.
+    size_t states = 0;
+    /// the amount of pages in use, both with state bytes and with the ids of other pages.
+    size_t pages = 0;
+    /// the bytes used by the pages, their metadata and the index.
+    size_t bytes = 0;
+};
+
+/// @brief stores many savestates that are mostly the same, like the states of an explorer or a rewind buffer, by
+/// @brief storing every distinct piece of them only once.
+/// @brief
+/// @brief a savestate is split into pages of `STATE_PAGE_SIZE` bytes, and every page is stored only once, looked up
+/// @brief by its hash. The ids of a state's pages are written into pages of their own, 16 ids to a page, which are
+/// @brief stored the same way, until a single page is left, whose id is the id of the state. States differing in a few
+/// @brief bytes share every page but the one holding those bytes and the pages above it, and identical states are
+/// @brief simply the same id. Pages are reference counted, releasing a state frees the pages no other state uses.
+/// @brief
+/// @brief the pages live in one memory mapping reserved up front. With a spill file the mapping is backed by that
+/// @brief file instead of memory, so the system can write pages out to disk and drop them from memory under pressure,
+/// @brief and a store can be larger than memory. A store isn't thread safe.
+struct StateStore {
+    /// the size of a page in bytes.
+    static const size_t STATE_PAGE_SIZE = 64;
+
+    /// @brief reserves a store.
+    /// @param max_pages the most pages the store holds, a state takes at most 79 new ones
+    /// @param spill_path the file the pages are mapped from, null keeps them in memory. The file is removed right away,
+    /// only the mapping uses it
+    /// @param store the created store, only valid if creating succeeds
+    /// @return whether the pages could be mapped
+    static bool create(size_t max_pages, const char* spill_path, StateStore& store);
+
+    StateStore() = default;
+    StateStore(const StateStore&) = delete;
+    StateStore& operator=(const StateStore&) = delete;
+    /// unmaps the pages.
+    ~StateStore();
+
+    /// @brief stores the state of a core.
+    /// @return the id of the state, holding a reference to it, or 0 if the store is full
+    StateId put(const Core& core);
+
+    /// @brief stores a savestate.
+    /// @param savestate a savestate, `Core::SAVESTATE_SIZE` bytes
+    /// @return the id of the state, holding a reference to it, or 0 if the store is full
+    StateId put(const uint8_t savestate[]);
+
+    /// @brief adds a reference to a stored state, to be released separately.
+    void retain(StateId state);
+
+    /// @brief drops a reference to a stored state, freeing its pages once no state uses them.
+    void release(StateId state);
+
+    /// @brief puts a core in a stored state.
+    /// @return `false` (leaving the core untouched) if the state isn't a valid savestate
+    bool load(StateId state, Core& core) const;
+
+    /// @brief copies a stored state out as a savestate.
+    /// @param savestate the destination, `Core::SAVESTATE_SIZE` bytes
+    void read(StateId state, uint8_t savestate[]) const;
+
+    /// what the store holds.
+    StateStoreStats stats() const;
+private:
+    /// @brief the bytes of a page.
+    uint8_t* page(uint32_t id) const {
+        return this->pages + size_t(id) * STATE_PAGE_SIZE;
+    }
+
+    /// @brief looks up a page with these bytes on this level of the tree, adding it if there's none.
+    /// @param guess a page that likely has the same bytes, checked before hashing
+    /// @return the id of the page, holding a new reference to it
+    uint32_t intern(const uint8_t bytes[], uint8_t level, uint32_t guess);
+
+    /// @brief drops a reference to a page on `level`, and to the pages it holds once it's freed.
+    void release_page(uint32_t id, uint8_t level);
+
+    /// @brief the slot of the index a page is in, or the free slot it would go into.
+    size_t find_slot(const uint8_t bytes[], uint8_t level, uint64_t hash) const;
+
+    /// @brief doubles the index.
+    void grow_index();
+
+    /// the mapped pages, page 0 is never used so id 0 can mean no page.
+    uint8_t* pages = nullptr;
+    /// the most pages the mapping holds.
+    size_t max_pages = 0;
+    /// the pages handed out so far, freed ones included.
+    uint32_t used = 1;
+    /// the first freed page, its first bytes hold the next, 0 if none.
+    uint32_t free_page = 0;
+    /// the amount of pages in use.
+    size_t live = 0;
+    /// the amount of references to states.
+    size_t states = 0;
+    /// the hash of every page.
+    std::vector<uint64_t> hashes;
+    /// the references to every page, from states and from the pages above it.
+    std::vector<uint32_t> references;
+    /// the level of every page in the tree, 0 for pages of state bytes.
+    std::vector<uint8_t> levels;
+    /// the ids of the pages by hash, with linear probing, 0 is an empty slot.
+    std::vector<uint32_t> index;
+    /// the pages of the last state put, for every level of its tree, which the next state most likely shares.
+    std::vector<uint32_t> last;
+};
@@ -0,0 +1,76 @@
+// the surface output declarations implemented in this file.
+#include<surface_output.hpp>
+
+// gives the std::min and std::fill_n functions.
+#include<algorithm>
+
+bool SurfaceOutput::present(const Framebuffer& fb, uint64_t dirty_rows) {
+    const int width = fb.width(), height = fb.height();
+    if (this->surface == nullptr) {
+        // (re)gets the surface, fits the frame into it with the largest integer scale and redraws everything.
+        this->surface = SDL_GetWindowSurface(this->window);
+        if (this->surface == nullptr) {
+            return false;
+        }
+        this->scale = std::max(1, std::min(this->surface->w / width, this->surface->h / height));
+        this->offset_x = std::max(0, (this->surface->w - width * this->scale) / 2);
+        this->offset_y = std::max(0, (this->surface->h - height * this->scale) / 2);
+        this->color_on = SDL_MapRGBA(this->surface->format, 0xff, 0xff, 0xff, 0xff);
+        this->color_off = SDL_MapRGBA(this->surface->format, 0x00, 0x00, 0x00, 0xff);
+        SDL_FillRect(this->surface, NULL, this->color_off);
+        dirty_rows = Framebuffer::ALL_ROWS_DIRTY;
+        this->rects.assign(1, SDL_Rect { 0, 0, this->surface->w, this->surface->h });
+    } else {
+        this->rects.clear();
+    }
+    if (dirty_rows == 0 && this->rects.empty()) {
+        return true;
+    }
+
+    SDL_LockSurface(this->surface);
+    const bool fast_path = this->surface->format->BytesPerPixel == 4;
+    const int visible_width = std::min(width * this->scale, this->surface->w - this->offset_x);
+    for (int y = 0; y < height; ++y) {
+        if (((dirty_rows >> y) & 1) == 0) {
+            continue;
+        }
+        const int top = this->offset_y + y * this->scale;
+        const int rows = std::min(this->scale, this->surface->h - top);
+        if (rows <= 0) break;
+        uint8_t* first_row = static_cast<uint8_t*>(this->surface->pixels) + top * this->surface->pitch;
+        if (fast_path) {
+            // scales the row into the surface once, then copies it for the rest of the pixel's height.
+            uint32_t* out = reinterpret_cast<uint32_t*>(first_row) + this->offset_x;
+            for (int x = 0; x < width && x * this->scale < visible_width; ++x) {
+                const int span = std::min(this->scale, visible_width - x * this->scale);
+                std::fill_n(out + x * this->scale, span, fb.pixel_status(x, y) ? this->color_on : this->color_off);
+            }
+            for (int row = 1; row < rows; ++row) {
+                std::copy_n(out, visible_width, reinterpret_cast<uint32_t*>(first_row + row * this->surface->pitch) + this->offset_x);
+            }
+        }
+        // merges the rows into the previous rectangle when they continue it, so a block of changed rows is one update.
+        SDL_Rect rect = { this->offset_x, top, visible_width, rows };
+        if (!this->rects.empty() && this->rects.back().x == rect.x && this->rects.back().y + this->rects.back().h == top) {
+            this->rects.back().h += rows;
+        } else {
+            this->rects.push_back(rect);
+        }
+    }
+    SDL_UnlockSurface(this->surface);
+    if (!fast_path) {
+        // surfaces that aren't 32 bits per pixel are rare, SDL's own fill handles their pixel layout.
+        for (int y = 0; y < height; ++y) {
+            if (((dirty_rows >> y) & 1) == 0) continue;
+            for (int x = 0; x < width; ++x) {
+                SDL_Rect pixel = { this->offset_x + x * this->scale, this->offset_y + y * this->scale, this->scale, this->scale };
+                SDL_FillRect(this->surface, &pixel, fb.pixel_status(x, y) ? this->color_on : this->color_off);
+            }
+        }
+    }
+    if (SDL_UpdateWindowSurfaceRects(this->window, this->rects.data(), this->rects.size()) != 0) {
+        this->surface = nullptr;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,43 @@
+// no duplicate includes.
+#pragma once
+
+// the framebuffer which is presented.
+#include<core.hpp>
+
+// SDL2 header for the window surface.
+#include<SDL2/SDL.h>
+
+// gives the std::vector type used for the updated rectangles.
+#include<vector>
+
+/// presents frames by writing scaled pixels straight into the window's surface, and only updating the rows that changed.
+/// when SDL falls back to software rendering, this skips the copies of the texture path (locking, copying into the
+/// texture, copying the texture to the renderer's target and presenting it). The window must not have a renderer.
+struct SurfaceOutput {
+    /// @brief creates an output for `window`, which must outlive it.
+    SurfaceOutput(SDL_Window* window) : window(window) {}
+
+    /// @brief draws the changed rows of a frame into the window surface and updates just those rows on screen.
+    /// @param fb the frame to present
+    /// @param dirty_rows the rows that changed since the previous call, see `Framebuffer::dirty_rows`
+    /// @return `false` if SDL failed to give or update the window surface
+    bool present(const Framebuffer& fb, uint64_t dirty_rows);
+
+    /// forces the next `present` to get the window surface again and redraw the whole frame, needed after the window is resized.
+    void invalidate() {
+        this->surface = nullptr;
+    }
+private:
+    /// the window presented to.
+    SDL_Window* window;
+    /// the window's surface, null until the next `present` gets it.
+    SDL_Surface* surface = nullptr;
+    /// the size of a CHIP-8 pixel on the surface.
+    int scale = 1;
+    /// the offset of the frame on the surface, which centers it.
+    int offset_x = 0, offset_y = 0;
+    /// the surface's values for on and off pixels.
+    uint32_t color_on = 0, color_off = 0;
+    /// the rectangles updated on screen, kept to avoid allocating every frame.
+    std::vector<SDL_Rect> rects;
+};
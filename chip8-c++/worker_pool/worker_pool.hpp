@@ -0,0 +1,103 @@
+// no duplicate includes.
+#pragma once
+
+// gives the threading primitives used by the worker pool.
+#include<thread>
+#include<mutex>
+#include<condition_variable>
+#include<atomic>
+#include<functional>
+#include<vector>
+
+// gives the basic integer types.
+#include<stdint.h>
+#include<stddef.h>
+
+/// a pool of threads which run a task once for every index in a range, then wait for the next range.
+/// the pool lives for the whole program, so no threads are created per frame.
+struct WorkerPool {
+    /// @brief starts `threads - 1` threads, as the thread calling `run` works as well.
+    WorkerPool(size_t threads) {
+        for (size_t thread = 1; thread < threads; ++thread) {
+            this->workers.emplace_back([this]() { this->work(); });
+        }
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    /// stops and joins every thread.
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->stopping = true;
+        }
+        this->start.notify_all();
+        for (std::thread& worker : this->workers) {
+            worker.join();
+        }
+    }
+
+    /// the amount of threads working on a `run`, including the calling thread.
+    size_t threads() const {
+        return this->workers.size() + 1;
+    }
+
+    /// @brief calls `task` with every index in `[0, count)` spread over the threads, returning when every call has finished.
+    void run(size_t count, std::function<void(size_t)> task) {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->task = std::move(task);
+            this->count = count;
+            this->next = 0;
+            this->busy = this->workers.size();
+            this->generation += 1;
+        }
+        this->start.notify_all();
+        this->take_tasks();
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->finished.wait(lock, [this]() { return this->busy == 0; });
+    }
+private:
+    /// the loop of every thread in the pool.
+    void work() {
+        uint64_t seen = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                this->start.wait(lock, [&]() { return this->stopping || this->generation != seen; });
+                if (this->stopping) return;
+                seen = this->generation;
+            }
+            this->take_tasks();
+            std::lock_guard<std::mutex> lock(this->mutex);
+            if (--this->busy == 0) this->finished.notify_one();
+        }
+    }
+
+    /// runs the task for indices until none are left.
+    void take_tasks() {
+        for (size_t index = this->next++; index < this->count; index = this->next++) {
+            this->task(index);
+        }
+    }
+
+    /// the threads of the pool, not including the thread calling `run`.
+    std::vector<std::thread> workers;
+    /// guards every member below but `next`.
+    std::mutex mutex;
+    /// `start` wakes the threads for a new run, `finished` wakes `run` when the last thread is done.
+    std::condition_variable start, finished;
+    /// the task of the current run.
+    std::function<void(size_t)> task;
+    /// the amount of indices in the current run.
+    size_t count = 0;
+    /// the next index to be taken, taken without locking.
+    std::atomic<size_t> next { 0 };
+    /// the amount of threads still working on the current run.
+    size_t busy = 0;
+    /// increases with every run, so the threads can tell a new run from a spurious wakeup.
+    uint64_t generation = 0;
+    /// tells the threads to exit.
+    bool stopping = false;
+};